@@ -1,4 +1,5 @@
 #include "app1.hh"
+#include "../../util/trace.hh"
 
 F1::F1(vector<Expr*> as) {
     a1 = (dynamic_cast<Num*>(as[0]))->value;
@@ -6,45 +7,62 @@ F1::F1(vector<Expr*> as) {
 }
 
 unique_ptr<Expr> F1::execute() {
-    cout << "Executing f1 ..." << endl;
+    TRACE(INFO, "Executing f1 ...");
     int s = a1 + a2;
     return make_unique<Num>(s);
 }
 
 unique_ptr<Expr> F2::execute() {
-    cout << "Executing f2 ..." << endl;
+    TRACE(INFO, "Executing f2 ...");
     return make_unique<Num>(0);
 }
 
 unique_ptr<Expr> GetY::execute() {
-    cout << "Executing get_y() -> " << *globalY << endl;
+    TRACE(INFO, "Executing get_y() -> " << *globalY);
     return make_unique<Num>(*globalY);
 }
 
 unique_ptr<Expr> SetY::execute() {
-    cout << "Executing set_y(" << value << ")" << endl;
+    TRACE(INFO, "Executing set_y(" << value << ")");
     *globalY = value;
     return make_unique<Num>(value);
 }
 
+App1FunctionFactory::App1FunctionFactory() : globalY(0) {
+    bind("f1", Api::F1);
+    bind("f2", Api::F2);
+    bind("get_y", Api::GET_Y);
+    bind("set_y", Api::SET_Y);
+}
+
+void App1FunctionFactory::bind(const string& fname, Api api) {
+    ApiId id = ApiRegistry::intern(fname);
+    if(id >= apiById.size()) {
+        apiById.resize(id + 1, Api::UNKNOWN);
+    }
+    apiById[id] = api;
+}
+
 unique_ptr<Function> App1FunctionFactory::getFunction(string fname, vector<Expr*> args) {
-    if(fname == "f1") {
+    return getFunction(ApiRegistry::intern(fname), args);
+}
+
+unique_ptr<Function> App1FunctionFactory::getFunction(ApiId id, vector<Expr*> args) {
+    Api api = id < apiById.size() ? apiById[id] : Api::UNKNOWN;
+    switch(api) {
+    case Api::F1:
         return make_unique<F1>(args);
-    }
-    else if(fname == "f2") {
+    case Api::F2:
         return make_unique<F2>();
-    }
-    else if(fname == "get_y") {
+    case Api::GET_Y:
         return make_unique<GetY>(&globalY);
-    }
-    else if(fname == "set_y") {
+    case Api::SET_Y:
         if(args.size() >= 1) {
             int val = (dynamic_cast<Num*>(args[0]))->value;
             return make_unique<SetY>(&globalY, val);
         }
         throw "set_y requires 1 argument!";
-    }
-    else {
+    default:
         throw "Unknown function!";
     }
 }
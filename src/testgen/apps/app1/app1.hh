@@ -40,8 +40,15 @@ public:
 
 class App1FunctionFactory : public FunctionFactory {
 private:
-  int globalY; // Global state variable
+  enum class Api { UNKNOWN, F1, F2, GET_Y, SET_Y };
+
+  int globalY;          // Global state variable
+  vector<Api> apiById;  // indexed by ApiId
+
+  void bind(const string &fname, Api api);
+
 public:
-  App1FunctionFactory() : globalY(0) {}
+  App1FunctionFactory();
   unique_ptr<Function> getFunction(string fname, vector<Expr *> args);
+  unique_ptr<Function> getFunction(ApiId id, vector<Expr *> args);
 };
@@ -0,0 +1,155 @@
+// Replay benchmark: re-solves the queries captured by a QueryLog (testgen
+// --dump-queries=<dir>) under several solver configurations and reports the
+// latency percentiles of each, next to the ones of the captured run.
+#include "see/portfolio.hh"
+#include "see/querylog.hh"
+#include "see/z3pool.hh"
+#include "see/z3solver.hh"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Nearest-rank percentile of sorted latencies
+static double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t rank = static_cast<size_t>(p / 100 * sorted.size() + 0.999999);
+  return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+static void printRow(const std::string &name, const unsigned int counts[4],
+                     std::vector<double> times) {
+  std::sort(times.begin(), times.end());
+  double total = 0;
+  for (double t : times) {
+    total += t;
+  }
+  char line[200];
+  snprintf(line, sizeof(line),
+           "%-12s %5u %5u %5u %5u %9.3f %9.3f %9.3f %9.3f %9.3f",
+           name.c_str(), counts[0], counts[1], counts[2], counts[3],
+           times.empty() ? 0 : total / times.size(), percentile(times, 50),
+           percentile(times, 90), percentile(times, 99),
+           times.empty() ? 0 : times.back());
+  std::cout << line << std::endl;
+}
+
+static SolverStatus replay(const CapturedQuery &query,
+                           const PortfolioConfig &config,
+                           const SolverBudget &budget, double &timeMs) {
+  // The lease must outlive every Z3 object of the query
+  Z3ContextPool::Lease lease = Z3ContextPool::getInstance().acquire();
+  z3::context &ctx = lease->getContext();
+  z3::expr_vector assertions = ctx.parse_file(query.path.c_str());
+  z3::solver s = config.tactic.empty()
+                     ? z3::solver(ctx)
+                     : z3::tactic(ctx, config.tactic.c_str()).mk_solver();
+  z3::params params(ctx);
+  params.set("random_seed", config.seed);
+  s.set(params);
+  for (unsigned int i = 0; i < assertions.size(); i++) {
+    s.add(assertions[i]);
+  }
+  auto start = std::chrono::steady_clock::now();
+  SolverStatus status = checkWithBudget(s, *lease, budget, 0);
+  timeMs = std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+               .count();
+  return status;
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> paths;
+  std::vector<std::string> names;
+  SolverBudget budget;
+  unsigned int repeat = 1;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.rfind("--configs=", 0) == 0) {
+      std::istringstream list(arg.substr(10));
+      std::string name;
+      while (std::getline(list, name, ',')) {
+        names.push_back(name);
+      }
+    } else if (arg.rfind("--timeout=", 0) == 0) {
+      budget.queryTimeoutMs = std::stoul(arg.substr(10));
+    } else if (arg.rfind("--repeat=", 0) == 0) {
+      repeat = std::max(1ul, std::stoul(arg.substr(9)));
+    } else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return 1;
+    } else {
+      paths.push_back(arg);
+    }
+  }
+  if (paths.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " <query dir or .smt2 file>... [--configs=<name>,...]"
+                 " [--timeout=<ms>] [--repeat=<n>]"
+              << std::endl;
+    return 1;
+  }
+
+  // The configurations are the ones of the portfolio solver
+  std::vector<PortfolioConfig> configs;
+  for (const PortfolioConfig &config : PortfolioSolver::getDefaultConfigs()) {
+    if (names.empty() ||
+        std::find(names.begin(), names.end(), config.name) != names.end()) {
+      configs.push_back(config);
+    }
+  }
+  if (configs.empty()) {
+    std::cerr << "No such configuration" << std::endl;
+    return 1;
+  }
+
+  std::vector<CapturedQuery> queries = QueryLog::collect(paths);
+  std::cout << "Replaying " << queries.size() << " query(ies), " << repeat
+            << " time(s) each" << std::endl;
+  std::cout << "config         sat unsat  unkn  tout   mean ms    p50 ms"
+               "    p90 ms    p99 ms    max ms"
+            << std::endl;
+
+  auto index = [](SolverStatus status) { return static_cast<int>(status); };
+  unsigned int captured[4] = {0, 0, 0, 0};
+  std::vector<double> capturedTimes;
+  for (const CapturedQuery &query : queries) {
+    captured[index(query.status)]++;
+    capturedTimes.push_back(query.timeMs);
+  }
+  printRow("captured", captured, capturedTimes);
+
+  // A decided answer that contradicts the captured one points at a solver
+  // bug, or at a query that did not survive the round trip
+  unsigned int mismatches = 0;
+  for (const PortfolioConfig &config : configs) {
+    unsigned int counts[4] = {0, 0, 0, 0};
+    std::vector<double> times;
+    for (const CapturedQuery &query : queries) {
+      for (unsigned int r = 0; r < repeat; r++) {
+        double timeMs;
+        SolverStatus status = replay(query, config, budget, timeMs);
+        counts[index(status)]++;
+        times.push_back(timeMs);
+        bool decided =
+            status == SolverStatus::SAT || status == SolverStatus::UNSAT;
+        bool capturedDecided = query.status == SolverStatus::SAT ||
+                               query.status == SolverStatus::UNSAT;
+        if (decided && capturedDecided && status != query.status) {
+          std::cerr << query.path << ": " << config.name << " says "
+                    << statusName(status) << ", captured "
+                    << statusName(query.status) << std::endl;
+          mismatches++;
+        }
+      }
+    }
+    printRow(config.name, counts, times);
+  }
+  return mismatches == 0 ? 0 : 2;
+}
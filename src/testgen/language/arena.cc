@@ -0,0 +1,30 @@
+#include "arena.hh"
+
+ExprArena::ExprArena() : bytesUsed(0) {}
+
+ExprArena::~ExprArena() {
+  // Parents may refer to children, so destroy the newest nodes first
+  for (auto it = objects.rbegin(); it != objects.rend(); ++it) {
+    (*it)->~Expr();
+  }
+}
+
+void *ExprArena::allocate(size_t size, size_t align) {
+  if (!blocks.empty()) {
+    Block &block = blocks.back();
+    size_t offset = (block.used + align - 1) & ~(align - 1);
+    if (offset + size <= block.size) {
+      block.used = offset + size;
+      bytesUsed += size;
+      return block.data.get() + offset;
+    }
+  }
+
+  // Start a new block; oversized nodes get a block of their own. The block
+  // memory comes from operator new[] and is aligned for any scalar type.
+  size_t blockSize = size > BLOCK_SIZE ? size : BLOCK_SIZE;
+  blocks.push_back(Block{unique_ptr<char[]>(new char[blockSize]), blockSize,
+                         size});
+  bytesUsed += size;
+  return blocks.back().data.get();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "ast.hh"
+
+using namespace std;
+
+/**
+ * ExprArena: region allocator for expression nodes
+ *
+ * Nodes are placement-constructed into large blocks by bumping a pointer and
+ * are all destroyed together when the arena is destroyed. There is no way to
+ * free a single node. Used by ExprFactory so that the expressions of one
+ * symbolic execution session cost one allocation per block instead of one
+ * per node, and are released in one shot at the end of the session.
+ */
+class ExprArena {
+private:
+  struct Block {
+    unique_ptr<char[]> data;
+    size_t size;
+    size_t used;
+  };
+
+  vector<Block> blocks;
+  vector<Expr *> objects; // constructed nodes, destroyed in reverse order
+  size_t bytesUsed;
+
+  void *allocate(size_t size, size_t align);
+
+public:
+  static const size_t BLOCK_SIZE = 64 * 1024;
+
+  ExprArena();
+  ExprArena(const ExprArena &) = delete;
+  ExprArena &operator=(const ExprArena &) = delete;
+  ~ExprArena();
+
+  template <typename T, typename... Args> T *make(Args &&...args) {
+    void *memory = allocate(sizeof(T), alignof(T));
+    T *node = new (memory) T(std::forward<Args>(args)...);
+    objects.push_back(node);
+    return node;
+  }
+
+  // Statistics
+  size_t getNumNodes() const { return objects.size(); }
+  size_t getNumBlocks() const { return blocks.size(); }
+  size_t getBytesUsed() const { return bytesUsed; }
+};
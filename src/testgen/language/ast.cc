@@ -163,6 +163,14 @@ bool SetType::isEqual(const TypeExpr &other) const {
 // --- Base class for Expressions ---
 Expr::Expr(ExprType exprType) : exprType(exprType) {}
 
+// Take over uniquely owned children as shared ones
+static std::vector<std::shared_ptr<Expr>>
+toShared(std::vector<std::unique_ptr<Expr>> exprs) {
+  return std::vector<std::shared_ptr<Expr>>(
+      std::make_move_iterator(exprs.begin()),
+      std::make_move_iterator(exprs.end()));
+}
+
 // --- Atomic / Constant Expressions ---
 Bool::Bool(bool value) : Expr(ExprType::BOOL), value(value) {
   // throw std::runtime_error("Bool constructor called");
@@ -204,6 +212,9 @@ bool Var::operator<(const Var &v) const { return name < v.name; }
 // --- Collections ---
 // --- Set ---
 Set::Set(std::vector<std::unique_ptr<Expr>> elements)
+    : Expr(ExprType::SET), elements(toShared(std::move(elements))) {}
+
+Set::Set(std::vector<std::shared_ptr<Expr>> elements)
     : Expr(ExprType::SET), elements(std::move(elements)) {}
 
 std::string Set::toString() const {
@@ -228,7 +239,22 @@ std::unique_ptr<Expr> Set::clone() {
 }
 
 // --- Map ---
+// Take over uniquely owned values as shared ones
+static std::vector<std::pair<std::unique_ptr<Var>, std::shared_ptr<Expr>>>
+toShared(
+    std::vector<std::pair<std::unique_ptr<Var>, std::unique_ptr<Expr>>> v) {
+  std::vector<std::pair<std::unique_ptr<Var>, std::shared_ptr<Expr>>> result;
+  for (auto &pair : v) {
+    result.push_back(
+        std::make_pair(std::move(pair.first), std::move(pair.second)));
+  }
+  return result;
+}
+
 Map::Map(std::vector<std::pair<std::unique_ptr<Var>, std::unique_ptr<Expr>>> v)
+    : Expr(ExprType::MAP), value(toShared(std::move(v))) {}
+
+Map::Map(std::vector<std::pair<std::unique_ptr<Var>, std::shared_ptr<Expr>>> v)
     : Expr(ExprType::MAP), value(std::move(v)) {}
 
 std::string Map::toString() const {
@@ -289,6 +315,9 @@ std::unique_ptr<Expr> Map::clone() {
 
 // --- Tuple ---
 Tuple::Tuple(std::vector<std::unique_ptr<Expr>> exprs)
+    : Expr(ExprType::TUPLE), exprs(toShared(std::move(exprs))) {}
+
+Tuple::Tuple(std::vector<std::shared_ptr<Expr>> exprs)
     : Expr(ExprType::TUPLE), exprs(std::move(exprs)) {}
 
 std::string Tuple::toString() const {
@@ -306,8 +335,8 @@ std::string Tuple::toString() const {
 
 std::unique_ptr<Expr> Tuple::clone() {
   std::vector<std::unique_ptr<Expr>> clonedExprs;
-  for (const auto &expr : exprs) {
-    clonedExprs.push_back(expr->clone());
+  for (const auto &e : exprs) {
+    clonedExprs.push_back(e->clone());
   }
   return std::make_unique<Tuple>(std::move(clonedExprs));
 }
@@ -315,7 +344,20 @@ std::unique_ptr<Expr> Tuple::clone() {
 // --- Function Calls ---
 FuncCall::FuncCall(std::string name, std::vector<std::unique_ptr<Expr>> args)
     : Expr(ExprType::FUNC_CALL_EXPR), name(std::move(name)),
-      args(std::move(args)) {}
+      args(toShared(std::move(args))), op(OpcodeTable::lookup(this->name)),
+      apiId(op == Opcode::API ? ApiRegistry::intern(this->name)
+                              : NO_API_ID) {}
+
+FuncCall::FuncCall(std::string name, std::vector<std::shared_ptr<Expr>> args)
+    : Expr(ExprType::FUNC_CALL_EXPR), name(std::move(name)),
+      args(std::move(args)), op(OpcodeTable::lookup(this->name)),
+      apiId(op == Opcode::API ? ApiRegistry::intern(this->name)
+                              : NO_API_ID) {}
+
+FuncCall::FuncCall(std::string name, Opcode op, ApiId apiId,
+                   std::vector<std::shared_ptr<Expr>> args)
+    : Expr(ExprType::FUNC_CALL_EXPR), name(std::move(name)),
+      args(std::move(args)), op(op), apiId(apiId) {}
 
 std::string FuncCall::toString() const {
   std::ostringstream ss;
@@ -5,6 +5,8 @@
 #include <utility>
 #include <vector>
 
+#include "opcode.hh"
+
 // ================================================================================
 // Enumerations for AST nodes
 // ================================================================================
@@ -135,6 +137,10 @@ public:
 // ================================================================================
 
 // --- Base class for Expressions ---
+// Expressions are immutable once built. Children of compound expressions are
+// held through shared_ptr so that a subterm can be shared between several
+// parents (see ExprFactory). clone() is a deep copy that owns all its nodes:
+// the children of a factory's nodes live in its arena and are gone with it.
 class Expr {
 public:
   ExprType exprType;
@@ -202,10 +208,11 @@ public:
 // --- Set ---
 class Set : public Expr {
 public:
-  const std::vector<std::unique_ptr<Expr>> elements;
+  const std::vector<std::shared_ptr<Expr>> elements;
 
 public:
   explicit Set(std::vector<std::unique_ptr<Expr>>);
+  explicit Set(std::vector<std::shared_ptr<Expr>>);
   virtual std::string toString() const;
   virtual std::unique_ptr<Expr> clone();
 };
@@ -213,12 +220,14 @@ public:
 // --- Map ---
 class Map : public Expr {
 public:
-  const std::vector<std::pair<std::unique_ptr<Var>, std::unique_ptr<Expr>>>
+  const std::vector<std::pair<std::unique_ptr<Var>, std::shared_ptr<Expr>>>
       value;
 
 public:
   explicit Map(
       std::vector<std::pair<std::unique_ptr<Var>, std::unique_ptr<Expr>>>);
+  explicit Map(
+      std::vector<std::pair<std::unique_ptr<Var>, std::shared_ptr<Expr>>>);
   virtual std::string toString() const;
   virtual std::unique_ptr<Expr> clone();
 };
@@ -249,10 +258,11 @@ public:
 // --- Tuples ---
 class Tuple : public Expr {
 public:
-  const std::vector<std::unique_ptr<Expr>> exprs;
+  const std::vector<std::shared_ptr<Expr>> exprs;
 
 public:
   explicit Tuple(std::vector<std::unique_ptr<Expr>> exprs);
+  explicit Tuple(std::vector<std::shared_ptr<Expr>> exprs);
   virtual std::string toString() const;
   virtual std::unique_ptr<Expr> clone();
 };
@@ -261,10 +271,18 @@ public:
 class FuncCall : public Expr {
 public:
   const std::string name;
-  const std::vector<std::unique_ptr<Expr>> args;
+  const std::vector<std::shared_ptr<Expr>> args;
+  // Resolved from name when the node is built: the built-in operator, or
+  // Opcode::API and the interned ID of the API function (NO_API_ID otherwise)
+  const Opcode op;
+  const ApiId apiId;
 
 public:
   FuncCall(std::string, std::vector<std::unique_ptr<Expr>>);
+  FuncCall(std::string, std::vector<std::shared_ptr<Expr>>);
+  // With op and apiId resolved already, e.g. those of another call of the
+  // same function
+  FuncCall(std::string, Opcode, ApiId, std::vector<std::shared_ptr<Expr>>);
   virtual std::string toString() const;
   virtual std::unique_ptr<Expr> clone();
 };
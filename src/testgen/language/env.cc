@@ -71,75 +71,28 @@ void SymbolTable::print() {
   }
 }
 
-// ValueEnvironment implementation
-ValueEnvironment::ValueEnvironment(ValueEnvironment *p) : Env(p) {}
-
-string ValueEnvironment::keyToString(string *key) { return *key; }
-
-void ValueEnvironment::print() {
-  std::cout << "Value Environment:" << std::endl;
-  for (auto &d : table) {
-    std::cout << "  " << d.first << " -> ";
-    if (d.second) {
-      // Print expression type or value
-      if (d.second->exprType == ExprType::NUM) {
-        Num *num = dynamic_cast<Num *>(d.second);
-        std::cout << num->value;
-      } else if (d.second->exprType == ExprType::SYMVAR) {
-        std::cout << "SymVar";
-      } else if (d.second->exprType == ExprType::FUNC_CALL_EXPR) {
-        FuncCall *fc = dynamic_cast<FuncCall *>(d.second);
-        std::cout << fc->name << "(...)";
-      } else {
-        std::cout << "Expr";
-      }
-    } else {
-      std::cout << "null";
-    }
-    std::cout << std::endl;
-  }
-}
-
-void ValueEnvironment::setValue(const string &varName, Expr *value) {
-  // For value environment, we allow updating existing values (unlike
-  // SymbolTable)
-  table[varName] = value;
-}
-
-Expr *ValueEnvironment::getValue(const string &varName) {
-  if (table.find(varName) != table.end()) {
-    return table[varName];
-  }
-  if (parent != nullptr) {
-    ValueEnvironment *parentEnv = dynamic_cast<ValueEnvironment *>(parent);
-    if (parentEnv) {
-      return parentEnv->getValue(varName);
+// PersistentEnv implementation
+Expr *PersistentEnv::getValue(const string &varName) const {
+  for (const PersistentEnv *env = this; env != nullptr; env = env->parent) {
+    if (Expr *const *value = env->values.find(varName)) {
+      return *value;
     }
   }
   return nullptr;
 }
 
-bool ValueEnvironment::hasValue(const string &varName) {
-  if (table.find(varName) != table.end()) {
-    return true;
-  }
-  if (parent != nullptr) {
-    ValueEnvironment *parentEnv = dynamic_cast<ValueEnvironment *>(parent);
-    if (parentEnv) {
-      return parentEnv->hasValue(varName);
+bool PersistentEnv::hasValue(const string &varName) const {
+  for (const PersistentEnv *env = this; env != nullptr; env = env->parent) {
+    if (env->values.contains(varName)) {
+      return true;
     }
   }
   return false;
 }
 
-// ConcValEnv implementation
-ConcValEnv::ConcValEnv(ConcValEnv *p) : Env(p) {}
-
-string ConcValEnv::keyToString(string *key) { return *key; }
-
-void ConcValEnv::print() {
-  std::cout << "Value Environment:" << std::endl;
-  for (auto &d : table) {
+void PersistentEnv::printBindings(const string &title) const {
+  std::cout << title << ":" << std::endl;
+  for (const auto &d : values.entries()) {
     std::cout << "  " << d.first << " -> ";
     if (d.second) {
       // Print expression type or value
@@ -161,37 +114,15 @@ void ConcValEnv::print() {
   }
 }
 
-void ConcValEnv::setValue(const string &varName, Expr *value) {
-  // For value environment, we allow updating existing values (unlike
-  // SymbolTable)
-  table[varName] = value;
-}
+// ValueEnvironment implementation
+ValueEnvironment::ValueEnvironment(ValueEnvironment *p) : PersistentEnv(p) {}
 
-Expr *ConcValEnv::getValue(const string &varName) {
-  if (table.find(varName) != table.end()) {
-    return table[varName];
-  }
-  if (parent != nullptr) {
-    ConcValEnv *parentEnv = dynamic_cast<ConcValEnv *>(parent);
-    if (parentEnv) {
-      return parentEnv->getValue(varName);
-    }
-  }
-  return nullptr;
-}
+void ValueEnvironment::print() { printBindings("Value Environment"); }
 
-bool ConcValEnv::hasValue(const string &varName) {
-  if (table.find(varName) != table.end()) {
-    return true;
-  }
-  if (parent != nullptr) {
-    ConcValEnv *parentEnv = dynamic_cast<ConcValEnv *>(parent);
-    if (parentEnv) {
-      return parentEnv->hasValue(varName);
-    }
-  }
-  return false;
-}
+// ConcValEnv implementation
+ConcValEnv::ConcValEnv(ConcValEnv *p) : PersistentEnv(p) {}
+
+void ConcValEnv::print() { printBindings("Value Environment"); }
 
 // Explicit template instantiation for TypeMap
 template class Env<string, TypeExpr>;
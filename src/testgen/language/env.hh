@@ -3,6 +3,7 @@
 #include <string>
 
 #include "ast.hh"
+#include "pmap.hh"
 
 using namespace std;
 template <typename T1, typename T2> class Env {
@@ -39,33 +40,54 @@ public:
   virtual ~SymbolTable();
 };
 
+// PersistentEnv: maps variable names to values (Expr*) in a PersistentMap,
+// in front of an optional parent environment. Copying an environment is an
+// O(1) snapshot that shares every binding with the original; setValue()
+// only copies the O(log n) trie nodes on the way to the name. Lookups that
+// miss go on to the parent.
+class PersistentEnv {
+protected:
+  PersistentMap<Expr *> values;
+  const PersistentEnv *parent;
+
+  void printBindings(const string &title) const;
+
+public:
+  PersistentEnv(const PersistentEnv *parent) : parent(parent) {}
+  virtual ~PersistentEnv() = default;
+  virtual void print() = 0;
+
+  // Bindings may be updated, unlike declarations in a SymbolTable
+  void setValue(const string &varName, Expr *value) {
+    values.set(varName, value);
+  }
+  Expr *getValue(const string &varName) const;
+  bool hasValue(const string &varName) const;
+  // Drops the bindings of this environment, not the parent's
+  void clear() { values.clear(); }
+  // Bindings of this environment, not the parent's, ordered by name
+  vector<pair<string, Expr *>> getBindings() const { return values.entries(); }
+  size_t size() const { return values.size(); }
+  // Whether neither environment has been updated since one was copied from
+  // the other
+  bool sharesBindings(const PersistentEnv &other) const {
+    return values.sameVersion(other.values);
+  }
+};
+
 // ValueEnvironment: maps variable names (strings) to their symbolic/concrete
 // values (Expr*) Used during symbolic execution to track the value of each
 // variable
-class ValueEnvironment : public Env<string, Expr> {
+class ValueEnvironment : public PersistentEnv {
 public:
   ValueEnvironment(ValueEnvironment *parent = nullptr);
   virtual void print();
-  virtual string keyToString(string *);
-
-  // Value environment methods
-  void setValue(const string &varName, Expr *value);
-  Expr *getValue(const string &varName);
-  bool hasValue(const string &varName);
-  map<string, Expr *> &getTable() { return table; }
 };
 
 // ConcValEnv: maps variable names (strings) to their symbolic/concrete values
 // (Expr*) Used during symbolic execution to track the value of each variable
-class ConcValEnv : public Env<string, Expr> {
+class ConcValEnv : public PersistentEnv {
 public:
   ConcValEnv(ConcValEnv *parent = nullptr);
   virtual void print();
-  virtual string keyToString(string *);
-
-  // Value environment methods
-  void setValue(const string &varName, Expr *value);
-  Expr *getValue(const string &varName);
-  bool hasValue(const string &varName);
-  map<string, Expr *> &getTable() { return table; }
 };
@@ -0,0 +1,268 @@
+#include "exprfactory.hh"
+#include <functional>
+#include <stdexcept>
+
+// ============================================================================
+// Unique table
+// ============================================================================
+
+bool ExprFactory::Key::operator==(const Key &other) const {
+  return type == other.type && payload == other.payload &&
+         text == other.text && children == other.children;
+}
+
+size_t ExprFactory::KeyHash::operator()(const Key &key) const {
+  size_t h = hash<int>()(static_cast<int>(key.type));
+  auto combine = [&h](size_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  };
+  combine(hash<long long>()(key.payload));
+  combine(hash<string>()(key.text));
+  for (const Expr *child : key.children) {
+    combine(hash<const Expr *>()(child));
+  }
+  return h;
+}
+
+ExprFactory::ExprFactory() : hits(0), misses(0) {}
+
+Expr *ExprFactory::lookup(const Key &key) {
+  auto it = table.find(key);
+  if (it == table.end()) {
+    misses++;
+    return nullptr;
+  }
+  hits++;
+  return it->second;
+}
+
+// Built-ins are keyed by their opcode, so that every spelling of one ("eq",
+// "Eq", "=") gives the same node, named as it was first built. An API
+// function has a single spelling.
+ExprFactory::Key ExprFactory::funcCallKey(Opcode op, const string &name,
+                                          const vector<Expr *> &args) {
+  return Key{ExprType::FUNC_CALL_EXPR, static_cast<long long>(op),
+             op == Opcode::API ? name : "",
+             vector<const Expr *>(args.begin(), args.end())};
+}
+
+vector<shared_ptr<Expr>> ExprFactory::share(const vector<Expr *> &exprs) {
+  vector<shared_ptr<Expr>> result;
+  for (Expr *e : exprs) {
+    if (!isCanonical(e)) {
+      throw runtime_error("ExprFactory: child expression is not canonical");
+    }
+    // The arena owns the child; the handle only aliases it and does not
+    // allocate a control block
+    result.push_back(shared_ptr<Expr>(shared_ptr<Expr>(), e));
+  }
+  return result;
+}
+
+// ============================================================================
+// Constructors
+// ============================================================================
+
+Num *ExprFactory::num(int value) {
+  Key key{ExprType::NUM, value, "", {}};
+  if (Expr *e = lookup(key)) {
+    return static_cast<Num *>(e);
+  }
+  return insert(std::move(key), arena.make<Num>(value));
+}
+
+Bool *ExprFactory::boolean(bool value) {
+  Key key{ExprType::BOOL, value ? 1 : 0, "", {}};
+  if (Expr *e = lookup(key)) {
+    return static_cast<Bool *>(e);
+  }
+  return insert(std::move(key), arena.make<Bool>(value));
+}
+
+String *ExprFactory::str(const string &value) {
+  Key key{ExprType::STRING, 0, value, {}};
+  if (Expr *e = lookup(key)) {
+    return static_cast<String *>(e);
+  }
+  return insert(std::move(key), arena.make<String>(value));
+}
+
+Var *ExprFactory::var(const string &name) {
+  Key key{ExprType::VAR, 0, name, {}};
+  if (Expr *e = lookup(key)) {
+    return static_cast<Var *>(e);
+  }
+  return insert(std::move(key), arena.make<Var>(name));
+}
+
+SymVar *ExprFactory::symVar(unsigned int num) {
+  Key key{ExprType::SYMVAR, num, "", {}};
+  if (Expr *e = lookup(key)) {
+    return static_cast<SymVar *>(e);
+  }
+  return insert(std::move(key), arena.make<SymVar>(num));
+}
+
+FuncCall *ExprFactory::funcCall(const string &name,
+                                const vector<Expr *> &args) {
+  Opcode op = OpcodeTable::lookup(name);
+  Key key = funcCallKey(op, name, args);
+  if (Expr *e = lookup(key)) {
+    return static_cast<FuncCall *>(e);
+  }
+  return insert(std::move(key), arena.make<FuncCall>(name, share(args)));
+}
+
+FuncCall *ExprFactory::funcCall(Opcode op, ApiId apiId, const string &name,
+                                const vector<Expr *> &args) {
+  Key key = funcCallKey(op, name, args);
+  if (Expr *e = lookup(key)) {
+    return static_cast<FuncCall *>(e);
+  }
+  return insert(std::move(key),
+                arena.make<FuncCall>(name, op, apiId, share(args)));
+}
+
+Set *ExprFactory::set(const vector<Expr *> &elements) {
+  Key key{ExprType::SET, 0, "",
+          vector<const Expr *>(elements.begin(), elements.end())};
+  if (Expr *e = lookup(key)) {
+    return static_cast<Set *>(e);
+  }
+  return insert(std::move(key), arena.make<Set>(share(elements)));
+}
+
+Tuple *ExprFactory::tuple(const vector<Expr *> &exprs) {
+  Key key{ExprType::TUPLE, 0, "",
+          vector<const Expr *>(exprs.begin(), exprs.end())};
+  if (Expr *e = lookup(key)) {
+    return static_cast<Tuple *>(e);
+  }
+  return insert(std::move(key), arena.make<Tuple>(share(exprs)));
+}
+
+Map *ExprFactory::map(const vector<pair<string, Expr *>> &entries) {
+  // Keys are identified by their canonical Var, so that they take part in
+  // the child comparison like the values do
+  Key key{ExprType::MAP, 0, "", {}};
+  vector<Expr *> values;
+  for (const auto &entry : entries) {
+    key.children.push_back(var(entry.first));
+    key.children.push_back(entry.second);
+    values.push_back(entry.second);
+  }
+  if (Expr *e = lookup(key)) {
+    return static_cast<Map *>(e);
+  }
+
+  vector<shared_ptr<Expr>> sharedValues = share(values);
+  vector<pair<unique_ptr<Var>, shared_ptr<Expr>>> value;
+  for (size_t i = 0; i < entries.size(); i++) {
+    value.push_back(
+        make_pair(make_unique<Var>(entries[i].first), sharedValues[i]));
+  }
+  return insert(std::move(key), arena.make<Map>(std::move(value)));
+}
+
+// ============================================================================
+// Interning
+// ============================================================================
+
+bool ExprFactory::isCanonical(const Expr *expr) const {
+  return nodes.find(expr) != nodes.end();
+}
+
+Expr *ExprFactory::intern(Expr &expr) {
+  if (isCanonical(&expr)) {
+    return &expr;
+  }
+
+  switch (expr.exprType) {
+  case ExprType::NUM:
+    return num(dynamic_cast<Num &>(expr).value);
+  case ExprType::BOOL:
+    return boolean(dynamic_cast<Bool &>(expr).value);
+  case ExprType::STRING:
+    return str(dynamic_cast<String &>(expr).value);
+  case ExprType::VAR:
+    return var(dynamic_cast<Var &>(expr).name);
+  case ExprType::SYMVAR:
+    return symVar(dynamic_cast<SymVar &>(expr).getNum());
+  case ExprType::FUNC_CALL_EXPR: {
+    FuncCall &fc = dynamic_cast<FuncCall &>(expr);
+    vector<Expr *> args;
+    for (const auto &arg : fc.args) {
+      args.push_back(intern(*arg));
+    }
+    return funcCall(fc.op, fc.apiId, fc.name, args);
+  }
+  case ExprType::SET: {
+    Set &s = dynamic_cast<Set &>(expr);
+    vector<Expr *> elements;
+    for (const auto &elem : s.elements) {
+      elements.push_back(intern(*elem));
+    }
+    return set(elements);
+  }
+  case ExprType::TUPLE: {
+    Tuple &t = dynamic_cast<Tuple &>(expr);
+    vector<Expr *> exprs;
+    for (const auto &e : t.exprs) {
+      exprs.push_back(intern(*e));
+    }
+    return tuple(exprs);
+  }
+  case ExprType::MAP: {
+    Map &m = dynamic_cast<Map &>(expr);
+    vector<pair<string, Expr *>> entries;
+    for (const auto &kv : m.value) {
+      entries.push_back(make_pair(kv.first->name, intern(*kv.second)));
+    }
+    return map(entries);
+  }
+  default:
+    throw runtime_error("ExprFactory: cannot intern expression " +
+                        expr.toString());
+  }
+}
+
+unique_ptr<Expr> ExprFactory::detach(const Expr &expr) {
+  switch (expr.exprType) {
+  case ExprType::FUNC_CALL_EXPR: {
+    const FuncCall &fc = dynamic_cast<const FuncCall &>(expr);
+    vector<unique_ptr<Expr>> args;
+    for (const auto &arg : fc.args) {
+      args.push_back(detach(*arg));
+    }
+    return make_unique<FuncCall>(fc.name, std::move(args));
+  }
+  case ExprType::SET: {
+    const Set &s = dynamic_cast<const Set &>(expr);
+    vector<unique_ptr<Expr>> elements;
+    for (const auto &elem : s.elements) {
+      elements.push_back(detach(*elem));
+    }
+    return make_unique<Set>(std::move(elements));
+  }
+  case ExprType::TUPLE: {
+    const Tuple &t = dynamic_cast<const Tuple &>(expr);
+    vector<unique_ptr<Expr>> exprs;
+    for (const auto &e : t.exprs) {
+      exprs.push_back(detach(*e));
+    }
+    return make_unique<Tuple>(std::move(exprs));
+  }
+  case ExprType::MAP: {
+    const Map &m = dynamic_cast<const Map &>(expr);
+    vector<pair<unique_ptr<Var>, unique_ptr<Expr>>> value;
+    for (const auto &kv : m.value) {
+      value.push_back(
+          make_pair(make_unique<Var>(kv.first->name), detach(*kv.second)));
+    }
+    return make_unique<Map>(std::move(value));
+  }
+  default:
+    // Leaves have no children to share
+    return const_cast<Expr &>(expr).clone();
+  }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "arena.hh"
+#include "ast.hh"
+#include "symvar.hh"
+
+using namespace std;
+
+/**
+ * ExprFactory: hash-consing constructor for expressions
+ *
+ * Every expression built through a factory is looked up in a unique table
+ * keyed by its node type, payload and (already canonical) children, so that
+ * structurally equal expressions built by the same factory are the same
+ * object. Two canonical expressions are equal iff their pointers are equal,
+ * and a subterm shared by many path constraints is stored once.
+ *
+ * The nodes live in the factory's ExprArena and are all freed together when
+ * the factory is destroyed, so a factory is the memory scope of one symbolic
+ * execution session. Pointers it returns, including the children of canonical
+ * nodes, stay valid only as long as the factory lives, and must not be
+ * deleted by the caller. Use detach() for a copy that outlives the factory.
+ */
+class ExprFactory {
+private:
+  struct Key {
+    ExprType type;
+    long long payload;             // Num/Bool value, SymVar number, Opcode
+    string text;                   // String value, Var or API function name
+    vector<const Expr *> children; // canonical children; Map: key, value, ...
+
+    bool operator==(const Key &other) const;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  ExprArena arena;
+  unordered_map<Key, Expr *, KeyHash> table;
+  unordered_set<const Expr *> nodes;
+  unsigned int hits;
+  unsigned int misses;
+
+  Expr *lookup(const Key &key);
+  template <typename T> T *insert(Key key, T *node) {
+    nodes.insert(node);
+    table.emplace(std::move(key), node);
+    return node;
+  }
+  // Non-owning handles of canonical nodes, used as children of new nodes
+  vector<shared_ptr<Expr>> share(const vector<Expr *> &exprs);
+  static Key funcCallKey(Opcode op, const string &name,
+                         const vector<Expr *> &args);
+
+public:
+  ExprFactory();
+  ExprFactory(const ExprFactory &) = delete;
+  ExprFactory &operator=(const ExprFactory &) = delete;
+
+  Num *num(int value);
+  Bool *boolean(bool value);
+  String *str(const string &value);
+  Var *var(const string &name);
+  SymVar *symVar(unsigned int num);
+  // The arguments, elements and values must be canonical
+  FuncCall *funcCall(const string &name, const vector<Expr *> &args);
+  // For a name resolved already, e.g. that of another call: neither looks
+  // it up nor interns it again
+  FuncCall *funcCall(Opcode op, ApiId apiId, const string &name,
+                     const vector<Expr *> &args);
+  Set *set(const vector<Expr *> &elements);
+  Tuple *tuple(const vector<Expr *> &exprs);
+  Map *map(const vector<pair<string, Expr *>> &entries);
+
+  // Canonical version of an arbitrary expression tree. Returns the argument
+  // itself if it is already owned by this factory.
+  Expr *intern(Expr &expr);
+  bool isCanonical(const Expr *expr) const;
+  // Deep copy that owns all its nodes and does not depend on any factory
+  static unique_ptr<Expr> detach(const Expr &expr);
+
+  // Statistics
+  size_t size() const { return nodes.size(); }
+  unsigned int getHits() const { return hits; }
+  unsigned int getMisses() const { return misses; }
+  const ExprArena &getArena() const { return arena; }
+};
@@ -0,0 +1,217 @@
+#include "opcode.hh"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// ============================================================================
+// Built-ins
+// ============================================================================
+
+namespace {
+
+struct OpcodeInfo {
+  const char *name;
+  int arity;
+};
+
+// Indexed by Opcode
+const OpcodeInfo opcodeInfo[] = {
+    {"api", -1},
+    // Arithmetic
+    {"add", 2},
+    {"sub", 2},
+    {"mul", 2},
+    {"div", 2},
+    // Comparison
+    {"eq", 2},
+    {"neq", 2},
+    {"lt", 2},
+    {"gt", 2},
+    {"le", 2},
+    {"ge", 2},
+    // Logical
+    {"and", 2},
+    {"or", 2},
+    {"not", 1},
+    {"implies", 2},
+    // Set/map membership
+    {"in", 2},
+    {"not_in", 2},
+    // Sets
+    {"union", 2},
+    {"intersection", 2},
+    {"difference", 2},
+    {"subset", 2},
+    {"add_to_set", 2},
+    {"remove_from_set", 2},
+    {"is_empty_set", 1},
+    // Maps
+    {"get", 2},
+    {"put", 3},
+    {"contains_key", 2},
+    // Lists/sequences
+    {"concat", 2},
+    {"length", 1},
+    {"at", 2},
+    {"prefix", 2},
+    {"suffix", 2},
+    {"contains_seq", 2},
+    // Special
+    {"input", 0},
+    {"'", 1},
+    {"any", 1},
+};
+static_assert(sizeof(opcodeInfo) / sizeof(opcodeInfo[0]) ==
+                  static_cast<size_t>(Opcode::ANY) + 1,
+              "opcodeInfo must have one entry per Opcode");
+
+const unordered_map<string, Opcode> &spellings() {
+  static const unordered_map<string, Opcode> table = {
+      // Arithmetic
+      {"add", Opcode::ADD},
+      {"Add", Opcode::ADD},
+      {"sub", Opcode::SUB},
+      {"Sub", Opcode::SUB},
+      {"mul", Opcode::MUL},
+      {"Mul", Opcode::MUL},
+      {"div", Opcode::DIV},
+      {"Div", Opcode::DIV},
+      // Comparison
+      {"eq", Opcode::EQ},
+      {"Eq", Opcode::EQ},
+      {"=", Opcode::EQ},
+      {"==", Opcode::EQ},
+      {"neq", Opcode::NEQ},
+      {"Neq", Opcode::NEQ},
+      {"!=", Opcode::NEQ},
+      {"<>", Opcode::NEQ},
+      {"lt", Opcode::LT},
+      {"Lt", Opcode::LT},
+      {"<", Opcode::LT},
+      {"gt", Opcode::GT},
+      {"Gt", Opcode::GT},
+      {">", Opcode::GT},
+      {"le", Opcode::LE},
+      {"Le", Opcode::LE},
+      {"<=", Opcode::LE},
+      {"ge", Opcode::GE},
+      {"Ge", Opcode::GE},
+      {">=", Opcode::GE},
+      // Logical
+      {"and", Opcode::AND},
+      {"And", Opcode::AND},
+      {"&&", Opcode::AND},
+      {"or", Opcode::OR},
+      {"Or", Opcode::OR},
+      {"||", Opcode::OR},
+      {"not", Opcode::NOT},
+      {"Not", Opcode::NOT},
+      {"!", Opcode::NOT},
+      {"implies", Opcode::IMPLIES},
+      // Set/map membership
+      {"in", Opcode::IN},
+      {"member", Opcode::IN},
+      {"contains", Opcode::IN},
+      {"not_in", Opcode::NOT_IN},
+      {"not_member", Opcode::NOT_IN},
+      {"not_contains", Opcode::NOT_IN},
+      // Sets
+      {"union", Opcode::UNION},
+      {"intersection", Opcode::INTERSECT},
+      {"intersect", Opcode::INTERSECT},
+      {"difference", Opcode::DIFFERENCE},
+      {"diff", Opcode::DIFFERENCE},
+      {"minus", Opcode::DIFFERENCE},
+      {"subset", Opcode::SUBSET},
+      {"is_subset", Opcode::SUBSET},
+      {"add_to_set", Opcode::ADD_TO_SET},
+      {"remove_from_set", Opcode::REMOVE_FROM_SET},
+      {"is_empty_set", Opcode::IS_EMPTY_SET},
+      // Maps
+      {"get", Opcode::GET},
+      {"lookup", Opcode::GET},
+      {"select", Opcode::GET},
+      {"put", Opcode::PUT},
+      {"store", Opcode::PUT},
+      {"update", Opcode::PUT},
+      {"contains_key", Opcode::CONTAINS_KEY},
+      {"has_key", Opcode::CONTAINS_KEY},
+      // Lists/sequences
+      {"concat", Opcode::CONCAT},
+      {"append_list", Opcode::CONCAT},
+      {"length", Opcode::LENGTH},
+      {"at", Opcode::AT},
+      {"nth", Opcode::AT},
+      {"prefix", Opcode::PREFIX},
+      {"suffix", Opcode::SUFFIX},
+      {"contains_seq", Opcode::CONTAINS_SEQ},
+      // Special
+      {"input", Opcode::INPUT},
+      {"'", Opcode::PRIME},
+      {"any", Opcode::ANY},
+      {"Any", Opcode::ANY},
+  };
+  return table;
+}
+
+} // namespace
+
+Opcode OpcodeTable::lookup(const string &name) {
+  const auto &table = spellings();
+  auto it = table.find(name);
+  return it == table.end() ? Opcode::API : it->second;
+}
+
+int OpcodeTable::arity(Opcode op) {
+  return opcodeInfo[static_cast<size_t>(op)].arity;
+}
+
+const char *OpcodeTable::name(Opcode op) {
+  return opcodeInfo[static_cast<size_t>(op)].name;
+}
+
+// ============================================================================
+// API functions
+// ============================================================================
+
+namespace {
+
+struct ApiNames {
+  mutex lock;
+  unordered_map<string, ApiId> ids;
+  vector<string> names; // indexed by ApiId
+};
+
+ApiNames &apiNames() {
+  static ApiNames table;
+  return table;
+}
+
+} // namespace
+
+ApiId ApiRegistry::intern(const string &name) {
+  ApiNames &table = apiNames();
+  lock_guard<mutex> guard(table.lock);
+  auto it = table.ids.find(name);
+  if (it != table.ids.end()) {
+    return it->second;
+  }
+  ApiId id = table.names.size();
+  table.ids.emplace(name, id);
+  table.names.push_back(name);
+  return id;
+}
+
+string ApiRegistry::name(ApiId id) {
+  ApiNames &table = apiNames();
+  lock_guard<mutex> guard(table.lock);
+  return id < table.names.size() ? table.names[id] : string();
+}
+
+size_t ApiRegistry::size() {
+  ApiNames &table = apiNames();
+  lock_guard<mutex> guard(table.lock);
+  return table.names.size();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Opcodes: interned operator IDs for function calls
+ *
+ * A FuncCall resolves its name once, when the node is built (by the parser,
+ * the ATC generator or an ExprFactory). Built-ins get an Opcode, with all
+ * their spellings ("eq", "Eq", "=", "==") mapped to the same one; every other
+ * name is an API function and gets a dense ApiId. The engine then dispatches
+ * with a switch instead of comparing strings at every node.
+ */
+enum class Opcode : unsigned char {
+  API = 0, // not a built-in: an API function, see FuncCall::apiId
+  // Arithmetic
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  // Comparison
+  EQ,
+  NEQ,
+  LT,
+  GT,
+  LE,
+  GE,
+  // Logical
+  AND,
+  OR,
+  NOT,
+  IMPLIES,
+  // Set/map membership
+  IN,
+  NOT_IN,
+  // Sets
+  UNION,
+  INTERSECT,
+  DIFFERENCE,
+  SUBSET,
+  ADD_TO_SET,
+  REMOVE_FROM_SET,
+  IS_EMPTY_SET,
+  // Maps
+  GET,
+  PUT,
+  CONTAINS_KEY,
+  // Lists/sequences
+  CONCAT,
+  LENGTH,
+  AT,
+  PREFIX,
+  SUFFIX,
+  CONTAINS_SEQ,
+  // Special
+  INPUT, // input(): a fresh symbolic input
+  PRIME, // '(x): value of x after the call, in postconditions
+  ANY,   // Any(x): no constraint on x
+};
+
+typedef unsigned int ApiId;
+const ApiId NO_API_ID = ~0u;
+
+class OpcodeTable {
+public:
+  // Opcode::API if the name is not a built-in
+  static Opcode lookup(const std::string &name);
+  // Number of arguments the built-in takes, -1 for Opcode::API
+  static int arity(Opcode op);
+  // Canonical spelling, e.g. "eq" for Opcode::EQ
+  static const char *name(Opcode op);
+};
+
+// Dense IDs of API function names, assigned in order of first use and shared
+// by every FuncCall and FunctionFactory of the process. IDs are never
+// reused, and interning is thread-safe.
+class ApiRegistry {
+public:
+  static ApiId intern(const std::string &name);
+  static std::string name(ApiId id);
+  static size_t size();
+};
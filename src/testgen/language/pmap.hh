@@ -0,0 +1,178 @@
+#ifndef PMAP_HH
+#define PMAP_HH
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Persistent map from strings to values: a hash array mapped trie (HAMT).
+// Copying a map is O(1) and gives a snapshot; set() copies only the O(log n)
+// nodes on the path to the key, so a map and its snapshots share all the
+// rest. Nodes are immutable once built, so snapshots may be read from
+// several threads.
+//
+// Each level of the trie consumes 5 bits of the key's hash. A branch keeps a
+// bitmap of its 32 slots and only the children that are present; a leaf
+// holds the entries whose keys have the same full hash (usually one).
+template <typename V, typename Hash = hash<string>> class PersistentMap {
+  static const unsigned BITS = 5;
+  static const size_t SLOTS = 1u << BITS;
+  static const unsigned HASH_BITS = sizeof(size_t) * 8;
+
+  struct Node {
+    uint32_t bitmap = 0; // branch: occupied slots
+    vector<shared_ptr<const Node>> children;
+    size_t hash = 0; // leaf: hash of the entries' keys
+    vector<pair<string, V>> entries;
+
+    bool isLeaf() const { return !entries.empty(); }
+  };
+  using NodePtr = shared_ptr<const Node>;
+
+  NodePtr root;
+  size_t count = 0;
+
+  static unsigned slot(size_t h, unsigned shift) {
+    return (h >> shift) & (SLOTS - 1);
+  }
+  // Position of the slot's child among the children that are present
+  static size_t position(uint32_t bitmap, unsigned s) {
+    return bitset<32>(bitmap & ((1u << s) - 1)).count();
+  }
+
+  static NodePtr makeLeaf(size_t h, const string &key, const V &value) {
+    auto leaf = make_shared<Node>();
+    leaf->hash = h;
+    leaf->entries.emplace_back(key, value);
+    return leaf;
+  }
+
+  // The node with key bound to value; added is set if key was not bound
+  static NodePtr insert(const NodePtr &node, unsigned shift, size_t h,
+                        const string &key, const V &value, bool &added) {
+    if (!node) {
+      added = true;
+      return makeLeaf(h, key, value);
+    }
+    if (node->isLeaf()) {
+      if (node->hash == h) {
+        auto leaf = make_shared<Node>(*node);
+        for (auto &entry : leaf->entries) {
+          if (entry.first == key) {
+            entry.second = value;
+            return leaf;
+          }
+        }
+        added = true;
+        leaf->entries.emplace_back(key, value);
+        return leaf;
+      }
+      // Two hashes that agree on the bits consumed so far: push the leaf
+      // one level down, under a branch, and insert there
+      auto branch = make_shared<Node>();
+      branch->bitmap = 1u << slot(node->hash, shift);
+      branch->children.push_back(node);
+      return insert(branch, shift, h, key, value, added);
+    }
+
+    unsigned s = slot(h, shift);
+    size_t pos = position(node->bitmap, s);
+    auto branch = make_shared<Node>(*node);
+    if (node->bitmap & (1u << s)) {
+      branch->children[pos] =
+          insert(node->children[pos], shift + BITS, h, key, value, added);
+    } else {
+      added = true;
+      branch->bitmap |= 1u << s;
+      branch->children.insert(branch->children.begin() + pos,
+                              makeLeaf(h, key, value));
+    }
+    return branch;
+  }
+
+  static void collect(const NodePtr &node,
+                      vector<pair<string, V>> &entries) {
+    if (!node) {
+      return;
+    }
+    if (node->isLeaf()) {
+      entries.insert(entries.end(), node->entries.begin(),
+                     node->entries.end());
+      return;
+    }
+    for (const auto &child : node->children) {
+      collect(child, entries);
+    }
+  }
+
+public:
+  // The value bound to key, or nullptr
+  const V *find(const string &key) const {
+    size_t h = Hash()(key);
+    const Node *node = root.get();
+    for (unsigned shift = 0; node; shift += BITS) {
+      if (node->isLeaf()) {
+        if (node->hash != h) {
+          return nullptr;
+        }
+        for (const auto &entry : node->entries) {
+          if (entry.first == key) {
+            return &entry.second;
+          }
+        }
+        return nullptr;
+      }
+      // Branches only split hashes, so they end before the hash does
+      if (shift >= HASH_BITS) {
+        return nullptr;
+      }
+      unsigned s = slot(h, shift);
+      if (!(node->bitmap & (1u << s))) {
+        return nullptr;
+      }
+      node = node->children[position(node->bitmap, s)].get();
+    }
+    return nullptr;
+  }
+  bool contains(const string &key) const { return find(key) != nullptr; }
+
+  void set(const string &key, const V &value) {
+    bool added = false;
+    root = insert(root, 0, Hash()(key), key, value, added);
+    if (added) {
+      count++;
+    }
+  }
+  void clear() {
+    root.reset();
+    count = 0;
+  }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  // Entries ordered by key
+  vector<pair<string, V>> entries() const {
+    vector<pair<string, V>> result;
+    result.reserve(count);
+    collect(root, result);
+    sort(result.begin(), result.end(),
+         [](const pair<string, V> &a, const pair<string, V> &b) {
+           return a.first < b.first;
+         });
+    return result;
+  }
+  // Whether both are the same version, i.e. neither has been updated since
+  // one was copied from the other
+  bool sameVersion(const PersistentMap &other) const {
+    return root == other.root;
+  }
+};
+
+#endif
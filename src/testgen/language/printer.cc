@@ -79,7 +79,9 @@ void Printer::visitAPI(const API &node) {
 
   printIndent();
   std::cout << "pre: ";
-  visit(node.pre.get());
+  if (node.pre) {
+    visit(node.pre.get());
+  }
   std::cout << endl;
 
   printIndent();
@@ -89,7 +91,9 @@ void Printer::visitAPI(const API &node) {
 
   printIndent();
   std::cout << "post: ";
-  visit(node.post.get());
+  if (node.post) {
+    visit(node.post.get());
+  }
   std::cout << endl;
 
   dedent();
@@ -9,16 +9,30 @@ using namespace std;
 
 class SymVar : public Expr {
 private:
-  static unsigned int count;
   unsigned int num;
 
 public:
   SymVar(unsigned int);
-  static unique_ptr<SymVar> getNewSymVar();
   virtual void accept(Visitor &);
   bool operator==(SymVar &);
   unsigned int getNum() const { return num; }
   virtual std::string toString() const;
   virtual std::unique_ptr<Expr> clone();
 };
+
+// Numbers the SymVars of one session densely from 0. Every SEE session owns
+// one, so sessions (also concurrent ones) number their SymVars independently
+// and tables indexed by SymVar number stay as small as the session.
+class SymVarAllocator {
+private:
+  unsigned int next;
+
+public:
+  SymVarAllocator() : next(0) {}
+  unsigned int allocate() { return next++; }
+  unique_ptr<SymVar> getNewSymVar() { return make_unique<SymVar>(allocate()); }
+  // Number of SymVars handed out, i.e. one past the largest number
+  unsigned int size() const { return next; }
+  void reset() { next = 0; }
+};
 #endif
@@ -3,12 +3,22 @@
 #include "language/env.hh"
 #include "language/printer.hh"
 #include "language/typemap.hh"
+#include "see/portfolio.hh"
+#include "see/searcher.hh"
+#include "tester/enumerator.hh"
 #include "tester/genATC.hh"
+#include "tester/prefixes.hh"
 #include "tester/test_utils.hh"
 #include "tester/tester.hh"
+#include "util/threadpool.hh"
+#include "util/trace.hh"
+#include <algorithm>
 #include <cassert>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
 
 extern int yyparse();
@@ -20,9 +30,31 @@ class TestGen {
 protected:
   string fileName;
   Printer printer;
+  SolverBudget budget;
+  UnknownPolicy unknownPolicy;
+  // Retries of UnknownPolicy::RETRY race several configurations, if set
+  unique_ptr<PortfolioSolver> portfolio;
+  bool fastPath;
+  size_t numModels; // CTCs per ATC
+  // Every Z3 query of the run is captured here, if set
+  unique_ptr<QueryLog> queryLog;
+  // Skip batch test strings that extend a prefix found infeasible
+  bool prune;
+  // Split symbolic execution at disjunctive preconditions
+  bool forking;
 
   std::unique_ptr<Spec> makeSpec() {
-    if (yyparse() != 0) {
+    // The bison parser keeps its state in globals (yyin, astRoot)
+    static std::mutex parserLock;
+    std::lock_guard<std::mutex> guard(parserLock);
+    yyin = fopen(fileName.c_str(), "r");
+    if (!yyin) {
+      throw std::runtime_error("Failed to open spec file: " + fileName);
+    }
+    int status = yyparse();
+    fclose(yyin);
+    yyin = nullptr;
+    if (status != 0) {
       throw std::runtime_error("Parsing failed");
       return nullptr;
     }
@@ -85,9 +117,74 @@ protected:
   }
 
 public:
-  TestGen(const string &name) : fileName(name) {}
+  TestGen(const string &name)
+      : fileName(name), unknownPolicy(UnknownPolicy::SKIP),
+        fastPath(true), numModels(1), prune(false), forking(false) {}
   ~TestGen() = default;
 
+  // Solver limits, and what to do when a query runs out of them
+  void configureSolver(const SolverBudget &b, UnknownPolicy policy) {
+    budget = b;
+    unknownPolicy = policy;
+  }
+
+  // Decide simple path constraints without Z3, see LinearFastPath
+  void setFastPath(bool enabled) { fastPath = enabled; }
+
+  // Generate up to n CTCs per ATC, from distinct models of its first path
+  // constraint
+  void setNumModels(size_t n) { numModels = n; }
+
+  // Print the CTCs of one ATC, numbered if there are several
+  void printCTCs(const std::vector<std::unique_ptr<Program>> &ctcs) {
+    for (size_t i = 0; i < ctcs.size(); i++) {
+      std::cout << "\nConcrete Test Case (CTC)";
+      if (ctcs.size() > 1) {
+        std::cout << " " << i + 1 << " of " << ctcs.size();
+      }
+      std::cout << ":" << std::endl;
+      printer.visitProgram(*ctcs[i]);
+    }
+  }
+
+  // Record the test string prefixes whose assumptions are infeasible and
+  // skip the batch test strings that extend one found by an earlier test
+  // string, whatever the number of workers
+  void setPrune(bool enabled) { prune = enabled; }
+
+  // Go on with another disjunct of an or(...) precondition when the path
+  // of the first one is infeasible
+  void setForking(bool enabled) { forking = enabled; }
+
+  // Capture the queries of the run as SMT-LIB2 files in the directory,
+  // for the replay benchmark
+  void dumpQueries(const string &directory) {
+    queryLog = std::make_unique<QueryLog>(directory);
+  }
+
+  // Retry through a portfolio of solver configurations instead of a single
+  // tactic
+  void usePortfolio() {
+    portfolio = std::make_unique<PortfolioSolver>();
+    portfolio->setBudget(budget);
+  }
+
+  // Which configurations decided the retries, so that the one suiting this
+  // spec can be made the default retry tactic
+  void reportPortfolio() {
+    if (!portfolio || !TRACE_ENABLED(INFO)) {
+      return;
+    }
+    for (const auto &entry : portfolio->getWins()) {
+      TRACE(INFO, "Portfolio " << entry.first << ": " << entry.second
+                  << " win(s)");
+    }
+    string preferred = portfolio->getPreferredConfig();
+    if (!preferred.empty()) {
+      TRACE(INFO, "Portfolio preferred configuration: " << preferred);
+    }
+  }
+
   void execute() {
     std::cout << "\n" << string(80, '=') << std::endl;
     std::cout << "E2E Test: " << fileName << std::endl;
@@ -95,10 +192,6 @@ public:
 
     // ===== STAGE 1: Create Specification =====
     std::cout << "\n[STAGE 1] Creating API Specification..." << std::endl;
-    yyin = fopen(fileName.c_str(), "r");
-    if (!yyin) {
-      throw std::runtime_error("Failed to open spec file: " + fileName);
-    }
     std::cout << "Parsing spec file: " << fileName << std::endl;
     std::unique_ptr<Spec> spec = makeSpec();
     assert(spec != nullptr);
@@ -129,31 +222,387 @@ public:
 
     FunctionFactory *functionFactory = new App1FunctionFactory();
     Tester tester(functionFactory);
+    tester.getSolver().setBudget(budget);
+    tester.setUnknownPolicy(unknownPolicy);
+    tester.setRetrySolver(portfolio.get());
+    tester.getSolver().setFastPath(fastPath);
+    tester.getSolver().setQueryLog(queryLog.get());
+    tester.setForking(forking);
     std::vector<Expr *> initialConcreteVals;
     ValueEnvironment ve(nullptr);
 
     std::unique_ptr<Program> atcCopy = std::make_unique<Program>(std::move(
         const_cast<std::vector<std::unique_ptr<Stmt>> &>(atc.statements)));
 
-    std::unique_ptr<Program> ctc =
-        tester.generateCTC(std::move(atcCopy), initialConcreteVals, &ve);
-
-    std::cout << "\nConcrete Test Case (CTC):" << std::endl;
-    printer.visitProgram(*ctc);
+    std::vector<std::unique_ptr<Program>> ctcs;
+    if (numModels > 1) {
+      ctcs = tester.generateCTCs(std::move(atcCopy), numModels, &ve);
+    } else {
+      ctcs.push_back(
+          tester.generateCTC(std::move(atcCopy), initialConcreteVals, &ve));
+    }
+    printCTCs(ctcs);
 
     // Cleanup
     cleanup(globalSymTable);
     delete functionFactory;
   }
+
+  // Generates a CTC for every test string of 1 to maxLength API calls over
+  // the spec's blocks, sharing the work on common prefixes (see
+  // SequenceEnumerator)
+  void executeEnumeration(size_t maxLength) {
+    std::unique_ptr<Spec> spec = makeSpec();
+    SymbolTable *globalSymTable = makeSymbolTables(spec.get());
+    Tester tester(nullptr);
+    tester.getSolver().setBudget(budget);
+    tester.setUnknownPolicy(unknownPolicy);
+    tester.setRetrySolver(portfolio.get());
+    tester.getSolver().setFastPath(fastPath);
+    tester.getSolver().setQueryLog(queryLog.get());
+    tester.setForking(forking);
+    SequenceEnumerator enumerator(
+        spec.get(), globalSymTable, tester,
+        [] { return std::make_unique<App1FunctionFactory>(); }, maxLength);
+    std::vector<EnumeratedTest> tests = enumerator.enumerate();
+
+    for (const EnumeratedTest &test : tests) {
+      std::cout << "\n" << string(80, '=') << std::endl;
+      std::cout << "Test String:";
+      for (const auto &s : test.testString) {
+        std::cout << " " << s;
+      }
+      std::cout << "\nConcrete Test Case (CTC):" << std::endl;
+      printer.visitProgram(*test.ctc);
+    }
+    std::cout << "\n"
+              << tests.size() << " test string(s), " << enumerator.getPruned()
+              << " pruned" << std::endl;
+    cleanup(globalSymTable);
+  }
+
+  // Generates a CTC per path of the spec's ATC through its disjunctive
+  // preconditions with each of the searchers (dfs, bfs, random, coverage)
+  // in turn, within budgetMs each, and reports how each one did. The CTCs
+  // are printed when there is a single searcher.
+  void executeExploration(const std::vector<string> &searchers,
+                          size_t budgetMs) {
+    std::unique_ptr<Spec> spec = makeSpec();
+    SymbolTable *globalSymTable = makeSymbolTables(spec.get());
+    ATCGenerator generator(spec.get(), TypeMap());
+    Program atc = generator.generate(spec.get(), globalSymTable,
+                                     makeTestString(spec.get()));
+    std::unique_ptr<Program> atcCopy = std::make_unique<Program>(std::move(
+        const_cast<std::vector<std::unique_ptr<Stmt>> &>(atc.statements)));
+
+    for (const string &name : searchers) {
+      std::unique_ptr<Searcher> searcher =
+          makeSearcher(name, generator.getBlockStarts());
+      Tester tester(nullptr);
+      tester.getSolver().setBudget(budget);
+      tester.setUnknownPolicy(unknownPolicy);
+      tester.setRetrySolver(portfolio.get());
+      tester.getSolver().setFastPath(fastPath);
+      tester.getSolver().setQueryLog(queryLog.get());
+      ValueEnvironment ve(nullptr);
+      Exploration exploration = tester.explorePaths(
+          tester.rewriteATC(atcCopy, {}), *searcher,
+          [] { return std::make_unique<App1FunctionFactory>(); }, budgetMs,
+          &ve);
+      if (searchers.size() == 1) {
+        printCTCs(exploration.ctcs);
+      }
+
+      const ExplorationStats &stats = exploration.stats;
+      std::cout << "\nSearcher " << stats.searcher << ": " << stats.paths
+                << " path(s), " << stats.tests << " test(s), frontier up to "
+                << stats.maxFrontier << ", " << stats.statesPerSecond
+                << " path(s)/s, first test after ";
+      if (stats.firstTestSeconds < 0) {
+        std::cout << "none";
+      } else {
+        std::cout << stats.firstTestSeconds * 1000 << " ms";
+      }
+      std::cout << std::endl;
+    }
+    cleanup(globalSymTable);
+  }
+
+  // Generates a CTC for every test string in batchFile (one per line, API
+  // names separated by whitespace) on numThreads workers. The CTCs are
+  // printed in batch order, whatever order the workers finish in.
+  void executeBatch(const string &batchFile, size_t numThreads) {
+    std::ifstream in(batchFile);
+    if (!in) {
+      throw std::runtime_error("Failed to open batch file: " + batchFile);
+    }
+    std::vector<std::vector<string>> testStrings;
+    string line;
+    while (std::getline(in, line)) {
+      std::istringstream words(line);
+      std::vector<string> testString;
+      string api;
+      while (words >> api) {
+        testString.push_back(api);
+      }
+      if (!testString.empty()) {
+        testStrings.push_back(testString);
+      }
+    }
+
+    std::unique_ptr<Spec> spec = makeSpec();
+
+    // ATC generation is cheap; only symbolic execution and solving run on
+    // the pool
+    std::vector<std::unique_ptr<Program>> atcs;
+    std::vector<std::vector<size_t>> blockStarts;
+    for (const auto &testString : testStrings) {
+      SymbolTable *globalSymTable = makeSymbolTables(spec.get());
+      ATCGenerator generator(spec.get(), TypeMap());
+      Program atc = generator.generate(spec.get(), globalSymTable, testString);
+      blockStarts.push_back(generator.getBlockStarts());
+      atcs.push_back(std::make_unique<Program>(std::move(
+          const_cast<std::vector<std::unique_ptr<Stmt>> &>(atc.statements))));
+      cleanup(globalSymTable);
+    }
+
+    // One Tester (and so one Z3 context) per worker, created on the worker
+    // that uses it. Each job starts from the same state as a single run: a
+    // new session (SymVars numbered from 0), an empty counterexample cache
+    // and a fresh application.
+    WorkStealingPool pool(numThreads);
+    Z3ContextPool::getInstance().reserve(pool.getNumWorkers());
+    std::vector<std::unique_ptr<Tester>> testers(pool.getNumWorkers());
+    std::vector<std::vector<std::unique_ptr<Program>>> ctcs(atcs.size());
+    // The infeasible prefix each job found, if any; guarded by prefixLock
+    std::vector<std::vector<string>> foundBy(atcs.size());
+    std::vector<bool> ran(atcs.size(), false); // also guarded by prefixLock
+    std::mutex prefixLock;
+    auto runJob = [&](size_t job, size_t worker) {
+      if (!testers[worker]) {
+        testers[worker] = std::make_unique<Tester>(nullptr);
+        testers[worker]->getSolver().setBudget(budget);
+        testers[worker]->setUnknownPolicy(unknownPolicy);
+        testers[worker]->setRetrySolver(portfolio.get());
+        testers[worker]->getSolver().setFastPath(fastPath);
+        testers[worker]->getSolver().setQueryLog(queryLog.get());
+        testers[worker]->setForking(forking);
+      }
+      Tester &tester = *testers[worker];
+      App1FunctionFactory functionFactory;
+      tester.setFunctionFactory(&functionFactory);
+      tester.getSolver().getCexCache().clear();
+      ValueEnvironment ve(nullptr);
+      ctcs[job] = tester.generateCTCs(std::move(atcs[job]), numModels, &ve);
+      tester.setFunctionFactory(nullptr);
+      const std::vector<size_t> &core = tester.getUnsatCoreStatements();
+      std::lock_guard<std::mutex> guard(prefixLock);
+      ran[job] = true;
+      if (prune && !core.empty()) {
+        size_t length =
+            InfeasiblePrefixes::prefixLength(blockStarts[job], core);
+        foundBy[job].assign(testStrings[job].begin(),
+                            testStrings[job].begin() + length);
+      }
+    };
+    // On a prefix an earlier job has found, a job is skipped without
+    // waiting for the decision below; if that job turns out to be skipped
+    // itself, the job runs in a later round
+    auto extendsEarlierPrefix = [&](size_t job) {
+      std::lock_guard<std::mutex> guard(prefixLock);
+      for (size_t earlier = 0; earlier < job; earlier++) {
+        const std::vector<string> &prefix = foundBy[earlier];
+        if (!prefix.empty() &&
+            prefix.size() <= testStrings[job].size() &&
+            std::equal(prefix.begin(), prefix.end(),
+                       testStrings[job].begin())) {
+          return true;
+        }
+      }
+      return false;
+    };
+    pool.run(atcs.size(), [&](size_t job, size_t worker) {
+      if (!prune || !extendsEarlierPrefix(job)) {
+        runJob(job, worker);
+      }
+    });
+
+    // Pruning is decided in batch order, as one worker would: a job is
+    // skipped if it extends the prefix of an earlier job that was not
+    // skipped. So the skipped jobs do not depend on the order the workers
+    // finish in. Jobs that must run but were skipped ahead run in rounds
+    // until none is left.
+    std::vector<std::vector<string>> skippedFor(atcs.size());
+    std::vector<bool> skipped(atcs.size(), false);
+    std::unique_ptr<InfeasiblePrefixes> infeasiblePrefixes;
+    std::vector<size_t> missing;
+    while (true) {
+      infeasiblePrefixes = std::make_unique<InfeasiblePrefixes>();
+      for (size_t job = 0; job < atcs.size(); job++) {
+        skipped[job] = prune && infeasiblePrefixes->blocks(testStrings[job],
+                                                           &skippedFor[job]);
+        if (skipped[job]) {
+          continue;
+        }
+        if (!ran[job]) {
+          missing.push_back(job);
+        } else if (!foundBy[job].empty()) {
+          infeasiblePrefixes->add(foundBy[job]);
+        }
+      }
+      if (missing.empty()) {
+        break;
+      }
+      pool.run(missing.size(), [&](size_t index, size_t worker) {
+        runJob(missing[index], worker);
+      });
+      missing.clear();
+    }
+
+    TRACE(INFO, "Infeasible prefixes: " << infeasiblePrefixes->size()
+                << " found, " << infeasiblePrefixes->getSkips()
+                << " test string(s) skipped");
+    if (TRACE_ENABLED(INFO)) {
+      // The pool's statistics are copied under its lock
+      std::vector<Z3ContextStats> stats =
+          Z3ContextPool::getInstance().getStats();
+      for (size_t i = 0; i < stats.size(); i++) {
+        TRACE(INFO, "Z3 context " << i << ": " << stats[i].leases
+                    << " lease(s), " << stats[i].queries << " query(ies), "
+                    << stats[i].sat << " SAT, " << stats[i].unsat
+                    << " UNSAT, " << stats[i].unknown << " unknown");
+      }
+    }
+
+    for (size_t job = 0; job < ctcs.size(); job++) {
+      std::cout << "\n" << string(80, '=') << std::endl;
+      std::cout << "Test String:";
+      for (const auto &s : testStrings[job]) {
+        std::cout << " " << s;
+      }
+      if (skipped[job]) {
+        std::cout << "\nSkipped: extends the infeasible prefix";
+        for (const auto &s : skippedFor[job]) {
+          std::cout << " " << s;
+        }
+        std::cout << std::endl;
+        continue;
+      }
+      printCTCs(ctcs[job]);
+    }
+  }
 };
 
 int main(int argc, char *argv[]) {
   // std::cout << "End-to-End Test Suite: Spec -> ATC -> CTC" << std::endl;
   if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " <input_file>" << std::endl;
+    std::cerr << "Usage: " << argv[0]
+              << " <input_file> [--trace=off|error|info|debug]"
+                 " [--trace-file=<path>] [--batch=<file>] [--threads=<n>]"
+                 " [--timeout=<ms>] [--session-timeout=<ms>]"
+                 " [--memory=<MB>] [--on-unknown=skip|retry|fallback]"
+                 " [--portfolio] [--no-fast-path] [--dump-queries=<dir>]"
+                 " [--models=<n>] [--prune] [--enumerate=<max length>]"
+                 " [--fork] [--explore=dfs|bfs|random|coverage|all]"
+                 " [--explore-budget=<ms>]"
+              << std::endl;
     return 1;
   }
   string inputFile = argv[1];
+
+  // Engine tracing (SEE, solver, tester); the test case report below is
+  // always printed
+  string batchFile;
+  size_t numThreads = 0;
+  bool traceSet = false;
+  SolverBudget budget;
+  UnknownPolicy unknownPolicy = UnknownPolicy::SKIP;
+  bool portfolio = false;
+  bool fastPath = true;
+  string queryDir;
+  size_t numModels = 1;
+  bool prune = false;
+  size_t enumerateLength = 0;
+  bool forking = false;
+  std::vector<string> searchers;
+  size_t exploreBudgetMs = 10000;
+  for (int i = 2; i < argc; i++) {
+    string arg = argv[i];
+    TraceLevel level;
+    if (arg.rfind("--trace=", 0) == 0 &&
+        Trace::parseLevel(arg.substr(8), level)) {
+      Trace::setLevel(level);
+      traceSet = true;
+    } else if (arg.rfind("--batch=", 0) == 0) {
+      batchFile = arg.substr(8);
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      numThreads = std::stoul(arg.substr(10));
+    } else if (arg.rfind("--timeout=", 0) == 0) {
+      budget.queryTimeoutMs = std::stoul(arg.substr(10));
+    } else if (arg.rfind("--session-timeout=", 0) == 0) {
+      budget.sessionTimeoutMs = std::stoul(arg.substr(18));
+    } else if (arg.rfind("--memory=", 0) == 0) {
+      budget.memoryMb = std::stoul(arg.substr(9));
+    } else if (arg == "--on-unknown=skip") {
+      unknownPolicy = UnknownPolicy::SKIP;
+    } else if (arg == "--on-unknown=retry") {
+      unknownPolicy = UnknownPolicy::RETRY;
+    } else if (arg == "--on-unknown=fallback") {
+      unknownPolicy = UnknownPolicy::FALLBACK;
+    } else if (arg == "--portfolio") {
+      portfolio = true;
+    } else if (arg == "--no-fast-path") {
+      fastPath = false;
+    } else if (arg.rfind("--dump-queries=", 0) == 0) {
+      queryDir = arg.substr(15);
+    } else if (arg.rfind("--models=", 0) == 0) {
+      numModels = std::max<size_t>(1, std::stoul(arg.substr(9)));
+    } else if (arg.rfind("--enumerate=", 0) == 0) {
+      enumerateLength = std::stoul(arg.substr(12));
+    } else if (arg == "--prune") {
+      prune = true;
+    } else if (arg == "--fork") {
+      forking = true;
+    } else if (arg == "--explore=all") {
+      searchers = {"dfs", "bfs", "random", "coverage"};
+    } else if (arg.rfind("--explore=", 0) == 0 &&
+               makeSearcher(arg.substr(10)) != nullptr) {
+      searchers = {arg.substr(10)};
+    } else if (arg.rfind("--explore-budget=", 0) == 0) {
+      exploreBudgetMs = std::stoul(arg.substr(17));
+    } else if (arg.rfind("--trace-file=", 0) == 0) {
+      Trace::setSink(std::make_unique<FileSink>(arg.substr(13)));
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return 1;
+    }
+  }
+
   TestGen testGen(inputFile);
-  testGen.execute();
+  testGen.configureSolver(budget, unknownPolicy);
+  testGen.setFastPath(fastPath);
+  testGen.setNumModels(numModels);
+  testGen.setPrune(prune);
+  testGen.setForking(forking);
+  if (!queryDir.empty()) {
+    testGen.dumpQueries(queryDir);
+  }
+  if (portfolio) {
+    testGen.usePortfolio();
+  }
+  if (!searchers.empty()) {
+    testGen.executeExploration(searchers, exploreBudgetMs);
+  } else if (enumerateLength > 0) {
+    testGen.executeEnumeration(enumerateLength);
+  } else if (batchFile.empty()) {
+    testGen.execute();
+  } else {
+    // Traces of concurrent jobs interleave, so they are off unless asked for
+    if (!traceSet) {
+      Trace::setLevel(TraceLevel::OFF);
+    }
+    testGen.executeBatch(batchFile, numThreads);
+  }
+  testGen.reportPortfolio();
+  Trace::flush();
 }
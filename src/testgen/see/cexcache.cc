@@ -0,0 +1,177 @@
+#include "cexcache.hh"
+#include "../language/symvar.hh"
+#include <algorithm>
+#include <sstream>
+
+// ============================================================================
+// Canonical form
+// ============================================================================
+
+static void printCanonical(const Expr *expr, CanonicalQuery &query,
+                           ostringstream &out) {
+  switch (expr->exprType) {
+  case ExprType::NUM:
+    out << dynamic_cast<const Num *>(expr)->value;
+    break;
+  case ExprType::BOOL:
+    out << (dynamic_cast<const Bool *>(expr)->value ? "true" : "false");
+    break;
+  case ExprType::STRING:
+    out << '"' << dynamic_cast<const String *>(expr)->value << '"';
+    break;
+  case ExprType::VAR: {
+    const string &name = dynamic_cast<const Var *>(expr)->name;
+    query.namedVars.insert(name);
+    out << name;
+    break;
+  }
+  case ExprType::SYMVAR: {
+    unsigned int num = dynamic_cast<const SymVar *>(expr)->getNum();
+    auto it = query.symVars.find(num);
+    if (it == query.symVars.end()) {
+      it = query.symVars.emplace(num, query.symVars.size()).first;
+    }
+    out << '$' << it->second;
+    break;
+  }
+  case ExprType::FUNC_CALL_EXPR: {
+    const FuncCall *fc = dynamic_cast<const FuncCall *>(expr);
+    out << (fc->op == Opcode::API ? fc->name.c_str()
+                                  : OpcodeTable::name(fc->op))
+        << '(';
+    for (size_t i = 0; i < fc->args.size(); i++) {
+      out << (i > 0 ? ", " : "");
+      printCanonical(fc->args[i].get(), query, out);
+    }
+    out << ')';
+    break;
+  }
+  case ExprType::SET: {
+    const Set *s = dynamic_cast<const Set *>(expr);
+    out << '{';
+    for (size_t i = 0; i < s->elements.size(); i++) {
+      out << (i > 0 ? ", " : "");
+      printCanonical(s->elements[i].get(), query, out);
+    }
+    out << '}';
+    break;
+  }
+  case ExprType::TUPLE: {
+    const Tuple *t = dynamic_cast<const Tuple *>(expr);
+    out << '<';
+    for (size_t i = 0; i < t->exprs.size(); i++) {
+      out << (i > 0 ? ", " : "");
+      printCanonical(t->exprs[i].get(), query, out);
+    }
+    out << '>';
+    break;
+  }
+  case ExprType::MAP: {
+    const Map *m = dynamic_cast<const Map *>(expr);
+    out << '[';
+    for (size_t i = 0; i < m->value.size(); i++) {
+      out << (i > 0 ? ", " : "") << m->value[i].first->name << ": ";
+      printCanonical(m->value[i].second.get(), query, out);
+    }
+    out << ']';
+    break;
+  }
+  default:
+    out << expr->toString();
+    break;
+  }
+}
+
+CanonicalQuery canonicalizeQuery(const vector<Expr *> &conjuncts) {
+  // SymVars are numbered in path constraint order, before sorting
+  CanonicalQuery query;
+  for (const Expr *conjunct : conjuncts) {
+    ostringstream out;
+    printCanonical(conjunct, query, out);
+    query.conjuncts.push_back(out.str());
+  }
+  sort(query.conjuncts.begin(), query.conjuncts.end());
+  query.conjuncts.erase(
+      unique(query.conjuncts.begin(), query.conjuncts.end()),
+      query.conjuncts.end());
+  return query;
+}
+
+// ============================================================================
+// CexCache
+// ============================================================================
+
+CexCache::CexCache()
+    : exactHits(0), subsetHits(0), supersetHits(0), misses(0) {}
+
+void CexCache::answer(const CanonicalQuery &query, const Entry &entry,
+                      bool &isSat, NumberedModel &model) {
+  isSat = entry.isSat;
+  if (!isSat) {
+    return;
+  }
+
+  // Back from canonical indices to the SymVars of this query. Variables of
+  // a superset that the query does not mention are dropped.
+  map<unsigned int, unsigned int> numOf;
+  for (const auto &symVar : query.symVars) {
+    numOf[symVar.second] = symVar.first;
+  }
+  for (const auto &value : entry.model.symVars) {
+    auto it = numOf.find(value.first);
+    if (it != numOf.end()) {
+      model.symVars[it->second] = copyResultValue(*value.second);
+    }
+  }
+  for (const auto &value : entry.model.vars) {
+    if (query.namedVars.count(value.first) > 0) {
+      model.vars[value.first] = copyResultValue(*value.second);
+    }
+  }
+}
+
+bool CexCache::lookup(const CanonicalQuery &query, bool &isSat,
+                      NumberedModel &model) {
+  auto exact = entries.find(query.conjuncts);
+  if (exact != entries.end()) {
+    exactHits++;
+    answer(query, exact->second, isSat, model);
+    return true;
+  }
+
+  // Linear scan: the caches of one generation run stay small
+  for (const auto &entry : entries) {
+    const vector<string> &cached = entry.first;
+    if (!entry.second.isSat &&
+        includes(query.conjuncts.begin(), query.conjuncts.end(),
+                 cached.begin(), cached.end())) {
+      subsetHits++;
+      answer(query, entry.second, isSat, model);
+      return true;
+    }
+    if (entry.second.isSat &&
+        includes(cached.begin(), cached.end(), query.conjuncts.begin(),
+                 query.conjuncts.end())) {
+      supersetHits++;
+      answer(query, entry.second, isSat, model);
+      return true;
+    }
+  }
+
+  misses++;
+  return false;
+}
+
+void CexCache::insert(const CanonicalQuery &query, bool isSat,
+                      const NumberedModel &model) {
+  Entry entry;
+  entry.isSat = isSat;
+  for (const auto &value : model.symVars) {
+    auto it = query.symVars.find(value.first);
+    if (it != query.symVars.end()) {
+      entry.model.symVars[it->second] = copyResultValue(*value.second);
+    }
+  }
+  entry.model.vars = copyModel(model.vars);
+  entries[query.conjuncts] = std::move(entry);
+}
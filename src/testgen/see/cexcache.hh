@@ -0,0 +1,68 @@
+#ifndef CEXCACHE_HH
+#define CEXCACHE_HH
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "solver.hh"
+
+using namespace std;
+
+// A constraint set in canonical form: every conjunct printed with built-ins
+// under their canonical spelling and SymVars renamed in order of first use,
+// then sorted and deduplicated. Queries that only differ in SymVar numbering,
+// conjunct order or operator aliases get the same form.
+struct CanonicalQuery {
+  vector<string> conjuncts;
+  map<unsigned int, unsigned int> symVars; // SymVar number -> canonical index
+  set<string> namedVars;
+};
+
+CanonicalQuery canonicalizeQuery(const vector<Expr *> &conjuncts);
+
+// Counterexample cache, as in KLEE. Answers a query from an earlier one:
+// - the same constraint set: its result
+// - a subset of the query was UNSAT: the query is UNSAT
+// - a superset of the query was SAT: its model satisfies the query
+// Models are stored with the SymVars under their canonical index and
+// translated back to the SymVar numbers of each query.
+class CexCache {
+private:
+  struct Entry {
+    bool isSat;
+    NumberedModel model; // SymVars by canonical index
+  };
+
+  map<vector<string>, Entry> entries;
+  unsigned int exactHits;
+  unsigned int subsetHits;   // UNSAT answered by an UNSAT subset
+  unsigned int supersetHits; // SAT answered by a SAT superset
+  unsigned int misses;
+
+  void answer(const CanonicalQuery &query, const Entry &entry, bool &isSat,
+              NumberedModel &model);
+
+public:
+  CexCache();
+  // false on a miss
+  bool lookup(const CanonicalQuery &query, bool &isSat, NumberedModel &model);
+  void insert(const CanonicalQuery &query, bool isSat,
+              const NumberedModel &model);
+  // Forget all entries; the statistics are kept
+  void clear() { entries.clear(); }
+
+  size_t size() const { return entries.size(); }
+  unsigned int getExactHits() const { return exactHits; }
+  unsigned int getSubsetHits() const { return subsetHits; }
+  unsigned int getSupersetHits() const { return supersetHits; }
+  unsigned int getHits() const {
+    return exactHits + subsetHits + supersetHits;
+  }
+  unsigned int getMisses() const { return misses; }
+};
+
+#endif
@@ -0,0 +1,351 @@
+#include "fastpath.hh"
+#include "../language/symvar.hh"
+#include "../util/trace.hh"
+#include <climits>
+#include <map>
+#include <set>
+
+// ============================================================================
+// Linear Constraints
+// ============================================================================
+
+namespace {
+
+// Sum of coeffs[n] * X<n>, plus constant
+struct LinearTerm {
+  map<unsigned int, long long> coeffs; // no zero coefficients
+  long long constant;
+  LinearTerm() : constant(0) {}
+};
+
+// term == 0 or term <= 0
+struct LinearConstraint {
+  LinearTerm term;
+  bool isEquality;
+};
+
+// into += factor * term; false on overflow
+bool addScaled(LinearTerm &into, const LinearTerm &term, long long factor) {
+  long long product;
+  if (__builtin_mul_overflow(term.constant, factor, &product) ||
+      __builtin_add_overflow(into.constant, product, &into.constant)) {
+    return false;
+  }
+  for (const auto &entry : term.coeffs) {
+    long long &coeff = into.coeffs[entry.first];
+    if (__builtin_mul_overflow(entry.second, factor, &product) ||
+        __builtin_add_overflow(coeff, product, &coeff)) {
+      return false;
+    }
+    if (coeff == 0) {
+      into.coeffs.erase(entry.first);
+    }
+  }
+  return true;
+}
+
+bool toLinear(const Expr *expr, LinearTerm &term) {
+  switch (expr->exprType) {
+  case ExprType::NUM:
+    term.constant = dynamic_cast<const Num *>(expr)->value;
+    return true;
+  case ExprType::SYMVAR:
+    term.coeffs[dynamic_cast<const SymVar *>(expr)->getNum()] = 1;
+    return true;
+  case ExprType::FUNC_CALL_EXPR:
+    break;
+  default:
+    return false;
+  }
+  const FuncCall *call = dynamic_cast<const FuncCall *>(expr);
+  LinearTerm left, right;
+  if (call->args.size() != 2 || !toLinear(call->args[0].get(), left) ||
+      !toLinear(call->args[1].get(), right)) {
+    return false;
+  }
+  switch (call->op) {
+  case Opcode::ADD:
+    term = left;
+    return addScaled(term, right, 1);
+  case Opcode::SUB:
+    term = left;
+    return addScaled(term, right, -1);
+  case Opcode::MUL:
+    if (left.coeffs.empty()) {
+      return addScaled(term, right, left.constant);
+    }
+    if (right.coeffs.empty()) {
+      return addScaled(term, left, right.constant);
+    }
+    return false;
+  default:
+    return false;
+  }
+}
+
+// Adds the constraints of a conjunct; false if it is outside the fragment.
+// A false conjunct sets isFalse.
+bool collectConstraints(const Expr *expr,
+                        vector<LinearConstraint> &constraints,
+                        set<unsigned int> &variables, bool &isFalse) {
+  if (expr->exprType == ExprType::BOOL) {
+    isFalse = isFalse || !dynamic_cast<const Bool *>(expr)->value;
+    return true;
+  }
+  if (expr->exprType != ExprType::FUNC_CALL_EXPR) {
+    return false;
+  }
+  const FuncCall *call = dynamic_cast<const FuncCall *>(expr);
+  if (call->op == Opcode::AND) {
+    for (const auto &arg : call->args) {
+      if (!collectConstraints(arg.get(), constraints, variables, isFalse)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (call->op == Opcode::ANY) {
+    for (const auto &arg : call->args) {
+      if (arg->exprType != ExprType::SYMVAR) {
+        return false;
+      }
+      variables.insert(dynamic_cast<const SymVar *>(arg.get())->getNum());
+    }
+    return true;
+  }
+
+  LinearTerm left, right;
+  if (call->args.size() != 2 || !toLinear(call->args[0].get(), left) ||
+      !toLinear(call->args[1].get(), right)) {
+    return false;
+  }
+  // Every comparison as term <= 0 or term == 0, with term built from
+  // left - right
+  LinearConstraint constraint;
+  constraint.isEquality = call->op == Opcode::EQ;
+  long long sign, offset;
+  switch (call->op) {
+  case Opcode::EQ:
+  case Opcode::LE:
+    sign = 1, offset = 0;
+    break;
+  case Opcode::LT:
+    sign = 1, offset = 1;
+    break;
+  case Opcode::GE:
+    sign = -1, offset = 0;
+    break;
+  case Opcode::GT:
+    sign = -1, offset = 1;
+    break;
+  default:
+    return false;
+  }
+  LinearTerm offsetTerm;
+  offsetTerm.constant = offset;
+  if (!addScaled(constraint.term, left, sign) ||
+      !addScaled(constraint.term, right, -sign) ||
+      !addScaled(constraint.term, offsetTerm, 1)) {
+    return false;
+  }
+  for (const auto &entry : constraint.term.coeffs) {
+    variables.insert(entry.first);
+  }
+  constraints.push_back(constraint);
+  return true;
+}
+
+// Rounding of a / b towards -infinity and +infinity, b != 0
+long long floorDiv(long long a, long long b) {
+  long long q = a / b;
+  return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+long long ceilDiv(long long a, long long b) {
+  long long q = a / b;
+  return (a % b != 0 && (a < 0) == (b < 0)) ? q + 1 : q;
+}
+
+} // namespace
+
+// ============================================================================
+// LinearFastPath Implementation
+// ============================================================================
+
+bool LinearFastPath::decide(const vector<Expr *> &conjuncts, bool &isSat,
+                            NumberedModel &model) {
+  vector<LinearConstraint> constraints;
+  set<unsigned int> variables;
+  bool isFalse = false;
+  for (const Expr *conjunct : conjuncts) {
+    if (!collectConstraints(conjunct, constraints, variables, isFalse)) {
+      return false;
+    }
+  }
+  auto unsat = [&isSat] {
+    isSat = false;
+    return true;
+  };
+  if (isFalse) {
+    return unsat();
+  }
+
+  // Solve each equality for a variable with a unit coefficient and
+  // substitute it everywhere else
+  vector<pair<unsigned int, LinearTerm>> definitions; // X<n> = term
+  for (size_t i = 0; i < constraints.size(); i++) {
+    if (!constraints[i].isEquality) {
+      continue;
+    }
+    const LinearTerm &term = constraints[i].term;
+    if (term.coeffs.empty()) {
+      if (term.constant != 0) {
+        return unsat();
+      }
+      continue;
+    }
+    auto unit = term.coeffs.begin();
+    while (unit != term.coeffs.end() && unit->second != 1 &&
+           unit->second != -1) {
+      ++unit;
+    }
+    if (unit == term.coeffs.end()) {
+      return false;
+    }
+    // c * X + rest == 0 with c = +-1, so X = -c * rest
+    unsigned int var = unit->first;
+    long long coeff = unit->second;
+    LinearTerm definition;
+    LinearTerm rest = term;
+    rest.coeffs.erase(var);
+    if (!addScaled(definition, rest, -coeff)) {
+      return false;
+    }
+    // Equalities before this one are definitions already
+    for (size_t j = 0; j < constraints.size(); j++) {
+      if (j == i || (j < i && constraints[j].isEquality)) {
+        continue;
+      }
+      LinearTerm &other = constraints[j].term;
+      auto entry = other.coeffs.find(var);
+      if (entry == other.coeffs.end()) {
+        continue;
+      }
+      long long factor = entry->second;
+      other.coeffs.erase(entry);
+      if (!addScaled(other, definition, factor)) {
+        return false;
+      }
+    }
+    definitions.emplace_back(var, definition);
+  }
+
+  // What is left are bounds on single variables
+  map<unsigned int, long long> lower, upper;
+  for (const LinearConstraint &constraint : constraints) {
+    if (constraint.isEquality) {
+      continue;
+    }
+    const LinearTerm &term = constraint.term;
+    if (term.coeffs.empty()) {
+      if (term.constant > 0) {
+        return unsat();
+      }
+      continue;
+    }
+    if (term.coeffs.size() > 1) {
+      return false;
+    }
+    // a * X + c <= 0
+    unsigned int var = term.coeffs.begin()->first;
+    long long a = term.coeffs.begin()->second;
+    if (term.constant == LLONG_MIN) {
+      return false;
+    }
+    if (a > 0) {
+      long long bound = floorDiv(-term.constant, a);
+      auto it = upper.find(var);
+      upper[var] = it == upper.end() ? bound : min(it->second, bound);
+    } else {
+      long long bound = ceilDiv(-term.constant, a);
+      auto it = lower.find(var);
+      lower[var] = it == lower.end() ? bound : max(it->second, bound);
+    }
+  }
+
+  // Free variables take the value nearest to 0 within their bounds, then
+  // the definitions give the others, the last one first
+  map<unsigned int, long long> values;
+  set<unsigned int> defined;
+  for (const auto &definition : definitions) {
+    defined.insert(definition.first);
+  }
+  for (unsigned int var : variables) {
+    if (defined.count(var) > 0) {
+      continue;
+    }
+    long long value = 0;
+    auto lo = lower.find(var);
+    auto hi = upper.find(var);
+    if (lo != lower.end() && hi != upper.end() && lo->second > hi->second) {
+      return unsat();
+    }
+    if (lo != lower.end() && value < lo->second) {
+      value = lo->second;
+    }
+    if (hi != upper.end() && value > hi->second) {
+      value = hi->second;
+    }
+    values[var] = value;
+  }
+  for (auto it = definitions.rbegin(); it != definitions.rend(); ++it) {
+    long long value = it->second.constant;
+    for (const auto &entry : it->second.coeffs) {
+      long long product;
+      if (__builtin_mul_overflow(entry.second, values.at(entry.first),
+                                 &product) ||
+          __builtin_add_overflow(value, product, &value)) {
+        return false;
+      }
+    }
+    values[it->first] = value;
+  }
+
+  for (const auto &entry : values) {
+    if (entry.second < INT_MIN || entry.second > INT_MAX) {
+      return false;
+    }
+  }
+  isSat = true;
+  for (const auto &entry : values) {
+    model.symVars[entry.first] =
+        make_unique<IntResultValue>(static_cast<int>(entry.second));
+  }
+  return true;
+}
+
+unique_ptr<Result> LinearFastPath::solve(const vector<Expr *> &conjuncts) {
+  bool isSat;
+  NumberedModel model;
+  if (!decide(conjuncts, isSat, model)) {
+    return nullptr;
+  }
+  return make_unique<Result>(isSat, toNamedModel(model));
+}
+
+// ============================================================================
+// FastPathSolver Implementation
+// ============================================================================
+
+FastPathSolver::FastPathSolver(TypeMap *tm)
+    : fallback(tm), fastAnswers(0), fallbacks(0) {}
+
+Result FastPathSolver::solve(unique_ptr<Expr> formula) const {
+  if (unique_ptr<Result> fast = LinearFastPath::solve({formula.get()})) {
+    fastAnswers++;
+    TRACE(INFO, "[FastPath] " << statusName(fast->status));
+    return Result(fast->status, copyModel(fast->model));
+  }
+  fallbacks++;
+  return fallback.solve(std::move(formula));
+}
@@ -0,0 +1,46 @@
+#ifndef FASTPATH_HH
+#define FASTPATH_HH
+
+#include <memory>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "solver.hh"
+#include "z3solver.hh"
+
+using namespace std;
+
+// Decides small linear integer constraints without Z3. The fragment is
+// conjunctions (and, true, false, Any) of eq/lt/gt/le/ge between sums of
+// SymVars, integers, and products with an integer. Equalities are solved by
+// substitution, which needs a variable with coefficient 1 or -1 in each;
+// what remains must be bounds on single variables. Each free variable takes
+// the value nearest to 0 within its bounds, as Z3 tends to do. The built-ins
+// keep their standard meaning here, whatever the Z3OperatorRegistry says.
+class LinearFastPath {
+public:
+  // false if a conjunct is outside the fragment, or a value does not fit
+  // in an int
+  static bool decide(const vector<Expr *> &conjuncts, bool &isSat,
+                     NumberedModel &model);
+  // decide as a Result; nullptr where decide is false
+  static unique_ptr<Result> solve(const vector<Expr *> &conjuncts);
+};
+
+// Solver that answers from LinearFastPath when it can and from Z3Solver
+// otherwise
+class FastPathSolver : public Solver {
+private:
+  Z3Solver fallback;
+  mutable unsigned int fastAnswers;
+  mutable unsigned int fallbacks;
+
+public:
+  FastPathSolver(TypeMap *typeMap = nullptr);
+  Result solve(unique_ptr<Expr>) const;
+  Z3Solver &getFallback() { return fallback; }
+  unsigned int getFastAnswers() const { return fastAnswers; }
+  unsigned int getFallbacks() const { return fallbacks; }
+};
+
+#endif
@@ -0,0 +1,411 @@
+#include "folder.hh"
+#include <algorithm>
+#include <climits>
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+namespace {
+
+const Num *asNum(const Expr *expr) {
+  return expr->exprType == ExprType::NUM ? dynamic_cast<const Num *>(expr)
+                                         : nullptr;
+}
+
+const Bool *asBool(const Expr *expr) {
+  return expr->exprType == ExprType::BOOL ? dynamic_cast<const Bool *>(expr)
+                                          : nullptr;
+}
+
+const String *asString(const Expr *expr) {
+  return expr->exprType == ExprType::STRING
+             ? dynamic_cast<const String *>(expr)
+             : nullptr;
+}
+
+// The elements of a set literal of scalars of one type, without duplicates,
+// in order. Canonical scalars are equal iff their pointers are.
+bool scalarElements(const Expr *expr, vector<Expr *> &elements) {
+  if (expr->exprType != ExprType::SET) {
+    return false;
+  }
+  for (const auto &element : dynamic_cast<const Set *>(expr)->elements) {
+    if (!ConstantFolder::isScalar(element.get()) ||
+        (!elements.empty() &&
+         element->exprType != elements.front()->exprType)) {
+      return false;
+    }
+    if (find(elements.begin(), elements.end(), element.get()) ==
+        elements.end()) {
+      elements.push_back(element.get());
+    }
+  }
+  return true;
+}
+
+// Whether a scalar may be compared with the elements of a set: Z3 sorts a
+// set literal by its first element
+bool sameSort(const vector<Expr *> &elements, const Expr *scalar) {
+  return elements.empty() || elements.front()->exprType == scalar->exprType;
+}
+
+bool sameSort(const vector<Expr *> &a, const vector<Expr *> &b) {
+  return a.empty() || b.empty() || a.front()->exprType == b.front()->exprType;
+}
+
+bool contains(const vector<Expr *> &elements, const Expr *element) {
+  return find(elements.begin(), elements.end(), element) != elements.end();
+}
+
+// Key of a map literal: the name of an unbound variable, or a string
+bool mapKey(const Expr *expr, string &key) {
+  if (expr->exprType == ExprType::VAR) {
+    key = dynamic_cast<const Var *>(expr)->name;
+    return true;
+  }
+  if (const String *s = asString(expr)) {
+    key = s->value;
+    return true;
+  }
+  return false;
+}
+
+// Integer division as in SMT-LIB: the remainder is never negative
+long long euclideanDiv(long long a, long long b) {
+  long long q = a / b;
+  if (a % b < 0) {
+    q += b > 0 ? -1 : 1;
+  }
+  return q;
+}
+
+Expr *foldArithmetic(ExprFactory &factory, Opcode op, const Num *a,
+                     const Num *b) {
+  long long x = a->value, y = b->value, result;
+  switch (op) {
+  case Opcode::ADD:
+    result = x + y;
+    break;
+  case Opcode::SUB:
+    result = x - y;
+    break;
+  case Opcode::MUL:
+    result = x * y;
+    break;
+  case Opcode::DIV:
+    if (y == 0) {
+      return nullptr;
+    }
+    result = euclideanDiv(x, y);
+    break;
+  default:
+    return nullptr;
+  }
+  if (result < INT_MIN || result > INT_MAX) {
+    return nullptr;
+  }
+  return factory.num(static_cast<int>(result));
+}
+
+Expr *foldComparison(ExprFactory &factory, Opcode op, const Num *a,
+                     const Num *b) {
+  switch (op) {
+  case Opcode::LT:
+    return factory.boolean(a->value < b->value);
+  case Opcode::GT:
+    return factory.boolean(a->value > b->value);
+  case Opcode::LE:
+    return factory.boolean(a->value <= b->value);
+  case Opcode::GE:
+    return factory.boolean(a->value >= b->value);
+  default:
+    return nullptr;
+  }
+}
+
+// nullptr if the values cannot be compared without the solver
+Expr *foldEquality(ExprFactory &factory, Expr *a, Expr *b, bool equal) {
+  if (ConstantFolder::isScalar(a) && ConstantFolder::isScalar(b)) {
+    if (a->exprType != b->exprType) {
+      return nullptr;
+    }
+    return factory.boolean((a == b) == equal);
+  }
+  vector<Expr *> x, y;
+  if (!scalarElements(a, x) || !scalarElements(b, y) || !sameSort(x, y)) {
+    return nullptr;
+  }
+  bool same = x.size() == y.size() &&
+              all_of(x.begin(), x.end(),
+                     [&y](Expr *element) { return contains(y, element); });
+  return factory.boolean(same == equal);
+}
+
+Expr *foldLogic(ExprFactory &factory, Opcode op, const vector<Expr *> &args) {
+  const Bool *a = asBool(args[0]);
+  if (op == Opcode::NOT) {
+    return a ? factory.boolean(!a->value) : nullptr;
+  }
+  const Bool *b = asBool(args[1]);
+  switch (op) {
+  case Opcode::AND:
+    if (a) {
+      return a->value ? args[1] : args[0];
+    }
+    if (b) {
+      return b->value ? args[0] : args[1];
+    }
+    return nullptr;
+  case Opcode::OR:
+    if (a) {
+      return a->value ? args[0] : args[1];
+    }
+    if (b) {
+      return b->value ? args[1] : args[0];
+    }
+    return nullptr;
+  case Opcode::IMPLIES:
+    if (a) {
+      return a->value ? args[1] : factory.boolean(true);
+    }
+    if (b) {
+      return b->value ? args[1]
+                      : ConstantFolder::call(factory, "Not", {args[0]});
+    }
+    return nullptr;
+  default:
+    return nullptr;
+  }
+}
+
+Expr *foldSet(ExprFactory &factory, Opcode op, const vector<Expr *> &args) {
+  if (op == Opcode::IS_EMPTY_SET) {
+    // Also with symbolic elements
+    if (args[0]->exprType != ExprType::SET) {
+      return nullptr;
+    }
+    return factory.boolean(
+        dynamic_cast<const Set *>(args[0])->elements.empty());
+  }
+
+  vector<Expr *> elements;
+  switch (op) {
+  case Opcode::IN:
+  case Opcode::NOT_IN:
+    if (!ConstantFolder::isScalar(args[0]) ||
+        !scalarElements(args[1], elements) || !sameSort(elements, args[0])) {
+      return nullptr;
+    }
+    return factory.boolean(contains(elements, args[0]) == (op == Opcode::IN));
+  case Opcode::ADD_TO_SET:
+  case Opcode::REMOVE_FROM_SET:
+    if (!ConstantFolder::isScalar(args[1]) ||
+        !scalarElements(args[0], elements) || !sameSort(elements, args[1])) {
+      return nullptr;
+    }
+    if (op == Opcode::REMOVE_FROM_SET) {
+      elements.erase(remove(elements.begin(), elements.end(), args[1]),
+                     elements.end());
+    } else if (!contains(elements, args[1])) {
+      elements.push_back(args[1]);
+    }
+    return factory.set(elements);
+  default:
+    break;
+  }
+
+  vector<Expr *> other;
+  if (!scalarElements(args[0], elements) ||
+      !scalarElements(args[1], other) || !sameSort(elements, other)) {
+    return nullptr;
+  }
+  vector<Expr *> result;
+  switch (op) {
+  case Opcode::UNION:
+    result = elements;
+    for (Expr *element : other) {
+      if (!contains(result, element)) {
+        result.push_back(element);
+      }
+    }
+    return factory.set(result);
+  case Opcode::INTERSECT:
+  case Opcode::DIFFERENCE:
+    for (Expr *element : elements) {
+      if (contains(other, element) == (op == Opcode::INTERSECT)) {
+        result.push_back(element);
+      }
+    }
+    return factory.set(result);
+  case Opcode::SUBSET:
+    return factory.boolean(all_of(
+        elements.begin(), elements.end(),
+        [&other](Expr *element) { return contains(other, element); }));
+  default:
+    return nullptr;
+  }
+}
+
+Expr *foldMap(ExprFactory &factory, Opcode op, const vector<Expr *> &args) {
+  string key;
+  if (args[0]->exprType != ExprType::MAP || !mapKey(args[1], key)) {
+    return nullptr;
+  }
+  const Map *map = dynamic_cast<const Map *>(args[0]);
+  vector<pair<string, Expr *>> entries;
+  Expr *found = nullptr;
+  for (const auto &entry : map->value) {
+    entries.push_back(make_pair(entry.first->name, entry.second.get()));
+    if (entry.first->name == key) {
+      found = entry.second.get();
+    }
+  }
+  switch (op) {
+  case Opcode::GET:
+    return found;
+  case Opcode::CONTAINS_KEY:
+    return factory.boolean(found != nullptr);
+  case Opcode::PUT:
+    if (found) {
+      for (auto &entry : entries) {
+        if (entry.first == key) {
+          entry.second = args[2];
+        }
+      }
+    } else {
+      entries.push_back(make_pair(key, args[2]));
+    }
+    return factory.map(entries);
+  default:
+    return nullptr;
+  }
+}
+
+Expr *foldSequence(ExprFactory &factory, Opcode op,
+                   const vector<Expr *> &args) {
+  const String *a = asString(args[0]);
+  if (!a) {
+    return nullptr;
+  }
+  if (op == Opcode::LENGTH) {
+    if (a->value.size() > INT_MAX) {
+      return nullptr;
+    }
+    return factory.num(static_cast<int>(a->value.size()));
+  }
+  if (op == Opcode::AT) {
+    // Out of range gives the empty sequence
+    const Num *index = asNum(args[1]);
+    if (!index) {
+      return nullptr;
+    }
+    if (index->value < 0 || (size_t)index->value >= a->value.size()) {
+      return factory.str("");
+    }
+    return factory.str(a->value.substr(index->value, 1));
+  }
+
+  const String *b = asString(args[1]);
+  if (!b) {
+    return nullptr;
+  }
+  const string &x = a->value, &y = b->value;
+  switch (op) {
+  case Opcode::CONCAT:
+    return factory.str(x + y);
+  case Opcode::PREFIX:
+    return factory.boolean(x.size() <= y.size() &&
+                           y.compare(0, x.size(), x) == 0);
+  case Opcode::SUFFIX:
+    return factory.boolean(x.size() <= y.size() &&
+                           y.compare(y.size() - x.size(), x.size(), x) == 0);
+  case Opcode::CONTAINS_SEQ:
+    return factory.boolean(x.find(y) != string::npos);
+  default:
+    return nullptr;
+  }
+}
+
+} // namespace
+
+// ============================================================================
+// ConstantFolder
+// ============================================================================
+
+bool ConstantFolder::isScalar(const Expr *expr) {
+  return expr->exprType == ExprType::NUM ||
+         expr->exprType == ExprType::BOOL ||
+         expr->exprType == ExprType::STRING;
+}
+
+Expr *ConstantFolder::call(ExprFactory &factory, const string &name,
+                           const vector<Expr *> &args) {
+  Opcode op = OpcodeTable::lookup(name);
+  return call(factory, op,
+              op == Opcode::API ? ApiRegistry::intern(name) : NO_API_ID, name,
+              args);
+}
+
+Expr *ConstantFolder::call(ExprFactory &factory, Opcode op, ApiId apiId,
+                           const string &name, const vector<Expr *> &args) {
+  Expr *result = nullptr;
+  if (op != Opcode::API &&
+      OpcodeTable::arity(op) == static_cast<int>(args.size())) {
+    switch (op) {
+    case Opcode::ADD:
+    case Opcode::SUB:
+    case Opcode::MUL:
+    case Opcode::DIV:
+      if (asNum(args[0]) && asNum(args[1])) {
+        result = foldArithmetic(factory, op, asNum(args[0]), asNum(args[1]));
+      }
+      break;
+    case Opcode::LT:
+    case Opcode::GT:
+    case Opcode::LE:
+    case Opcode::GE:
+      if (asNum(args[0]) && asNum(args[1])) {
+        result = foldComparison(factory, op, asNum(args[0]), asNum(args[1]));
+      }
+      break;
+    case Opcode::EQ:
+    case Opcode::NEQ:
+      result = foldEquality(factory, args[0], args[1], op == Opcode::EQ);
+      break;
+    case Opcode::AND:
+    case Opcode::OR:
+    case Opcode::NOT:
+    case Opcode::IMPLIES:
+      result = foldLogic(factory, op, args);
+      break;
+    case Opcode::IN:
+    case Opcode::NOT_IN:
+    case Opcode::UNION:
+    case Opcode::INTERSECT:
+    case Opcode::DIFFERENCE:
+    case Opcode::SUBSET:
+    case Opcode::ADD_TO_SET:
+    case Opcode::REMOVE_FROM_SET:
+    case Opcode::IS_EMPTY_SET:
+      result = foldSet(factory, op, args);
+      break;
+    case Opcode::GET:
+    case Opcode::PUT:
+    case Opcode::CONTAINS_KEY:
+      result = foldMap(factory, op, args);
+      break;
+    case Opcode::CONCAT:
+    case Opcode::LENGTH:
+    case Opcode::AT:
+    case Opcode::PREFIX:
+    case Opcode::SUFFIX:
+    case Opcode::CONTAINS_SEQ:
+      result = foldSequence(factory, op, args);
+      break;
+    default:
+      break;
+    }
+  }
+  return result ? result : factory.funcCall(op, apiId, name, args);
+}
@@ -0,0 +1,39 @@
+#ifndef FOLDER_HH
+#define FOLDER_HH
+
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "../language/exprfactory.hh"
+
+using namespace std;
+
+// Evaluates built-in calls whose arguments are constants, so that SEE does
+// not hand the solver terms such as add(3, 4) or gt(9, 0). Folds:
+//  - arithmetic and comparison on integers, equality on integers, strings,
+//    booleans and sets of them;
+//  - and, or, implies and not, also where only one side is a constant, e.g.
+//    and(false, x) to false and and(true, x) to x;
+//  - the set operations on set literals of constants, and is_empty_set on
+//    any set literal;
+//  - get, put and contains_key on map literals, whose keys are names;
+//  - the sequence operations on strings.
+// Anything else, including API calls, input() and Any, is built as is. As in
+// LinearFastPath, the built-ins keep their standard meaning here, whatever
+// the Z3OperatorRegistry says.
+class ConstantFolder {
+public:
+  // The canonical value of name(args) if it folds, the canonical call
+  // otherwise. op and apiId are those of name, e.g. taken from the FuncCall
+  // being evaluated. The arguments must be canonical nodes of the factory.
+  static Expr *call(ExprFactory &factory, Opcode op, ApiId apiId,
+                    const string &name, const vector<Expr *> &args);
+  // The same for a built-in named in the code, e.g. "Not"
+  static Expr *call(ExprFactory &factory, const string &name,
+                    const vector<Expr *> &args);
+  // An integer, boolean or string literal
+  static bool isScalar(const Expr *expr);
+};
+
+#endif
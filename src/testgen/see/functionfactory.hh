@@ -17,7 +17,14 @@ class Function {
 
 class FunctionFactory {
     public:
+        virtual ~FunctionFactory() = default;
         virtual unique_ptr<Function> getFunction(string fname, vector<Expr*> args) = 0;
+        // Looks the function up by the ID its FuncCall interned at parse
+        // time (FuncCall::apiId). Factories that do not index their
+        // functions by ID fall back to the name.
+        virtual unique_ptr<Function> getFunction(ApiId id, vector<Expr*> args) {
+            return getFunction(ApiRegistry::name(id), args);
+        }
 
     protected:
 };
@@ -0,0 +1,104 @@
+#include "independence.hh"
+#include "../language/symvar.hh"
+#include <map>
+
+void collectVariables(const Expr *expr, set<unsigned int> &symVars,
+                      set<string> &vars) {
+  switch (expr->exprType) {
+  case ExprType::SYMVAR:
+    symVars.insert(dynamic_cast<const SymVar *>(expr)->getNum());
+    break;
+  case ExprType::VAR:
+    vars.insert(dynamic_cast<const Var *>(expr)->name);
+    break;
+  case ExprType::FUNC_CALL_EXPR:
+    for (const auto &arg : dynamic_cast<const FuncCall *>(expr)->args) {
+      collectVariables(arg.get(), symVars, vars);
+    }
+    break;
+  case ExprType::SET:
+    for (const auto &elem : dynamic_cast<const Set *>(expr)->elements) {
+      collectVariables(elem.get(), symVars, vars);
+    }
+    break;
+  case ExprType::TUPLE:
+    for (const auto &e : dynamic_cast<const Tuple *>(expr)->exprs) {
+      collectVariables(e.get(), symVars, vars);
+    }
+    break;
+  case ExprType::MAP:
+    // Keys are field names, not variables
+    for (const auto &kv : dynamic_cast<const Map *>(expr)->value) {
+      collectVariables(kv.second.get(), symVars, vars);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+namespace {
+
+size_t findRoot(vector<size_t> &parent, size_t i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+// One kind of variable of conjunct i, see partitionConstraints
+template <typename Variable>
+void joinFirstUses(vector<size_t> &parent, size_t i,
+                   const set<Variable> &variables,
+                   map<Variable, size_t> &firstUse) {
+  for (const Variable &var : variables) {
+    auto it = firstUse.find(var);
+    if (it == firstUse.end()) {
+      firstUse.emplace(var, i);
+      continue;
+    }
+    size_t a = findRoot(parent, i);
+    size_t b = findRoot(parent, it->second);
+    // The root is the earliest conjunct, which orders the groups
+    if (a < b) {
+      parent[b] = a;
+    } else {
+      parent[a] = b;
+    }
+  }
+}
+
+} // namespace
+
+vector<ConstraintGroup> partitionConstraints(const vector<Expr *> &conjuncts) {
+  // Union-find over the conjuncts: a conjunct is joined with the first
+  // conjunct that mentioned each of its variables
+  vector<size_t> parent(conjuncts.size());
+  vector<set<unsigned int>> symVars(conjuncts.size());
+  vector<set<string>> vars(conjuncts.size());
+  map<unsigned int, size_t> firstSymVarUse;
+  map<string, size_t> firstVarUse;
+  for (size_t i = 0; i < conjuncts.size(); i++) {
+    parent[i] = i;
+    collectVariables(conjuncts[i], symVars[i], vars[i]);
+    joinFirstUses(parent, i, symVars[i], firstSymVarUse);
+    joinFirstUses(parent, i, vars[i], firstVarUse);
+  }
+
+  vector<ConstraintGroup> groups;
+  map<size_t, size_t> groupOfRoot;
+  for (size_t i = 0; i < conjuncts.size(); i++) {
+    size_t root = findRoot(parent, i);
+    auto it = groupOfRoot.find(root);
+    if (it == groupOfRoot.end()) {
+      it = groupOfRoot.emplace(root, groups.size()).first;
+      groups.push_back(ConstraintGroup());
+    }
+    ConstraintGroup &group = groups[it->second];
+    group.conjuncts.push_back(conjuncts[i]);
+    group.symVars.insert(symVars[i].begin(), symVars[i].end());
+    group.vars.insert(vars[i].begin(), vars[i].end());
+  }
+  return groups;
+}
@@ -0,0 +1,32 @@
+#ifndef INDEPENDENCE_HH
+#define INDEPENDENCE_HH
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+
+using namespace std;
+
+// Constraint independence, as in KLEE: two conjuncts of a path constraint
+// depend on each other if they share a variable, directly or through other
+// conjuncts. Groups of independent conjuncts can be solved separately and
+// a model of the whole constraint is the union of the groups' models.
+struct ConstraintGroup {
+  vector<Expr *> conjuncts;   // in path constraint order
+  set<unsigned int> symVars;  // by number
+  set<string> vars;           // named variables
+};
+
+// Variables an expression refers to: SymVars by number, named variables by
+// name
+void collectVariables(const Expr *expr, set<unsigned int> &symVars,
+                      set<string> &vars);
+
+// Partitions the conjuncts into groups with pairwise disjoint variable sets.
+// Groups are ordered by their first conjunct. A conjunct without variables
+// forms a group of its own.
+vector<ConstraintGroup> partitionConstraints(const vector<Expr *> &conjuncts);
+
+#endif
@@ -0,0 +1,202 @@
+#include "portfolio.hh"
+#include "../util/trace.hh"
+#include "z3pool.hh"
+#include "z3solver.hh"
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+// ============================================================================
+// Race
+// ============================================================================
+
+namespace {
+
+// State shared by the configurations racing on one query
+struct Race {
+  mutex lock;
+  condition_variable changed;
+  size_t running; // configurations whose thread has not finished
+  bool over;      // decided, given up on or out of time
+  int winner;     // -1 while undecided
+  SolverStatus status;
+  map<string, unique_ptr<ResultValue>> model;
+  // Context of each configuration while its check may be running
+  vector<z3::context *> checking;
+  exception_ptr error; // first failure other than Z3 giving up
+
+  Race(size_t numConfigs)
+      : running(numConfigs), over(false), winner(-1),
+        status(SolverStatus::UNKNOWN), checking(numConfigs, nullptr) {}
+};
+
+} // namespace
+
+// Run one configuration on the formula and, if it decides first, store its
+// answer in the race.
+static void runConfig(const PortfolioConfig &config, size_t index,
+                      Expr *formula, TypeMap *typeMap,
+                      const SolverBudget &budget, Race &race) {
+  {
+    // The lease must outlive every Z3 object of the configuration
+    Z3ContextPool::Lease lease = Z3ContextPool::getInstance().acquire();
+    z3::context &ctx = lease->getContext();
+    try {
+      Z3InputMaker inputMaker(ctx, typeMap);
+      z3::expr z3Formula = inputMaker.makeZ3Input(formula);
+      z3::solver s = config.tactic.empty()
+                         ? z3::solver(ctx)
+                         : z3::tactic(ctx, config.tactic.c_str()).mk_solver();
+      z3::params params(ctx);
+      params.set("random_seed", config.seed);
+      params.set("max_memory",
+                 budget.memoryMb > 0 ? budget.memoryMb : UINT_MAX);
+      s.set(params);
+      s.add(z3Formula);
+
+      bool started;
+      {
+        lock_guard<mutex> guard(race.lock);
+        started = !race.over;
+        if (started) {
+          race.checking[index] = &ctx;
+        }
+      }
+      if (started) {
+        z3::check_result result = s.check();
+        lease->noteQuery(result);
+        lock_guard<mutex> guard(race.lock);
+        race.checking[index] = nullptr;
+        if (result == z3::unknown) {
+          TRACE(DEBUG, "[Portfolio] " << config.name << " gave up - "
+                       << s.reason_unknown());
+        } else if (!race.over) {
+          race.over = true;
+          race.winner = index;
+          if (result == z3::sat) {
+            race.status = SolverStatus::SAT;
+            z3::model m = s.get_model();
+            race.model = extractModel(m, inputMaker.getVariables(), ctx);
+          } else {
+            race.status = SolverStatus::UNSAT;
+          }
+          race.changed.notify_all();
+        }
+      }
+    } catch (const z3::exception &e) {
+      // E.g. a tactic that does not apply to the formula
+      TRACE(DEBUG, "[Portfolio] " << config.name << " failed - " << e.msg());
+      lock_guard<mutex> guard(race.lock);
+      race.checking[index] = nullptr;
+    } catch (...) {
+      lock_guard<mutex> guard(race.lock);
+      race.checking[index] = nullptr;
+      if (!race.error) {
+        race.error = current_exception();
+      }
+    }
+  }
+  lock_guard<mutex> guard(race.lock);
+  race.running--;
+  race.changed.notify_all();
+}
+
+// ============================================================================
+// PortfolioSolver Implementation
+// ============================================================================
+
+vector<PortfolioConfig> PortfolioSolver::getDefaultConfigs() {
+  return {{"default", "", 0},
+          {"smt-seed1", "smt", 1},
+          {"qflia", "qflia", 0},
+          {"qfnia", "qfnia", 0}};
+}
+
+PortfolioSolver::PortfolioSolver(TypeMap *tm, vector<PortfolioConfig> c)
+    : typeMap(tm), configs(c), wins(c.size(), 0), lastWinner(-1) {
+  if (configs.empty()) {
+    throw invalid_argument("A portfolio needs at least one configuration");
+  }
+}
+
+Result PortfolioSolver::solve(unique_ptr<Expr> formula) const {
+  Race race(configs.size());
+  vector<thread> threads;
+  for (size_t i = 0; i < configs.size(); i++) {
+    threads.emplace_back(runConfig, cref(configs[i]), i, formula.get(),
+                         typeMap, cref(budget), ref(race));
+  }
+
+  {
+    unique_lock<mutex> guard(race.lock);
+    auto settled = [&race] { return race.over || race.running == 0; };
+    if (budget.queryTimeoutMs > 0 &&
+        !race.changed.wait_for(guard,
+                               chrono::milliseconds(budget.queryTimeoutMs),
+                               settled)) {
+      race.status = SolverStatus::TIMEOUT;
+    } else {
+      race.changed.wait(guard, settled);
+    }
+    race.over = true;
+    // A configuration interrupted just before its check starts would miss
+    // the interrupt, so keep interrupting until every one has stopped
+    while (race.running > 0) {
+      for (z3::context *ctx : race.checking) {
+        if (ctx != nullptr) {
+          ctx->interrupt();
+        }
+      }
+      race.changed.wait_for(guard, chrono::milliseconds(1));
+    }
+  }
+  for (thread &t : threads) {
+    t.join();
+  }
+
+  {
+    lock_guard<mutex> guard(statsLock);
+    lastWinner = race.winner;
+    if (race.winner >= 0) {
+      wins[race.winner]++;
+    }
+  }
+  if (race.winner >= 0) {
+    TRACE(INFO, "[Portfolio] " << configs[race.winner].name << " won - "
+                << statusName(race.status));
+  } else if (race.error) {
+    rethrow_exception(race.error);
+  } else {
+    TRACE(INFO, "[Portfolio] No configuration decided - "
+                << statusName(race.status));
+  }
+  return Result(race.status, std::move(race.model));
+}
+
+map<string, unsigned int> PortfolioSolver::getWins() const {
+  lock_guard<mutex> guard(statsLock);
+  map<string, unsigned int> result;
+  for (size_t i = 0; i < configs.size(); i++) {
+    result[configs[i].name] = wins[i];
+  }
+  return result;
+}
+
+string PortfolioSolver::getLastWinner() const {
+  lock_guard<mutex> guard(statsLock);
+  return lastWinner >= 0 ? configs[lastWinner].name : "";
+}
+
+string PortfolioSolver::getPreferredConfig() const {
+  lock_guard<mutex> guard(statsLock);
+  int best = -1;
+  for (size_t i = 0; i < configs.size(); i++) {
+    if (wins[i] > 0 && (best < 0 || wins[i] > wins[best])) {
+      best = i;
+    }
+  }
+  return best >= 0 ? configs[best].name : "";
+}
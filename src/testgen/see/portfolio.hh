@@ -0,0 +1,59 @@
+#ifndef PORTFOLIO_HH
+#define PORTFOLIO_HH
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../language/typemap.hh"
+#include "solver.hh"
+
+using namespace std;
+
+// One way of running Z3 on a query
+struct PortfolioConfig {
+  string name;
+  string tactic;     // Z3 tactic the solver is built from, empty for Z3's
+                     // default solver
+  unsigned int seed; // random seed, to diversify otherwise equal solvers
+};
+
+// Races several solver configurations on a query: each runs on a thread and
+// a context of its own, leased from the Z3ContextPool. The first SAT or
+// UNSAT answer wins and the other checks are interrupted. A query that no
+// configuration decides is UNKNOWN, or TIMEOUT once the query budget runs
+// out. Wins are counted per configuration, so the configuration that suits
+// the queries of a spec can be read back after a run.
+class PortfolioSolver : public Solver {
+private:
+  TypeMap *typeMap;
+  vector<PortfolioConfig> configs;
+  SolverBudget budget;
+
+  mutable mutex statsLock;
+  mutable vector<unsigned int> wins; // by configuration
+  mutable int lastWinner;            // -1 if the last query was undecided
+
+public:
+  static vector<PortfolioConfig> getDefaultConfigs();
+
+  PortfolioSolver(TypeMap *typeMap = nullptr,
+                  vector<PortfolioConfig> configs = getDefaultConfigs());
+  Result solve(unique_ptr<Expr>) const;
+  // Only the query timeout and the memory limit apply
+  void setBudget(const SolverBudget &b) { budget = b; }
+  const SolverBudget &getBudget() const { return budget; }
+
+  const vector<PortfolioConfig> &getConfigs() const { return configs; }
+  // Number of queries each configuration won, by name
+  map<string, unsigned int> getWins() const;
+  // Name of the configuration that decided the last query, empty if none did
+  string getLastWinner() const;
+  // Name of the configuration with the most wins, the earliest one on a tie;
+  // empty before any win
+  string getPreferredConfig() const;
+};
+
+#endif
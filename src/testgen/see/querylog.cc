@@ -0,0 +1,89 @@
+#include "querylog.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+// ============================================================================
+// QueryLog Implementation
+// ============================================================================
+
+QueryLog::QueryLog(const string &dir) : directory(dir), count(0) {
+  filesystem::create_directories(directory);
+}
+
+void QueryLog::record(const string &smt2, SolverStatus status,
+                      double timeMs) {
+  unsigned int number;
+  {
+    lock_guard<mutex> guard(lock);
+    number = count++;
+  }
+  ostringstream name;
+  name << "query-" << setw(6) << setfill('0') << number << ".smt2";
+  string path = (filesystem::path(directory) / name.str()).string();
+  ofstream out(path);
+  if (!out) {
+    throw runtime_error("Cannot write query log file " + path);
+  }
+  out << "; status: " << statusName(status) << "\n";
+  out << "; time-ms: " << fixed << setprecision(3) << timeMs << "\n";
+  out << smt2;
+}
+
+unsigned int QueryLog::getCount() {
+  lock_guard<mutex> guard(lock);
+  return count;
+}
+
+bool QueryLog::readHeader(const string &path, CapturedQuery &query) {
+  ifstream in(path);
+  string statusLine, timeLine;
+  if (!getline(in, statusLine) || !getline(in, timeLine) ||
+      statusLine.rfind("; status: ", 0) != 0 ||
+      timeLine.rfind("; time-ms: ", 0) != 0) {
+    return false;
+  }
+  string status = statusLine.substr(10);
+  bool known = false;
+  for (SolverStatus s : {SolverStatus::SAT, SolverStatus::UNSAT,
+                         SolverStatus::UNKNOWN, SolverStatus::TIMEOUT}) {
+    if (status == statusName(s)) {
+      query.status = s;
+      known = true;
+    }
+  }
+  query.path = path;
+  query.timeMs = atof(timeLine.substr(11).c_str());
+  return known;
+}
+
+vector<CapturedQuery> QueryLog::collect(const vector<string> &paths) {
+  vector<string> files;
+  for (const string &path : paths) {
+    if (filesystem::is_directory(path)) {
+      vector<string> inDirectory;
+      for (const auto &entry : filesystem::directory_iterator(path)) {
+        if (entry.path().extension() == ".smt2") {
+          inDirectory.push_back(entry.path().string());
+        }
+      }
+      sort(inDirectory.begin(), inDirectory.end());
+      files.insert(files.end(), inDirectory.begin(), inDirectory.end());
+    } else {
+      files.push_back(path);
+    }
+  }
+
+  vector<CapturedQuery> queries;
+  for (const string &file : files) {
+    CapturedQuery query;
+    if (readHeader(file, query)) {
+      queries.push_back(query);
+    }
+  }
+  return queries;
+}
@@ -0,0 +1,45 @@
+#ifndef QUERYLOG_HH
+#define QUERYLOG_HH
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "solver.hh"
+
+using namespace std;
+
+// A query read back from a QueryLog file
+struct CapturedQuery {
+  string path;
+  SolverStatus status; // as captured
+  double timeMs;       // of the captured check
+};
+
+// Captures solver queries as SMT-LIB2 files, so that slow ones can be
+// reproduced outside a pipeline run, e.g. with the replay benchmark
+// (bench/replay.cc). Each query goes to query-<n>.smt2 in the log's
+// directory, numbered in the order the checks finish, and starts with
+// comments giving its result and the time its check took. Thread-safe, so
+// one log can serve the solvers of every worker.
+class QueryLog {
+private:
+  string directory;
+  mutex lock;
+  unsigned int count;
+
+public:
+  // Creates the directory if needed
+  QueryLog(const string &directory);
+  void record(const string &smt2, SolverStatus status, double timeMs);
+  unsigned int getCount();
+  const string &getDirectory() const { return directory; }
+
+  // The header of a captured query; false if the file is not one
+  static bool readHeader(const string &path, CapturedQuery &query);
+  // Captured queries among the paths, directories expanded to the .smt2
+  // files they contain, in name order
+  static vector<CapturedQuery> collect(const vector<string> &paths);
+};
+
+#endif
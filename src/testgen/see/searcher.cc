@@ -0,0 +1,73 @@
+#include "searcher.hh"
+#include <algorithm>
+#include <cmath>
+
+void Searcher::add(unique_ptr<SymbolicState> state) {
+  unsigned long order = added++;
+  double rank = priority(*state, order);
+  heap.push_back(Entry{rank, order, std::move(state)});
+  push_heap(heap.begin(), heap.end(), lower);
+}
+
+unique_ptr<SymbolicState> Searcher::next() {
+  while (!heap.empty()) {
+    pop_heap(heap.begin(), heap.end(), lower);
+    Entry entry = std::move(heap.back());
+    heap.pop_back();
+    if (isOutdated(entry.priority, *entry.state)) {
+      // Priorities only go down, so this ends
+      entry.priority = priority(*entry.state, entry.order);
+      heap.push_back(std::move(entry));
+      push_heap(heap.begin(), heap.end(), lower);
+      continue;
+    }
+    return std::move(entry.state);
+  }
+  return nullptr;
+}
+
+double RandomPathSearcher::priority(const SymbolicState &state,
+                                    unsigned long) {
+  // log(u^(1/w)) = log(u) * 2^d, for u in (0, 1]
+  uniform_real_distribution<double> unit(0.0, 1.0);
+  double u = 1.0 - unit(random);
+  return ldexp(log(u), (int)min<size_t>(state.decisions.size(), 1000));
+}
+
+size_t CoverageSearcher::blockOf(size_t statement) const {
+  if (blockStarts.empty()) {
+    return statement;
+  }
+  auto it = upper_bound(blockStarts.begin(), blockStarts.end(), statement);
+  return it == blockStarts.begin() ? 0 : it - blockStarts.begin() - 1;
+}
+
+bool CoverageSearcher::coversNew(const SymbolicState &state) const {
+  if (state.decisions.empty()) {
+    return true;
+  }
+  const auto &last = state.decisions.back();
+  return coveredChoices.count(make_pair(blockOf(last.first), last.second)) ==
+         0;
+}
+
+void CoverageSearcher::covered(const SymbolicState &state) {
+  for (const auto &decision : state.decisions) {
+    coveredChoices.insert(make_pair(blockOf(decision.first), decision.second));
+  }
+}
+
+unique_ptr<Searcher> makeSearcher(const string &name,
+                                  const vector<size_t> &blockStarts,
+                                  unsigned seed) {
+  if (name == "dfs") {
+    return make_unique<DFSSearcher>();
+  } else if (name == "bfs") {
+    return make_unique<BFSSearcher>();
+  } else if (name == "random") {
+    return make_unique<RandomPathSearcher>(seed);
+  } else if (name == "coverage") {
+    return make_unique<CoverageSearcher>(blockStarts);
+  }
+  return nullptr;
+}
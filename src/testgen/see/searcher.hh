@@ -0,0 +1,126 @@
+#ifndef SEARCHER_HH
+#define SEARCHER_HH
+
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "state.hh"
+
+using namespace std;
+
+// Path exploration strategy: decides which pending state runs next. The
+// pending states are kept in a priority queue; a strategy only says how it
+// ranks a state. States of equal priority run in the order they were added.
+class Searcher {
+  struct Entry {
+    double priority;
+    unsigned long order;
+    unique_ptr<SymbolicState> state;
+  };
+  vector<Entry> heap;
+  unsigned long added;
+
+  static bool lower(const Entry &a, const Entry &b) {
+    return a.priority != b.priority ? a.priority < b.priority
+                                    : a.order > b.order;
+  }
+
+protected:
+  // Higher runs first. order counts the states added before this one.
+  virtual double priority(const SymbolicState &state, unsigned long order) = 0;
+  // Whether a state queued with the given priority must be ranked again,
+  // e.g. because what it would cover has been covered since
+  virtual bool isOutdated(double, const SymbolicState &) { return false; }
+
+public:
+  Searcher() : added(0) {}
+  virtual ~Searcher() = default;
+  virtual string getName() const = 0;
+
+  void add(unique_ptr<SymbolicState> state);
+  // The state to run next, or nullptr if none is left
+  unique_ptr<SymbolicState> next();
+  bool empty() const { return heap.empty(); }
+  // Size of the frontier
+  size_t size() const { return heap.size(); }
+  // A test was generated along the path of the state
+  virtual void covered(const SymbolicState &) {}
+};
+
+// Newest state first: follows one path down before its siblings
+class DFSSearcher : public Searcher {
+protected:
+  double priority(const SymbolicState &, unsigned long order) override {
+    return (double)order;
+  }
+
+public:
+  string getName() const override { return "dfs"; }
+};
+
+// Oldest state first: all paths with k decisions before any with k + 1
+class BFSSearcher : public Searcher {
+protected:
+  double priority(const SymbolicState &, unsigned long order) override {
+    return -(double)order;
+  }
+
+public:
+  string getName() const override { return "bfs"; }
+};
+
+// Random path, as in KLEE: a state with d decisions is as likely as a walk
+// from the root of the execution tree that takes a fair coin at each of
+// them, i.e. has weight 2^-d, so that shallow states are not starved by the
+// many deep ones. Sampled by weighted keys u^(1/w) (Efraimidis-Spirakis),
+// whose largest is the pick.
+class RandomPathSearcher : public Searcher {
+  mt19937 random;
+
+protected:
+  double priority(const SymbolicState &state, unsigned long) override;
+
+public:
+  explicit RandomPathSearcher(unsigned seed = 0) : random(seed) {}
+  string getName() const override { return "random"; }
+};
+
+// Uncovered API block first: a state whose last decision takes a disjunct
+// of a block's precondition that no generated test has taken yet runs
+// before the others. Ties are broken by age, oldest first.
+class CoverageSearcher : public Searcher {
+  // First statement of each block, ascending; empty to count statements
+  vector<size_t> blockStarts;
+  // Taken (block, disjunct) pairs
+  set<pair<size_t, unsigned int>> coveredChoices;
+
+  size_t blockOf(size_t statement) const;
+  bool coversNew(const SymbolicState &state) const;
+
+protected:
+  double priority(const SymbolicState &state, unsigned long) override {
+    return coversNew(state) ? 1 : 0;
+  }
+  bool isOutdated(double queued, const SymbolicState &state) override {
+    return queued > 0 && !coversNew(state);
+  }
+
+public:
+  explicit CoverageSearcher(vector<size_t> blockStarts = {})
+      : blockStarts(std::move(blockStarts)) {}
+  string getName() const override { return "coverage"; }
+  void covered(const SymbolicState &state) override;
+  size_t getCoveredChoices() const { return coveredChoices.size(); }
+};
+
+// The searcher named dfs, bfs, random or coverage; nullptr for any other
+// name. blockStarts is for the coverage searcher, seed for the random one.
+unique_ptr<Searcher> makeSearcher(const string &name,
+                                  const vector<size_t> &blockStarts = {},
+                                  unsigned seed = 0);
+
+#endif
@@ -1,8 +1,9 @@
 #include "./see.hh"
 #include "../language/env.hh" // will change this to normal env.hh later
+#include "folder.hh"
 #include "functionfactory.hh"
-#include <iostream>
-#include <set>
+#include "independence.hh"
+#include "../util/trace.hh"
 using namespace std;
 
 // Helper function to print expressions (raw pointer version)
@@ -32,6 +33,8 @@ static string exprToString(Expr *expr) {
   } else if (expr->exprType == ExprType::STRING) {
     String *str = dynamic_cast<String *>(expr);
     return "\"" + str->value + "\"";
+  } else if (expr->exprType == ExprType::BOOL) {
+    return dynamic_cast<Bool *>(expr)->value ? "true" : "false";
   } else if (expr->exprType == ExprType::SET) {
     Set *set = dynamic_cast<Set *>(expr);
     string result = "{";
@@ -74,36 +77,32 @@ static string exprToString(const unique_ptr<Expr> &expr) {
   return exprToString(expr.get());
 }
 
-unique_ptr<Expr> SEE::computePathConstraint(vector<Expr *> C) {
+Expr *SEE::conjoin(const vector<Expr *> &C) {
   if (C.empty()) {
-    // No constraints, return true (represented as 1 == 1)
-    vector<unique_ptr<Expr>> args;
-    args.push_back(make_unique<Bool>(true));
-    args.push_back(make_unique<Num>(1));
-    return make_unique<FuncCall>("Eq", std::move(args));
-  }
-
-  if (C.size() == 1) {
-    // Single constraint, return it
-    return C[0]->clone();
+    // No constraints
+    return exprFactory->boolean(true);
   }
 
-  // Multiple constraints, conjoin them with AND
-  // For now, we'll create a nested structure: C1 AND (C2 AND (C3 AND ...))
-  unique_ptr<Expr> result = C.back()->clone();
-
-  for (int i = C.size() - 2; i >= 0; i--) {
-    vector<unique_ptr<Expr>> args;
-    args.push_back(C[i]->clone());
-    args.push_back(std::move(result));
-    result = make_unique<FuncCall>("And", std::move(args));
+  // Conjoin the constraints with AND as ((C1 AND C2) AND C3) AND ... The
+  // conjunction is built in the factory, and a path constraint extends the
+  // previous one at the end, so the nodes of its prefix are found again
+  // rather than rebuilt.
+  Expr *result = exprFactory->intern(*C.front());
+  for (size_t i = 1; i < C.size(); i++) {
+    Expr *conjunct = exprFactory->intern(*C[i]);
+    result = exprFactory->funcCall(Opcode::AND, NO_API_ID, "And",
+                                   {result, conjunct});
   }
-
   return result;
 }
 
+unique_ptr<Expr> SEE::computePathConstraint(vector<Expr *> C) {
+  // The caller may keep the formula after the session's factory is gone
+  return ExprFactory::detach(*conjoin(C));
+}
+
 unique_ptr<Expr> SEE::computePathConstraint() {
-  return computePathConstraint(pathConstraint);
+  return computePathConstraint(state.pathConstraint.get().conjuncts);
 }
 
 bool SEE::isReady(Stmt &s, SymbolTable &st) {
@@ -119,15 +118,15 @@ bool SEE::isReady(Stmt &s, SymbolTable &st) {
         // If any argument is symbolic, we need to interrupt and solve first
         for (const auto &arg : fc.args) {
           if (isSymbolic(*arg, st)) {
-            cout << "[SEE] API call '" << fc.name
-                 << "' with symbolic arguments - interruption point" << endl;
+            TRACE(DEBUG, "[SEE] API call '" << fc.name
+                         << "' with symbolic arguments - interruption point");
             return false; // Not ready - need to solve constraints first
           }
         }
 
         // All arguments are concrete, API call is ready for execution
-        cout << "[SEE] API call '" << fc.name << "' ready for actual execution"
-             << endl;
+        TRACE(DEBUG, "[SEE] API call '" << fc.name
+                     << "' ready for actual execution");
         return true;
       } else {
         // Built-in function call, always ready
@@ -140,6 +139,9 @@ bool SEE::isReady(Stmt &s, SymbolTable &st) {
   } else if (s.statementType == StmtType::ASSUME) {
     Assume &assume = dynamic_cast<Assume &>(s);
     return isReady(*assume.expr, st);
+  } else if (s.statementType == StmtType::ASSERT) {
+    // Checked when the test runs, see executeStmt
+    return true;
   } else if (s.statementType == StmtType::DECL) {
     // Declaration statements are always ready
     return true;
@@ -154,7 +156,7 @@ bool SEE::isReady(Expr &e, SymbolTable &st) {
 
     // Special case: input() with no arguments IS ready for symbolic execution
     // It will create a new symbolic variable
-    if (fc.name == "input" && fc.args.size() == 0) {
+    if (fc.op == Opcode::INPUT && fc.args.size() == 0) {
       return true;
     }
 
@@ -183,7 +185,7 @@ bool SEE::isReady(Expr &e, SymbolTable &st) {
     }
     return true;
   }
-  if (e.exprType == ExprType::NUM) {
+  if (e.exprType == ExprType::NUM || e.exprType == ExprType::BOOL) {
     return true;
   }
   if (e.exprType == ExprType::SET) {
@@ -215,6 +217,7 @@ bool SEE::isReady(Expr &e, SymbolTable &st) {
     // Variables are ready if they're bound in sigma
     Var &var = dynamic_cast<Var &>(e);
 
+    const ValueEnvironment &sigma = state.sigma;
     if (sigma.hasValue(var.name) == false) {
       return false;
     } else {
@@ -231,31 +234,8 @@ bool SEE::isReady(Expr &e, SymbolTable &st) {
 }
 
 bool SEE::isAPI(const FuncCall &fc) {
-  // Built-in functions that are NOT API calls
-  static const set<string> builtInFunctions = {
-      // Arithmetic
-      "add", "sub", "mul", "div",
-      // Comparison
-      "eq", "lt", "gt", "le", "ge", "neq", "=", "==", "!=", "<>", "<", ">",
-      "<=", ">=",
-      // Logical
-      "and", "or", "not", "implies", "and", "or", "not", "&&", "||", "!",
-      // Input
-      "input",
-      // Set operations
-      "in", "not_in", "member", "not_member", "contains", "not_contains",
-      "union", "intersection", "intersect", "difference", "diff", "minus",
-      "subset", "is_subset", "add_to_set", "remove_from_set", "is_empty_set",
-      // Map operations
-      "get", "put", "lookup", "select", "store", "update", "contains_key",
-      "has_key",
-      // List/Sequence operations
-      "concat", "append_list", "length", "at", "nth", "prefix", "suffix",
-      "contains_seq",
-      // Prime notation (for postconditions)
-      "'"};
-
-  return builtInFunctions.find(fc.name) == builtInFunctions.end();
+  // Built-ins, including input() and prime notation, have their own opcode
+  return fc.op == Opcode::API;
 }
 
 bool SEE::isSymbolic(Expr &e, SymbolTable &st) {
@@ -300,6 +280,7 @@ bool SEE::isSymbolic(Expr &e, SymbolTable &st) {
   } else if (e.exprType == ExprType::VAR) {
     Var &var = dynamic_cast<Var &>(e);
     // Look up the variable in sigma to see if its value is symbolic
+    const ValueEnvironment &sigma = state.sigma;
     if (sigma.hasValue(var.name)) {
       Expr *val = sigma.getValue(var.name);
       return isSymbolic(*val, st);
@@ -325,11 +306,90 @@ void SEE::execute(Program &pg, SymbolTable &st) {
   // σ is represented by sigma (already a member variable)
 
   // Clear previous state
-  pathConstraint.clear();
+  SymbolicState fresh;
+  fresh.sigma = state.sigma;
+  fresh.apiCalls = applicationCalls;
+  state = fresh;
+  checkpoint.reset();
+  forks.clear();
+
+  run(pg, st, 0);
+}
+
+void SEE::beginSession(shared_ptr<ExprFactory> factory) {
+  state = SymbolicState();
+  checkpoint.reset();
+  forks.clear();
+  applicationCalls = 0;
+  symVars.reset();
+  exprFactory = factory ? factory : make_shared<ExprFactory>();
+}
+
+void SEE::resume(Program &pg, SymbolTable &st) {
+  if (!checkpoint) {
+    execute(pg, st);
+    return;
+  }
+  if (checkpoint->pc > pg.statements.size()) {
+    throw runtime_error("SEE::resume: checkpoint is past the end of the program");
+  }
+
+  state = *checkpoint;
+  state.pendingInputs = CopyOnWrite<vector<pair<size_t, unsigned int>>>();
+
+  // Bind the SymVar of every input statement that has been made concrete
+  map<unsigned int, Expr *> bindings;
+  for (const auto &input : checkpoint->pendingInputs.get()) {
+    Stmt &stmt = *pg.statements[input.first];
+    Expr *value = nullptr;
+    if (stmt.statementType == StmtType::ASSIGN) {
+      Assign &assign = dynamic_cast<Assign &>(stmt);
+      bool isInput = false;
+      if (assign.right->exprType == ExprType::FUNC_CALL_EXPR) {
+        FuncCall &fc = dynamic_cast<FuncCall &>(*assign.right);
+        isInput = fc.op == Opcode::INPUT && fc.args.size() == 0;
+      }
+      if (!isInput && !isSymbolic(*assign.right, st)) {
+        value = evaluateExpr(*assign.right, st);
+      }
+    }
+
+    if (value == nullptr) {
+      state.pendingInputs.edit().push_back(input);
+      continue;
+    }
+    bindings[input.second] = value;
+    state.pathConstraint.edit().add(
+        exprFactory->funcCall("Eq", {exprFactory->symVar(input.second), value}),
+        input.first, true);
+  }
+
+  if (!bindings.empty()) {
+    for (const auto &entry : state.sigma.getBindings()) {
+      Expr *value = substitute(entry.second, bindings);
+      if (value != entry.second) {
+        state.chosen.edit().insert(entry.first);
+        state.sigma.setValue(entry.first, value);
+      }
+    }
+    state.valuesChosen = true;
+  }
+
+  TRACE(INFO, "[SEE] Resuming at statement " << checkpoint->pc << " with "
+              << bindings.size() << " input(s) bound");
+
+  run(pg, st, checkpoint->pc);
+}
+
+void SEE::run(Program &pg, SymbolTable &st, size_t from) {
+  checkpoint.reset();
 
   // Iterate through statements
-  for (size_t i = 0; i < pg.statements.size(); i++) {
-    const auto &stmt = pg.statements[i];
+  // A path that is already infeasible is not worth the API calls
+  for (state.pc = from;
+       state.pc < pg.statements.size() && !state.pathConstraint.get().isFalse();
+       state.pc++) {
+    const auto &stmt = pg.statements[state.pc];
 
     // Check if statement is ready for execution
     if (isReady(*stmt, st)) {
@@ -337,20 +397,203 @@ void SEE::execute(Program &pg, SymbolTable &st) {
       executeStmt(*stmt, st);
     } else {
       // Statement not ready (e.g., contains input() that needs concrete value)
-      cout << "[SEE] Statement " << i << " not ready, interrupting execution"
-           << endl;
+      TRACE(INFO, "[SEE] Statement " << state.pc
+                  << " not ready, interrupting execution");
+      checkpoint = make_unique<SymbolicState>(state);
       break;
     }
   }
 
-  // Compute path constraint from collected constraints
-  auto pc = computePathConstraint();
-  cout << "\n[SEE] Path Constraint: " << exprToString(pc) << endl;
+  // The conjunction is only built when the trace shows it
+  TRACE(INFO, "\n[SEE] Path Constraint: "
+              << exprToString(conjoin(state.pathConstraint.get().conjuncts)));
 
   // Note: solve(pc) is called externally by the caller (Tester class)
   return;
 }
 
+bool SEE::readsChosen(const Expr &expr) const {
+  const set<string> &chosen = state.chosen.get();
+  if (chosen.empty()) {
+    return false;
+  }
+  // Chosen are program variables, never SymVars
+  set<unsigned int> symVars;
+  set<string> variables;
+  collectVariables(&expr, symVars, variables);
+  for (const string &var : variables) {
+    if (chosen.count(var) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SEE::addAssumption(Expr *constraint, bool isChosen) {
+  FuncCall *disjunction = constraint->exprType == ExprType::FUNC_CALL_EXPR
+                              ? dynamic_cast<FuncCall *>(constraint)
+                              : nullptr;
+  if (!forking || !disjunction || disjunction->op != Opcode::OR) {
+    addConjunct(state, constraint, isChosen);
+    return;
+  }
+
+  // or(a, or(b, c)) splits three ways
+  vector<Expr *> disjuncts;
+  vector<Expr *> pending = {constraint};
+  while (!pending.empty()) {
+    Expr *e = pending.back();
+    pending.pop_back();
+    FuncCall *fc = e->exprType == ExprType::FUNC_CALL_EXPR
+                       ? dynamic_cast<FuncCall *>(e)
+                       : nullptr;
+    if (fc && fc->op == Opcode::OR) {
+      for (size_t i = fc->args.size(); i-- > 0;) {
+        pending.push_back(fc->args[i].get());
+      }
+    } else {
+      disjuncts.push_back(e);
+    }
+  }
+
+  size_t level = state.decisions.size();
+  unsigned int choice = level < script.size() ? script[level] : 0;
+  if (choice >= disjuncts.size()) {
+    throw runtime_error("SEE: decision " + to_string(choice) +
+                        " at statement " + to_string(state.pc) +
+                        " of a split into " + to_string(disjuncts.size()));
+  }
+  TRACE(INFO, "[SEE] Statement " << state.pc << " splits into "
+              << disjuncts.size() << " path(s), taking " << choice);
+  if (level >= script.size()) {
+    for (size_t i = 1; i < disjuncts.size(); i++) {
+      auto fork = make_unique<SymbolicState>(state);
+      takeDisjunct(*fork, disjuncts, i, isChosen);
+      // The fork goes on after the assume
+      fork->pc = state.pc + 1;
+      forks.push_back(std::move(fork));
+    }
+  }
+  takeDisjunct(state, disjuncts, choice, isChosen);
+}
+
+void SEE::takeDisjunct(SymbolicState &path, const vector<Expr *> &disjuncts,
+                       unsigned int i, bool isChosen) {
+  for (unsigned int j = 0; j < i; j++) {
+    addConjunct(path,
+                ConstantFolder::call(*exprFactory, "Not", {disjuncts[j]}),
+                isChosen);
+  }
+  addConjunct(path, disjuncts[i], isChosen);
+  path.decisions.push_back(make_pair(path.pc, i));
+}
+
+void SEE::addConjunct(SymbolicState &path, Expr *conjunct, bool isChosen) {
+  if (conjunct->exprType == ExprType::BOOL &&
+      dynamic_cast<Bool *>(conjunct)->value) {
+    TRACE(DEBUG, "[ASSUME] Statement " << path.pc << " holds, dropped");
+    return;
+  }
+  path.pathConstraint.edit().add(conjunct, path.pc, isChosen);
+  if (path.pathConstraint.get().isFalse()) {
+    TRACE(INFO, "[SEE] Statement " << path.pc << " is false, path infeasible");
+  }
+}
+
+unique_ptr<SymbolicState> SEE::takeFork(size_t index) {
+  if (index >= forks.size()) {
+    throw out_of_range("SEE::takeFork: no such fork");
+  }
+  unique_ptr<SymbolicState> fork = std::move(forks[index]);
+  forks.erase(forks.begin() + index);
+  return fork;
+}
+
+void SEE::explore(unique_ptr<SymbolicState> fork, Program &pg,
+                  SymbolTable &st) {
+  if (!isLive(*fork)) {
+    throw runtime_error("SEE::explore: the application has seen API calls "
+                        "since the fork");
+  }
+  checkpoint = std::move(fork);
+  resume(pg, st);
+}
+
+vector<unsigned int> SEE::getPendingInputs() const {
+  vector<unsigned int> result;
+  for (const auto &input : state.pendingInputs.get()) {
+    result.push_back(input.second);
+  }
+  return result;
+}
+
+Expr *SEE::substitute(Expr *expr, const map<unsigned int, Expr *> &bindings) {
+  if (bindings.empty()) {
+    return expr;
+  }
+
+  if (expr->exprType == ExprType::SYMVAR) {
+    SymVar *sv = dynamic_cast<SymVar *>(expr);
+    auto it = bindings.find(sv->getNum());
+    return it != bindings.end() ? it->second : expr;
+  } else if (expr->exprType == ExprType::FUNC_CALL_EXPR) {
+    FuncCall *fc = dynamic_cast<FuncCall *>(expr);
+    bool changed = false;
+    vector<Expr *> newArgs;
+    for (const auto &arg : fc->args) {
+      newArgs.push_back(substitute(arg.get(), bindings));
+      changed = changed || newArgs.back() != arg.get();
+    }
+    if (!changed) {
+      return expr;
+    }
+    return ConstantFolder::call(*exprFactory, fc->op, fc->apiId, fc->name,
+                                newArgs);
+  } else if (expr->exprType == ExprType::SET) {
+    Set *set = dynamic_cast<Set *>(expr);
+    bool changed = false;
+    vector<Expr *> newElements;
+    for (const auto &elem : set->elements) {
+      newElements.push_back(substitute(elem.get(), bindings));
+      changed = changed || newElements.back() != elem.get();
+    }
+    if (!changed) {
+      return expr;
+    }
+    return exprFactory->set(newElements);
+  } else if (expr->exprType == ExprType::TUPLE) {
+    Tuple *tuple = dynamic_cast<Tuple *>(expr);
+    bool changed = false;
+    vector<Expr *> newExprs;
+    for (const auto &e : tuple->exprs) {
+      newExprs.push_back(substitute(e.get(), bindings));
+      changed = changed || newExprs.back() != e.get();
+    }
+    if (!changed) {
+      return expr;
+    }
+    return exprFactory->tuple(newExprs);
+  } else if (expr->exprType == ExprType::MAP) {
+    Map *map = dynamic_cast<Map *>(expr);
+    bool changed = false;
+    vector<Expr *> newValues;
+    for (const auto &kv : map->value) {
+      newValues.push_back(substitute(kv.second.get(), bindings));
+      changed = changed || newValues.back() != kv.second.get();
+    }
+    if (!changed) {
+      return expr;
+    }
+    vector<pair<string, Expr *>> entries;
+    for (size_t i = 0; i < map->value.size(); i++) {
+      entries.push_back(make_pair(map->value[i].first->name, newValues[i]));
+    }
+    return exprFactory->map(entries);
+  }
+
+  return expr;
+}
+
 void SEE::executeStmt(Stmt &stmt, SymbolTable &st) {
   // the various if conditions for different statement types
 
@@ -369,8 +612,22 @@ void SEE::executeStmt(Stmt &stmt, SymbolTable &st) {
       varName = "_unknown";
     }
 
-    cout << "\n[ASSIGN] Evaluating: " << varName
-         << " := " << exprToString(assign.right.get()) << endl;
+    TRACE(DEBUG, "\n[ASSIGN] Evaluating: " << varName << " := "
+                 << exprToString(assign.right.get()));
+
+    bool isAPICall =
+        assign.right->exprType == ExprType::FUNC_CALL_EXPR &&
+        isAPI(dynamic_cast<FuncCall &>(*assign.right));
+    bool isChosenValue = chosenStatements.count(state.pc) > 0;
+    if (isChosenValue) {
+      state.valuesChosen = true;
+    }
+    if (isChosenValue || (isAPICall && state.valuesChosen) ||
+        readsChosen(*assign.right)) {
+      state.chosen.edit().insert(varName);
+    } else if (state.chosen.get().count(varName) > 0) {
+      state.chosen.edit().erase(varName);
+    }
 
     // Check if this is an API call assignment (e.g., r1 := f(x1))
     if (assign.right->exprType == ExprType::FUNC_CALL_EXPR) {
@@ -378,89 +635,88 @@ void SEE::executeStmt(Stmt &stmt, SymbolTable &st) {
 
       if (isAPI(fc)) {
         // This is an API call - execute it
-        cout << "[API_CALL] Executing API function: " << fc.name << endl;
+        TRACE(DEBUG, "[API_CALL] Executing API function: " << fc.name);
 
         // Evaluate all arguments to get concrete values
         vector<Expr *> concreteArgs;
         for (const auto &arg : fc.args) {
           Expr *evaluatedArg = evaluateExpr(*arg, st);
           concreteArgs.push_back(evaluatedArg);
-          cout << "  [API_ARG] " << exprToString(evaluatedArg) << endl;
+          TRACE(DEBUG, "  [API_ARG] " << exprToString(evaluatedArg));
         }
 
         // Execute the actual API function if factory is available
         if (functionFactory != nullptr) {
           try {
             // Get the function implementation from the factory
-            cout << "  [API_CALL] Getting function from factory..." << endl;
+            TRACE(DEBUG, "  [API_CALL] Getting function from factory...");
             unique_ptr<Function> function =
-                functionFactory->getFunction(fc.name, concreteArgs);
+                functionFactory->getFunction(fc.apiId, concreteArgs);
 
             // Execute the function with concrete arguments
-            cout << "  [API_CALL] Executing function..." << endl;
+            TRACE(DEBUG, "  [API_CALL] Executing function...");
+            state.apiCalls++;
+            applicationCalls++;
             unique_ptr<Expr> result = function->execute();
-            cout << "  [API_CALL] Function returned: " << exprToString(result)
-                 << endl;
+            TRACE(DEBUG, "  [API_CALL] Function returned: "
+                         << exprToString(result));
 
             // Store the return value in sigma
-            cout << "  [API_CALL] Storing result in variable: " << varName
-                 << endl;
-            sigma.setValue(varName, result.release());
+            TRACE(DEBUG,
+                  "  [API_CALL] Storing result in variable: " << varName);
+            state.sigma.setValue(varName, exprFactory->intern(*result));
 
-            cout << "[ASSIGN] Result: " << varName
-                 << " := " << exprToString(sigma.getValue(varName)) << endl;
+            TRACE(DEBUG, "[ASSIGN] Result: " << varName << " := "
+                         << exprToString(state.sigma.getValue(varName)));
             return;
           } catch (const char *error) {
-            cout << "  [API_CALL] Error: " << error << endl;
+            TRACE(ERROR, "  [API_CALL] Error: " << error);
             throw runtime_error(string("Function execution failed: ") + error);
           } catch (const exception &e) {
-            cout << "  [API_CALL] Error: " << e.what() << endl;
+            TRACE(ERROR, "  [API_CALL] Error: " << e.what());
             throw;
           }
         } else {
           // No function factory available - use placeholder behavior
-          cout << "  [API_CALL] Warning: No FunctionFactory set, using "
-                  "placeholder"
-               << endl;
-          cout << "  [API_CALL] Storing placeholder value in: " << varName
-               << endl;
+          TRACE(DEBUG, "  [API_CALL] Warning: No FunctionFactory set, using "
+                       "placeholder");
+          TRACE(DEBUG,
+                "  [API_CALL] Storing placeholder value in: " << varName);
           throw runtime_error("FunctionFactory not set in SEE");
-          cout << "[ASSIGN] Result: " << varName << " := 1 (placeholder)"
-               << endl;
+          TRACE(DEBUG, "[ASSIGN] Result: " << varName << " := 1 (placeholder)");
           return;
         }
       } else {
         // Built-in function call (input, Add, etc.) - evaluate symbolically
         Expr *rhsExpr = evaluateExpr(*assign.right, st);
 
-        cout << "[ASSIGN] Result: " << varName
-             << " := " << exprToString(rhsExpr) << endl;
+        TRACE(DEBUG, "[ASSIGN] Result: " << varName << " := "
+                     << exprToString(rhsExpr));
 
         // Store the mapping in sigma (value environment)
-        sigma.setValue(varName, rhsExpr);
+        state.sigma.setValue(varName, rhsExpr);
       }
     } else {
       // Not a function call - evaluate normally
       Expr *rhsExpr = evaluateExpr(*assign.right, st);
 
-      cout << "[ASSIGN] Result: " << varName << " := " << exprToString(rhsExpr)
-           << endl;
+      TRACE(DEBUG, "[ASSIGN] Result: " << varName << " := "
+                   << exprToString(rhsExpr));
 
       // Store the mapping in sigma (value environment)
-      sigma.setValue(varName, rhsExpr);
+      state.sigma.setValue(varName, rhsExpr);
     }
   } else if (stmt.statementType == StmtType::ASSUME) {
     Assume &assume = dynamic_cast<Assume &>(stmt);
 
-    cout << "\n[ASSUME] Evaluating: " << exprToString(assume.expr.get())
-         << endl;
+    TRACE(DEBUG, "\n[ASSUME] Evaluating: " << exprToString(assume.expr.get()));
 
     // Add the assumption expression to the path constraint
     Expr *constraint = evaluateExpr(*assume.expr, st);
 
-    cout << "[ASSUME] Adding constraint: " << exprToString(constraint) << endl;
+    TRACE(DEBUG, "[ASSUME] Adding constraint: " << exprToString(constraint));
 
-    pathConstraint.push_back(constraint);
+    addAssumption(constraint, readsChosen(*assume.expr));
   } else if (stmt.statementType == StmtType::DECL) {
     // taking this as the declaration of a symbolic variable or the input
     // statement we need to get the last symbolic variable and add it to sigma
@@ -469,14 +725,20 @@ void SEE::executeStmt(Stmt &stmt, SymbolTable &st) {
     string varName = decl.name;
     // we need to get the latest symbolic variable
 
-    cout << "\n[DECL] Declaring symbolic variable: " << varName << endl;
+    TRACE(DEBUG, "\n[DECL] Declaring symbolic variable: " << varName);
 
-    SymVar *symVarExpr = SymVar::getNewSymVar().release();
+    SymVar *symVarExpr = exprFactory->symVar(symVars.allocate());
 
-    cout << "[DECL] Created: " << varName << " := " << exprToString(symVarExpr)
-         << endl;
+    TRACE(DEBUG, "[DECL] Created: " << varName << " := "
+                 << exprToString(symVarExpr));
 
-    sigma.setValue(varName, symVarExpr);
+    state.sigma.setValue(varName, symVarExpr);
+  } else if (stmt.statementType == StmtType::ASSERT) {
+    // A postcondition does not constrain the inputs: the test checks it
+    // against the responses when it runs, so execution goes past it to the
+    // blocks whose inputs are still to be chosen
+    TRACE(DEBUG, "\n[ASSERT] Skipping: " << exprToString(
+                     dynamic_cast<Assert &>(stmt).expr.get()));
   }
 }
 
@@ -486,104 +748,103 @@ Expr *SEE::evaluateExpr(Expr &expr, SymbolTable &st) {
   if (expr.exprType == ExprType::FUNC_CALL_EXPR) {
     FuncCall &fc = dynamic_cast<FuncCall &>(expr);
 
-    cout << "  [EVAL] FuncCall: " << fc.name << " with " << fc.args.size()
-         << " args" << endl;
+    TRACE(DEBUG, "  [EVAL] FuncCall: " << fc.name << " with " << fc.args.size()
+                 << " args");
 
     // Special case: "input" function with no arguments returns a new symbolic
     // variable
-    if (fc.name == "input" && fc.args.size() == 0) {
-      SymVar *symVar = SymVar::getNewSymVar().release();
-      cout << "    [EVAL] input() returns new symbolic variable: "
-           << exprToString(symVar) << endl;
+    if (fc.op == Opcode::INPUT && fc.args.size() == 0) {
+      SymVar *symVar = exprFactory->symVar(symVars.allocate());
+      state.pendingInputs.edit().push_back(make_pair(state.pc, symVar->getNum()));
+      TRACE(DEBUG, "    [EVAL] input() returns new symbolic variable: "
+                   << exprToString(symVar));
       return symVar;
     }
 
     // Evaluate all arguments
-    vector<unique_ptr<Expr>> evaluatedArgs;
+    vector<Expr *> evaluatedArgs;
     for (size_t i = 0; i < fc.args.size(); i++) {
-      cout << "    [EVAL] Arg[" << i << "]: " << exprToString(fc.args[i])
-           << endl;
+      TRACE(DEBUG, "    [EVAL] Arg[" << i << "]: "
+                   << exprToString(fc.args[i].get()));
       Expr *argResult = evaluateExpr(*fc.args[i], st);
-      cout << "    [EVAL] Arg[" << i << "] result: " << exprToString(argResult)
-           << endl;
-      evaluatedArgs.push_back(argResult->clone());
+      TRACE(DEBUG, "    [EVAL] Arg[" << i << "] result: "
+                   << exprToString(argResult));
+      evaluatedArgs.push_back(argResult);
     }
 
-    FuncCall *result = new FuncCall(fc.name, ::move(evaluatedArgs));
-    cout << "    [EVAL] FuncCall result: " << exprToString(result) << endl;
+    // Built-ins on constants are evaluated here rather than by the solver
+    Expr *result = ConstantFolder::call(*exprFactory, fc.op, fc.apiId, fc.name,
+                                        evaluatedArgs);
+    TRACE(DEBUG, "    [EVAL] FuncCall result: " << exprToString(result));
 
     return result;
   } else if (expr.exprType == ExprType::NUM) {
-    Num *result = new Num(dynamic_cast<Num &>(expr).value);
-    cout << "  [EVAL] Num: " << exprToString(result) << endl;
+    Num *result = exprFactory->num(dynamic_cast<Num &>(expr).value);
+    TRACE(DEBUG, "  [EVAL] Num: " << exprToString(result));
     return result;
   } else if (expr.exprType == ExprType::STRING) {
-    String *result = new String(dynamic_cast<String &>(expr).value);
-    cout << "  [EVAL] String: " << exprToString(result) << endl;
+    String *result = exprFactory->str(dynamic_cast<String &>(expr).value);
+    TRACE(DEBUG, "  [EVAL] String: " << exprToString(result));
     return result;
   } else if (expr.exprType == ExprType::SYMVAR) {
     // Return the symbolic variable as-is
-    cout << "  [EVAL] SymVar: " << exprToString(&expr) << endl;
-    return &expr;
+    TRACE(DEBUG, "  [EVAL] SymVar: " << exprToString(&expr));
+    return exprFactory->intern(expr);
   } else if (expr.exprType == ExprType::VAR) {
     // Look up variable in sigma
     Var &v = dynamic_cast<Var &>(expr);
-    cout << "  [EVAL] Var lookup: " << v.name << endl;
-    if (sigma.hasValue(v.name)) {
-      Expr *value = sigma.getValue(v.name);
-      cout << "    [EVAL] Found in sigma: " << exprToString(value) << endl;
+    TRACE(DEBUG, "  [EVAL] Var lookup: " << v.name);
+    if (state.sigma.hasValue(v.name)) {
+      Expr *value = state.sigma.getValue(v.name);
+      TRACE(DEBUG, "    [EVAL] Found in sigma: " << exprToString(value));
       return value;
     }
-    cout << "    [EVAL] Not found in sigma, returning as-is" << endl;
-    return &expr;
+    TRACE(DEBUG, "    [EVAL] Not found in sigma, returning as-is");
+    return exprFactory->intern(expr);
   } else if (expr.exprType == ExprType::SET) {
     // Evaluate each element in the set
     Set &set = dynamic_cast<Set &>(expr);
-    cout << "  [EVAL] Set with " << set.elements.size() << " elements" << endl;
+    TRACE(DEBUG, "  [EVAL] Set with " << set.elements.size() << " elements");
 
-    vector<unique_ptr<Expr>> evaluatedElements;
+    vector<Expr *> evaluatedElements;
     for (size_t i = 0; i < set.elements.size(); i++) {
-      Expr *elemResult = evaluateExpr(*set.elements[i], st);
-      evaluatedElements.push_back(elemResult->clone());
+      evaluatedElements.push_back(evaluateExpr(*set.elements[i], st));
     }
 
-    Set *result = new Set(::move(evaluatedElements));
-    cout << "    [EVAL] Set result: " << exprToString(result) << endl;
+    Set *result = exprFactory->set(evaluatedElements);
+    TRACE(DEBUG, "    [EVAL] Set result: " << exprToString(result));
     return result;
   } else if (expr.exprType == ExprType::MAP) {
     // Evaluate each key-value pair in the map
     Map &map = dynamic_cast<Map &>(expr);
-    cout << "  [EVAL] Map with " << map.value.size() << " entries" << endl;
+    TRACE(DEBUG, "  [EVAL] Map with " << map.value.size() << " entries");
 
-    vector<pair<unique_ptr<Var>, unique_ptr<Expr>>> evaluatedPairs;
+    vector<pair<string, Expr *>> evaluatedPairs;
     for (size_t i = 0; i < map.value.size(); i++) {
-      // Clone the key (Var)
-      unique_ptr<Var> keyClone = make_unique<Var>(map.value[i].first->name);
-      // Evaluate the value
+      // Evaluate the value, the key (Var) is kept as is
       Expr *valResult = evaluateExpr(*map.value[i].second, st);
-      evaluatedPairs.push_back(make_pair(::move(keyClone), valResult->clone()));
+      evaluatedPairs.push_back(make_pair(map.value[i].first->name, valResult));
     }
 
-    Map *result = new Map(::move(evaluatedPairs));
-    cout << "    [EVAL] Map result: " << exprToString(result) << endl;
+    Map *result = exprFactory->map(evaluatedPairs);
+    TRACE(DEBUG, "    [EVAL] Map result: " << exprToString(result));
     return result;
   } else if (expr.exprType == ExprType::TUPLE) {
     // Evaluate each element in the tuple
     Tuple &tuple = dynamic_cast<Tuple &>(expr);
-    cout << "  [EVAL] Tuple with " << tuple.exprs.size() << " elements" << endl;
+    TRACE(DEBUG, "  [EVAL] Tuple with " << tuple.exprs.size() << " elements");
 
-    vector<unique_ptr<Expr>> evaluatedExprs;
+    vector<Expr *> evaluatedExprs;
     for (size_t i = 0; i < tuple.exprs.size(); i++) {
-      Expr *elemResult = evaluateExpr(*tuple.exprs[i], st);
-      evaluatedExprs.push_back(elemResult->clone());
+      evaluatedExprs.push_back(evaluateExpr(*tuple.exprs[i], st));
     }
 
-    Tuple *result = new Tuple(::move(evaluatedExprs));
-    cout << "    [EVAL] Tuple result: " << exprToString(result) << endl;
+    Tuple *result = exprFactory->tuple(evaluatedExprs);
+    TRACE(DEBUG, "    [EVAL] Tuple result: " << exprToString(result));
     return result;
   }
 
   // Default case: return the expression as-is
-  cout << "  [EVAL] Unknown type, returning as-is" << endl;
-  return &expr;
+  TRACE(DEBUG, "  [EVAL] Unknown type, returning as-is");
+  return exprFactory->intern(expr);
 }
@@ -3,17 +3,21 @@
 
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "../language/ast.hh"
 #include "../language/env.hh"
+#include "../language/exprfactory.hh"
 #include "../language/symvar.hh"
+#include "state.hh"
 
 // Forward declaration
 class FunctionFactory;
 
 using namespace std;
+
 // see = symbolic execution engine 
 
 
@@ -25,12 +29,36 @@ class SEE {
     private:
         SymVar *symVar=nullptr;
 
-        ValueEnvironment sigma;  // Value environment: maps variable names to their values
-        vector<Expr*> pathConstraint;
+        // The path being executed: sigma (variable name -> value), the path
+        // constraint, the next statement and the inputs still symbolic
+        SymbolicState state;
         FunctionFactory* functionFactory; // Factory for creating API functions
+        // All values and constraints built by SEE are canonical nodes of this
+        // factory, so equal terms are shared and compared by pointer
+        shared_ptr<ExprFactory> exprFactory;
+        // Numbers the SymVars of input statements and declarations
+        SymVarAllocator symVars;
 
+        // The state at the statement where execution was last interrupted.
+        // resume() continues from here after the Tester has rewritten the
+        // input statements before it with concrete values, so nothing before
+        // its pc (in particular no concrete API call) is executed twice.
+        unique_ptr<SymbolicState> checkpoint;
+        // Split at assumptions of or(...) when on
+        bool forking;
+        // Paths split off at branching points and not explored yet, in the
+        // order they were created
+        vector<unique_ptr<SymbolicState>> forks;
+        // API calls made on the application in this session, on any path
+        size_t applicationCalls;
+        // Disjuncts to take at the first splits, see setDecisions
+        vector<unsigned int> script;
+        // Statements assigning values chosen before, see setChosenStatements
+        set<size_t> chosenStatements;
 
         unique_ptr<Expr> computePathConstraint(vector<Expr*>);
+        // Canonical conjunction of the given constraints
+        Expr* conjoin(const vector<Expr*>&);
         // If the statement is a call to an API function, then none of its parameters
         // should be variables whose values are symbolic expression.
         bool isReady(Stmt&, SymbolTable&);
@@ -44,25 +72,113 @@ class SEE {
         // it is symbolic expression.
         bool isSymbolic(Expr&, SymbolTable&);
         
-        // Check if a function call is an API call (not a built-in function)
-        // Built-in functions: Add, Sub, Mul, Eq, Lt, Gt, And, Or, Not, input
+        // Check if a function call is an API call (not a built-in function),
+        // i.e. its name did not resolve to a built-in Opcode
         bool isAPI(const FuncCall& fc);
 
 	void executeStmt(Stmt&, SymbolTable&);
 	Expr* evaluateExpr(Expr&, SymbolTable&);
+
+        // Execute statements from the given one until the end of the program
+        // or the next interruption, where a checkpoint is taken.
+        void run(Program&, SymbolTable&, size_t);
+        // Replace the SymVars in bindings by their values.
+        Expr* substitute(Expr*, const map<unsigned int, Expr*>&);
+        // Whether the expression reads a variable in chosen
+        bool readsChosen(const Expr&) const;
+        // Assume the constraint of the assume at pc. With forking on, a
+        // disjunction d1 or ... or dn is split: this path assumes one di
+        // (d1 unless the script says otherwise) and not dj for every j < i,
+        // so that no two paths share an input. Past the end of the script,
+        // a fork is left for each other disjunct.
+        void addAssumption(Expr* constraint, bool isChosen);
+        // Add the conjuncts of taking disjunct i at the path's pc
+        void takeDisjunct(SymbolicState&, const vector<Expr*>& disjuncts,
+                          unsigned int i, bool isChosen);
+        // Add a conjunct at the path's pc, unless it is the constant true
+        void addConjunct(SymbolicState&, Expr* conjunct, bool isChosen);
     public:
-        SEE(FunctionFactory* functionFactory) : sigma(nullptr) {
+        SEE(FunctionFactory* functionFactory,
+            shared_ptr<ExprFactory> exprFactory = nullptr)
+            : forking(false), applicationCalls(0) {
             this->functionFactory = functionFactory;
+            this->exprFactory = exprFactory ? exprFactory
+                                            : make_shared<ExprFactory>();
+        }
+        // API calls of later runs go to this factory
+        void setFunctionFactory(FunctionFactory* factory) {
+            functionFactory = factory;
         }
         
+        // Start a new session: forget sigma, the path constraint and the
+        // checkpoint, number SymVars from 0 again, and build all further
+        // expressions in the given factory
+        // (a new one if null). The previous factory, and with it every
+        // expression of the previous session, is freed once nobody else
+        // holds it.
+        void beginSession(shared_ptr<ExprFactory> exprFactory = nullptr);
+
         // Program and Type Env
         void execute(Program&, SymbolTable&);
+
+        // Continue from the last checkpoint on a program whose input
+        // statements before the interruption point may have been rewritten
+        // to concrete assignments. Each such SymVar is replaced by its value
+        // in sigma and pinned with Eq(X, value) in the path constraint, so
+        // the path constraint only ever grows. Without a checkpoint this is
+        // the same as execute().
+        void resume(Program&, SymbolTable&);
+        bool hasCheckpoint() const { return checkpoint != nullptr; }
+        const SymbolicState* getCheckpoint() const { return checkpoint.get(); }
+        void clearCheckpoint() { checkpoint.reset(); }
+        // SymVars of executed input statements that are still symbolic, in
+        // program order. These are the values the next rewriteATC needs.
+        vector<unsigned int> getPendingInputs() const;
         
+        // Split execution at disjunctive assumptions (off by default: the
+        // disjunction is then one conjunct of a single path)
+        void setForking(bool on) { forking = on; }
+        bool isForking() const { return forking; }
+        // Replay a path: at the k-th split of the following executions take
+        // disjunct script[k] (counting from 0), and leave forks only at the
+        // splits after the script. The script stays until it is replaced.
+        void setDecisions(vector<unsigned int> decisions) { script = std::move(decisions); }
+        // Assignments of the program that give inputs the values chosen by
+        // an earlier generation, e.g. a prefix concretized before: what they
+        // assign, and the API calls after them, count as chosen as after
+        // resume(). Stays until it is replaced.
+        void setChosenStatements(set<size_t> statements) { chosenStatements = std::move(statements); }
+        const vector<unique_ptr<SymbolicState>>& getForks() const { return forks; }
+        // Remove a pending fork and hand it to the caller
+        unique_ptr<SymbolicState> takeFork(size_t index);
+        // Whether execution can go on from the state: the application has
+        // seen no API call since the state was split off
+        bool isLive(const SymbolicState& s) const {
+            return s.apiCalls == applicationCalls;
+        }
+        // Continue on another path: the state becomes the checkpoint and
+        // is resumed on the program, whose input statements may have been
+        // rewritten since the split. The current path is dropped.
+        void explore(unique_ptr<SymbolicState>, Program&, SymbolTable&);
+
         // Solve path constraints and return a result
         unique_ptr<Expr> computePathConstraint();
+        // A conjunct folded to false: the path is UNSAT without asking the
+        // solver, and execution stopped at that assume
+        bool isInfeasible() const { return state.pathConstraint.get().isFalse(); }
+        // Index of that conjunct in the path constraint
+        size_t getFalsified() const { return state.pathConstraint.get().falsified; }
         
+        ExprFactory& getExprFactory() { return *exprFactory; }
+        const SymVarAllocator& getSymVarAllocator() const { return symVars; }
+
         // Getters for testing
-        ValueEnvironment& getSigma() { return sigma; }
-        vector<Expr*>& getPathConstraint() { return pathConstraint; }
+        ValueEnvironment& getSigma() { return state.sigma; }
+        const vector<Expr*>& getPathConstraint() const { return state.pathConstraint.get().conjuncts; }
+        const vector<size_t>& getConstraintOrigins() const { return state.pathConstraint.get().origins; }
+        // Conjuncts that hold or fail because of the values given to
+        // earlier inputs rather than because of the program alone
+        const vector<bool>& getConstraintChosen() const { return state.pathConstraint.get().chosen; }
+        const SymbolicState& getState() const { return state; }
 };
 #endif
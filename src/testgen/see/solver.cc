@@ -14,6 +14,48 @@ IntResultValue::IntResultValue(int v) : ResultValue(ResultType::INT), value(v) {
 StringResultValue::StringResultValue(const string& v) : ResultValue(ResultType::STRING), value(v) {
 }
 
-Result::Result(bool tf, map<string, unique_ptr<ResultValue> > m) : isSat(tf), model(std::move(m)) {
+unique_ptr<ResultValue> copyResultValue(const ResultValue& v) {
+    switch(v.type) {
+        case ResultType::BOOL:
+            return make_unique<BoolResultValue>(dynamic_cast<const BoolResultValue&>(v).value);
+        case ResultType::INT:
+            return make_unique<IntResultValue>(dynamic_cast<const IntResultValue&>(v).value);
+        default:
+            return make_unique<StringResultValue>(dynamic_cast<const StringResultValue&>(v).value);
+    }
+}
+
+map<string, unique_ptr<ResultValue> > copyModel(const map<string, unique_ptr<ResultValue> >& m) {
+    map<string, unique_ptr<ResultValue> > result;
+    for(const auto& entry : m) {
+        result[entry.first] = copyResultValue(*entry.second);
+    }
+    return result;
+}
+
+map<string, unique_ptr<ResultValue> > toNamedModel(const NumberedModel& m) {
+    map<string, unique_ptr<ResultValue> > result = copyModel(m.vars);
+    for(const auto& entry : m.symVars) {
+        result["X" + to_string(entry.first)] = copyResultValue(*entry.second);
+    }
+    return result;
+}
+
+const char* statusName(SolverStatus status) {
+    switch(status) {
+        case SolverStatus::SAT: return "SAT";
+        case SolverStatus::UNSAT: return "UNSAT";
+        case SolverStatus::UNKNOWN: return "UNKNOWN";
+        case SolverStatus::TIMEOUT: return "TIMEOUT";
+    }
+    return "?";
+}
+
+Result::Result(bool tf, map<string, unique_ptr<ResultValue> > m)
+    : status(tf ? SolverStatus::SAT : SolverStatus::UNSAT), isSat(tf), model(std::move(m)) {
+}
+
+Result::Result(SolverStatus s, map<string, unique_ptr<ResultValue> > m)
+    : status(s), isSat(s == SolverStatus::SAT), model(std::move(m)) {
 }
 
@@ -41,11 +41,51 @@ class StringResultValue : public ResultValue {
         const string value;
 };
 
+// Copy of a model value of any type
+unique_ptr<ResultValue> copyResultValue(const ResultValue&);
+map<string, unique_ptr<ResultValue> > copyModel(const map<string, unique_ptr<ResultValue> >&);
+
+// A model as the solvers keep it internally: SymVars by number, named
+// variables by name. Result names the SymVars X<n> for the callers of Solver.
+struct NumberedModel {
+    map<unsigned int, unique_ptr<ResultValue> > symVars;
+    map<string, unique_ptr<ResultValue> > vars;
+};
+
+// The model under the names of Result
+map<string, unique_ptr<ResultValue> > toNamedModel(const NumberedModel&);
+
+// UNKNOWN and TIMEOUT say nothing about the constraints: the solver gave up,
+// for TIMEOUT because its time budget ran out
+enum class SolverStatus {
+    SAT,
+    UNSAT,
+    UNKNOWN,
+    TIMEOUT
+};
+
+const char* statusName(SolverStatus);
+
 class Result {
     public:
-        const bool isSat;
+        const SolverStatus status;
+        const bool isSat; // status == SAT
         const map<string, unique_ptr<ResultValue>> model; 
         Result(bool, map<string, unique_ptr<ResultValue> >);
+        Result(SolverStatus, map<string, unique_ptr<ResultValue> >);
+        // SAT or UNSAT
+        bool isDecided() const {
+            return status == SolverStatus::SAT || status == SolverStatus::UNSAT;
+        }
+};
+
+// Resource limits of a solver, 0 for none. The session limit bounds the
+// time of all queries of an incremental session together.
+struct SolverBudget {
+    unsigned int queryTimeoutMs;
+    unsigned int sessionTimeoutMs;
+    unsigned int memoryMb; // per query
+    SolverBudget() : queryTimeoutMs(0), sessionTimeoutMs(0), memoryMb(0) {}
 };
 
 class Solver {
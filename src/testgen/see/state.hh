@@ -0,0 +1,94 @@
+#ifndef STATE_HH
+#define STATE_HH
+
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "../language/env.hh"
+
+using namespace std;
+
+// A value shared by the copies of a state until one of them changes it.
+// Copying is O(1); edit() copies the value first if another state still
+// refers to it. Not for sharing between threads: each SEE owns its states.
+template <typename T> class CopyOnWrite {
+  shared_ptr<T> value;
+
+public:
+  CopyOnWrite() : value(make_shared<T>()) {}
+  explicit CopyOnWrite(T initial) : value(make_shared<T>(std::move(initial))) {}
+
+  const T &get() const { return *value; }
+  T &edit() {
+    if (value.use_count() > 1) {
+      value = make_shared<T>(*value);
+    }
+    return *value;
+  }
+  // Whether both refer to the same value, i.e. neither has written since
+  // they were copied
+  bool shares(const CopyOnWrite &other) const { return value == other.value; }
+};
+
+// The path constraint, with for each conjunct the statement it comes from
+// (an assume, or for the Eq pins of SEE::resume the input statement) and
+// whether it depends on the values resume() bound
+struct PathConstraint {
+  vector<Expr *> conjuncts;
+  vector<size_t> origins;
+  vector<bool> chosen;
+  // Index of the first conjunct that is the constant false, if any
+  size_t falsified = NONE;
+  static const size_t NONE = ~size_t(0);
+
+  void add(Expr *conjunct, size_t origin, bool isChosen) {
+    if (falsified == NONE && conjunct->exprType == ExprType::BOOL &&
+        !dynamic_cast<Bool *>(conjunct)->value) {
+      falsified = conjuncts.size();
+    }
+    conjuncts.push_back(conjunct);
+    origins.push_back(origin);
+    chosen.push_back(isChosen);
+  }
+  // The path is infeasible whatever the inputs
+  bool isFalse() const { return falsified != NONE; }
+  void clear() {
+    conjuncts.clear();
+    origins.clear();
+    chosen.clear();
+    falsified = NONE;
+  }
+};
+
+// Everything SEE knows about one path. Copying a state forks the path: the
+// copy shares sigma, the path constraint and the rest with the original.
+// sigma is persistent, so an assignment on either path copies only the trie
+// nodes on the way to the variable; the other parts get their own copy when
+// one of the paths first writes to them. The expressions themselves are
+// canonical nodes of the session's ExprFactory and are never copied.
+struct SymbolicState {
+  ValueEnvironment sigma;
+  CopyOnWrite<PathConstraint> pathConstraint;
+  // Variables whose value depends on the values resume() bound: changed by
+  // the binding, assigned from such variables, or the result of an API
+  // call made after a binding
+  CopyOnWrite<set<string>> chosen;
+  bool valuesChosen = false; // resume() bound an input on this path
+  // Input statements executed on this path whose SymVar has no concrete
+  // value yet, in program order: input statement -> its SymVar
+  CopyOnWrite<vector<pair<size_t, unsigned int>>> pendingInputs;
+  size_t pc = 0; // next statement to execute
+  // Disjunct taken at each split on this path, with the assume statement
+  // that split it, in order
+  vector<pair<size_t, unsigned int>> decisions;
+  // API calls made on this path. The application is not forked with the
+  // state, so a fork can only go on while the application has seen exactly
+  // these calls (see SEE::isLive).
+  size_t apiCalls = 0;
+};
+
+#endif
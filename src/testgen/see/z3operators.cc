@@ -0,0 +1,166 @@
+#include "z3operators.hh"
+#include <stdexcept>
+
+Z3OperatorRegistry::Z3OperatorRegistry()
+    : builtins(static_cast<size_t>(Opcode::ANY) + 1) {
+  registerBuiltins();
+}
+
+Z3OperatorRegistry &Z3OperatorRegistry::getInstance() {
+  static Z3OperatorRegistry registry;
+  return registry;
+}
+
+void Z3OperatorRegistry::registerBuiltin(Opcode op,
+                                         Z3Translation translation) {
+  if (op == Opcode::API) {
+    throw invalid_argument("registerBuiltin: not a built-in");
+  }
+  builtins[static_cast<size_t>(op)] = std::move(translation);
+}
+
+void Z3OperatorRegistry::registerFunction(const string &name, size_t arity,
+                                          Z3Translation translation) {
+  if (OpcodeTable::lookup(name) != Opcode::API) {
+    throw invalid_argument("registerFunction: " + name + " is a built-in");
+  }
+  ApiId id = ApiRegistry::intern(name);
+  if (id >= functions.size()) {
+    functions.resize(id + 1);
+  }
+  if (arity >= functions[id].size()) {
+    functions[id].resize(arity + 1);
+  }
+  functions[id][arity] = std::move(translation);
+}
+
+const Z3Translation *
+Z3OperatorRegistry::lookup(const FuncCall &call) const {
+  const Z3Translation *translation = nullptr;
+  if (call.op != Opcode::API) {
+    // Built-ins only translate at their own arity
+    if (call.args.size() ==
+        static_cast<size_t>(OpcodeTable::arity(call.op))) {
+      translation = &builtins[static_cast<size_t>(call.op)];
+    }
+  } else if (call.apiId < functions.size() &&
+             call.args.size() < functions[call.apiId].size()) {
+    translation = &functions[call.apiId][call.args.size()];
+  }
+  return translation != nullptr && *translation ? translation : nullptr;
+}
+
+// ============================================================================
+// Built-ins
+// ============================================================================
+
+// div, input() and prime notation have no translation
+void Z3OperatorRegistry::registerBuiltins() {
+  typedef const vector<z3::expr> &Args;
+
+  // ========== Arithmetic Operations ==========
+  registerBuiltin(Opcode::ADD,
+                  [](z3::context &, Args a) { return a[0] + a[1]; });
+  registerBuiltin(Opcode::SUB,
+                  [](z3::context &, Args a) { return a[0] - a[1]; });
+  registerBuiltin(Opcode::MUL,
+                  [](z3::context &, Args a) { return a[0] * a[1]; });
+
+  // ========== Comparison Operations ==========
+  registerBuiltin(Opcode::EQ,
+                  [](z3::context &, Args a) { return a[0] == a[1]; });
+  registerBuiltin(Opcode::NEQ,
+                  [](z3::context &, Args a) { return a[0] != a[1]; });
+  registerBuiltin(Opcode::LT,
+                  [](z3::context &, Args a) { return a[0] < a[1]; });
+  registerBuiltin(Opcode::GT,
+                  [](z3::context &, Args a) { return a[0] > a[1]; });
+  registerBuiltin(Opcode::LE,
+                  [](z3::context &, Args a) { return a[0] <= a[1]; });
+  registerBuiltin(Opcode::GE,
+                  [](z3::context &, Args a) { return a[0] >= a[1]; });
+
+  // ========== Logical Operations ==========
+  registerBuiltin(Opcode::AND,
+                  [](z3::context &, Args a) { return a[0] && a[1]; });
+  registerBuiltin(Opcode::OR,
+                  [](z3::context &, Args a) { return a[0] || a[1]; });
+  registerBuiltin(Opcode::NOT, [](z3::context &, Args a) { return !a[0]; });
+  registerBuiltin(Opcode::IMPLIES, [](z3::context &, Args a) {
+    return z3::implies(a[0], a[1]);
+  });
+
+  // ========== Set/Map Membership Operations ==========
+  // in(element, set) or in(key, map). Sets are arrays to bool, so select is
+  // membership; for maps it is the value at the key.
+  registerBuiltin(Opcode::IN, [](z3::context &, Args a) {
+    return z3::select(a[1], a[0]);
+  });
+  registerBuiltin(Opcode::NOT_IN, [](z3::context &, Args a) {
+    return !z3::select(a[1], a[0]);
+  });
+
+  // ========== Set Operations ==========
+  registerBuiltin(Opcode::UNION, [](z3::context &, Args a) {
+    return z3::set_union(a[0], a[1]);
+  });
+  registerBuiltin(Opcode::INTERSECT, [](z3::context &, Args a) {
+    return z3::set_intersect(a[0], a[1]);
+  });
+  registerBuiltin(Opcode::DIFFERENCE, [](z3::context &, Args a) {
+    return z3::set_difference(a[0], a[1]);
+  });
+  registerBuiltin(Opcode::SUBSET, [](z3::context &, Args a) {
+    return z3::set_subset(a[0], a[1]);
+  });
+  // add_to_set(set, element), remove_from_set(set, element)
+  registerBuiltin(Opcode::ADD_TO_SET, [](z3::context &, Args a) {
+    return z3::set_add(a[0], a[1]);
+  });
+  registerBuiltin(Opcode::REMOVE_FROM_SET, [](z3::context &, Args a) {
+    return z3::set_del(a[0], a[1]);
+  });
+  registerBuiltin(Opcode::IS_EMPTY_SET, [](z3::context &ctx, Args a) {
+    z3::sort elemSort = a[0].get_sort().array_domain();
+    return a[0] == z3::const_array(elemSort, ctx.bool_val(false));
+  });
+
+  // ========== Map Operations ==========
+  // get(map, key), put(map, key, value)
+  registerBuiltin(Opcode::GET, [](z3::context &, Args a) {
+    return z3::select(a[0], a[1]);
+  });
+  registerBuiltin(Opcode::PUT, [](z3::context &, Args a) {
+    return z3::store(a[0], a[1], a[2]);
+  });
+  // contains_key(map, key): maps are arrays without a domain, so every key
+  // is taken to exist. A proper translation needs a separate domain set.
+  registerBuiltin(Opcode::CONTAINS_KEY,
+                  [](z3::context &ctx, Args) { return ctx.bool_val(true); });
+
+  // ========== List/Sequence Operations ==========
+  registerBuiltin(Opcode::CONCAT, [](z3::context &, Args a) {
+    return z3::concat(a[0], a[1]);
+  });
+  registerBuiltin(Opcode::LENGTH,
+                  [](z3::context &, Args a) { return a[0].length(); });
+  // at(list, index)
+  registerBuiltin(Opcode::AT,
+                  [](z3::context &, Args a) { return a[0].at(a[1]); });
+  // prefix(list1, list2): list1 is a prefix of list2; suffix likewise
+  registerBuiltin(Opcode::PREFIX, [](z3::context &, Args a) {
+    return z3::prefixof(a[0], a[1]);
+  });
+  registerBuiltin(Opcode::SUFFIX, [](z3::context &, Args a) {
+    return z3::suffixof(a[0], a[1]);
+  });
+  // contains_seq(list, sublist), through the C API
+  registerBuiltin(Opcode::CONTAINS_SEQ, [](z3::context &ctx, Args a) {
+    return z3::expr(ctx, Z3_mk_seq_contains(ctx, a[0], a[1]));
+  });
+
+  // ========== Special Functions ==========
+  // Any(x): no condition; translating x registers the variable
+  registerBuiltin(Opcode::ANY,
+                  [](z3::context &ctx, Args) { return ctx.bool_val(true); });
+}
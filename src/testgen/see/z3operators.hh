@@ -0,0 +1,43 @@
+#ifndef Z3OPERATORS_HH
+#define Z3OPERATORS_HH
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "z3++.h"
+
+using namespace std;
+
+// Builds the Z3 term of a call from the Z3 terms of its arguments
+typedef function<z3::expr(z3::context &, const vector<z3::expr> &)>
+    Z3Translation;
+
+// Translation of every function the solver understands, looked up by the
+// opcode of a built-in or the interned name and arity of any other function.
+// Lookups are two vector indexings. The built-ins are registered when the
+// registry is first used; apps add their own theory functions with
+// registerFunction. Register before solving starts: lookups do not lock.
+class Z3OperatorRegistry {
+private:
+  vector<Z3Translation> builtins;          // by Opcode
+  vector<vector<Z3Translation>> functions; // by ApiId, then arity
+
+  Z3OperatorRegistry();
+  void registerBuiltins();
+
+public:
+  static Z3OperatorRegistry &getInstance();
+
+  // Replace the translation of a built-in, which keeps its arity
+  void registerBuiltin(Opcode op, Z3Translation translation);
+  // Translate calls to a function that is not a built-in. The same name may
+  // be registered for several arities.
+  void registerFunction(const string &name, size_t arity,
+                        Z3Translation translation);
+  // nullptr if the call has no translation
+  const Z3Translation *lookup(const FuncCall &call) const;
+};
+
+#endif
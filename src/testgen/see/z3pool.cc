@@ -0,0 +1,82 @@
+#include "z3pool.hh"
+
+// ============================================================================
+// Z3PooledContext
+// ============================================================================
+
+Z3PooledContext::Z3PooledContext() : ctx(), solver(ctx), stats() {}
+
+void Z3PooledContext::noteQuery(z3::check_result result) {
+  stats.queries++;
+  if (result == z3::sat) {
+    stats.sat++;
+  } else if (result == z3::unsat) {
+    stats.unsat++;
+  } else {
+    stats.unknown++;
+  }
+}
+
+// ============================================================================
+// Z3ContextPool
+// ============================================================================
+
+Z3ContextPool::Lease::~Lease() {
+  if (context != nullptr) {
+    pool->release(context);
+  }
+}
+
+Z3ContextPool &Z3ContextPool::getInstance() {
+  static Z3ContextPool pool;
+  return pool;
+}
+
+Z3ContextPool::Lease Z3ContextPool::acquire() {
+  lock_guard<mutex> guard(lock);
+  Z3PooledContext *context;
+  if (idle.empty()) {
+    contexts.push_back(make_unique<Z3PooledContext>());
+    context = contexts.back().get();
+  } else {
+    // The most recently used context is the most likely to be warm
+    context = idle.back();
+    idle.pop_back();
+  }
+  context->stats.leases++;
+  return Lease(this, context);
+}
+
+void Z3ContextPool::release(Z3PooledContext *context) {
+  // Only the releasing thread uses the context until it is back in idle
+  context->solver.reset();
+  lock_guard<mutex> guard(lock);
+  idle.push_back(context);
+}
+
+void Z3ContextPool::reserve(size_t numContexts) {
+  lock_guard<mutex> guard(lock);
+  while (contexts.size() < numContexts) {
+    contexts.push_back(make_unique<Z3PooledContext>());
+    idle.insert(idle.begin(), contexts.back().get());
+  }
+}
+
+size_t Z3ContextPool::size() {
+  lock_guard<mutex> guard(lock);
+  return contexts.size();
+}
+
+size_t Z3ContextPool::getNumIdle() {
+  lock_guard<mutex> guard(lock);
+  return idle.size();
+}
+
+vector<Z3ContextStats> Z3ContextPool::getStats() {
+  lock_guard<mutex> guard(lock);
+  vector<Z3ContextStats> result;
+  for (const auto &context : contexts) {
+    result.push_back(context->stats);
+  }
+  return result;
+}
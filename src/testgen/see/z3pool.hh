@@ -0,0 +1,90 @@
+#ifndef Z3POOL_HH
+#define Z3POOL_HH
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "z3++.h"
+
+using namespace std;
+
+// Statistics of one pooled context, accumulated over all its leases
+struct Z3ContextStats {
+  unsigned int leases;
+  unsigned int queries;
+  unsigned int sat;
+  unsigned int unsat;
+  unsigned int unknown; // including timeouts
+};
+
+// A Z3 context with a solver on it. Z3 objects are not thread-safe, so a
+// pooled context is only used by the thread holding its lease.
+class Z3PooledContext {
+  friend class Z3ContextPool;
+
+private:
+  z3::context ctx;
+  z3::solver solver;
+  Z3ContextStats stats;
+
+public:
+  Z3PooledContext();
+  z3::context &getContext() { return ctx; }
+  // Has no assertions at the start of a lease
+  z3::solver &getSolver() { return solver; }
+  // Count the result of a check() made on this context
+  void noteQuery(z3::check_result result);
+  const Z3ContextStats &getStats() const { return stats; }
+};
+
+// Contexts that Z3Solver borrows instead of creating one per query or
+// session: for the short queries of a test generation, setting up and
+// tearing down a context costs more than solving. A context is created once
+// and its solver is reset when the lease ends. The pool grows to the number
+// of contexts in use at the same time, i.e. one per worker thread.
+class Z3ContextPool {
+public:
+  // Gives the context back to the pool when destroyed. Every Z3 object made
+  // on the context must be destroyed before.
+  class Lease {
+  private:
+    Z3ContextPool *pool;
+    Z3PooledContext *context;
+
+  public:
+    Lease(Z3ContextPool *pool, Z3PooledContext *context)
+        : pool(pool), context(context) {}
+    Lease(Lease &&other) : pool(other.pool), context(other.context) {
+      other.context = nullptr;
+    }
+    Lease(const Lease &) = delete;
+    Lease &operator=(const Lease &) = delete;
+    Lease &operator=(Lease &&) = delete;
+    ~Lease();
+
+    Z3PooledContext &operator*() const { return *context; }
+    Z3PooledContext *operator->() const { return context; }
+  };
+
+  static Z3ContextPool &getInstance();
+
+  Lease acquire();
+  // Create contexts up front, e.g. one per worker before a batch starts
+  void reserve(size_t numContexts);
+  size_t size();
+  size_t getNumIdle();
+  // Statistics of every context, in creation order. Only exact while no
+  // context is leased.
+  vector<Z3ContextStats> getStats();
+
+private:
+  mutex lock;
+  vector<unique_ptr<Z3PooledContext>> contexts;
+  vector<Z3PooledContext *> idle; // the most recently released last
+
+  void release(Z3PooledContext *context);
+};
+
+#endif
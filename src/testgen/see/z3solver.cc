@@ -1,18 +1,25 @@
 #include "z3solver.hh"
 #include "../language/symvar.hh"
-#include <iostream>
+#include "fastpath.hh"
+#include "independence.hh"
+#include "z3operators.hh"
+#include "../util/trace.hh"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 // ============================================================================
 // Z3InputMaker Implementation
 // ============================================================================
 
-Z3InputMaker::Z3InputMaker(TypeMap *tm) : typeMap(tm) {}
+Z3InputMaker::Z3InputMaker(z3::context &c, TypeMap *tm)
+    : ctx(c), typeMap(tm), memoHits(0) {}
 
 Z3InputMaker::~Z3InputMaker() {
   // Clean up allocated z3::expr pointers
-  for (auto &entry : symVarMap) {
-    delete entry.second;
-  }
   for (auto &entry : namedVarMap) {
     delete entry.second;
   }
@@ -21,25 +28,87 @@ Z3InputMaker::~Z3InputMaker() {
 // ============================================================================
 // Z3 Sort Helpers
 // ============================================================================
-z3::expr Z3InputMaker::convertArg(const unique_ptr<Expr> &arg) {
-  if (arg->exprType == ExprType::SYMVAR) {
-    SymVar *sv = dynamic_cast<SymVar *>(arg.get());
-    unsigned int num = sv->getNum();
-
-    if (symVarMap.find(num) == symVarMap.end()) {
-      string varName = "X" + to_string(num);
-      z3::expr *z3Var = new z3::expr(ctx.int_const(varName.c_str()));
-      symVarMap[num] = z3Var;
-      variables.push_back(*z3Var);
-    }
+z3::expr Z3InputMaker::symVarToZ3(unsigned int num) {
+  if (num >= symVarExprs.size()) {
+    symVarExprs.resize(num + 1);
+  }
+  unique_ptr<z3::expr> &z3Var = symVarExprs[num];
+  if (!z3Var) {
+    string varName = "X" + to_string(num);
+    z3Var = make_unique<z3::expr>(ctx.int_const(varName.c_str()));
+    symVarNums[z3Var->id()] = num;
+    variables.push_back(*z3Var);
+  }
+  noteReferenced(*z3Var);
+  return *z3Var;
+}
 
-    return *symVarMap[num];
-  } else {
-    visit(arg.get());
+bool Z3InputMaker::findSymVar(const z3::expr &var, unsigned int &num) const {
+  auto it = symVarNums.find(var.id());
+  if (it == symVarNums.end()) {
+    return false;
+  }
+  num = it->second;
+  return true;
+}
+
+void Z3InputMaker::noteReferenced(const z3::expr &var) {
+  nodeVariables.push_back(var);
+  if (referencedIds.insert(var.id()).second) {
+    referenced.push_back(var);
+  }
+}
+
+vector<z3::expr> Z3InputMaker::takeReferencedVariables() {
+  vector<z3::expr> result = std::move(referenced);
+  referenced.clear();
+  referencedIds.clear();
+  return result;
+}
+
+z3::expr Z3InputMaker::convertArg(const shared_ptr<Expr> &arg) {
+  return translate(arg.get());
+}
+
+z3::expr Z3InputMaker::translate(const Expr *expr) {
+  // SymVars and named variables have tables of their own
+  if (expr->exprType == ExprType::SYMVAR) {
+    const SymVar *sv = dynamic_cast<const SymVar *>(expr);
+    return symVarToZ3(sv->getNum());
+  }
+  if (expr->exprType == ExprType::VAR) {
+    visit(expr);
     z3::expr result = theStack.top();
     theStack.pop();
     return result;
   }
+
+  auto it = memo.find(expr);
+  if (it != memo.end()) {
+    memoHits++;
+    for (const z3::expr &var : it->second.variables) {
+      noteReferenced(var);
+    }
+    return it->second.term;
+  }
+
+  // The variables noted while translating the node are its variables
+  size_t mark = nodeVariables.size();
+  visit(expr);
+  if (theStack.empty()) {
+    throw runtime_error("Stack empty after visiting expression");
+  }
+  z3::expr result = theStack.top();
+  theStack.pop();
+  vector<z3::expr> variables;
+  set<unsigned int> seen;
+  for (size_t i = mark; i < nodeVariables.size(); i++) {
+    if (seen.insert(nodeVariables[i].id()).second) {
+      variables.push_back(nodeVariables[i]);
+    }
+  }
+  memo.emplace(expr, MemoEntry{result, variables});
+  return result;
 }
 z3::sort Z3InputMaker::getStringSort() { return ctx.string_sort(); }
 
@@ -109,61 +178,20 @@ z3::expr Z3InputMaker::makeEmptyMap(z3::sort keySort, z3::sort valueSort) {
 // ============================================================================
 
 z3::expr Z3InputMaker::makeZ3Input(unique_ptr<Expr> &expr) {
-  if (!expr) {
-    throw runtime_error("Null expression in Z3 conversion");
-  }
-
-  // Handle SymVar specially since it's not part of the ExprVisitor interface
-  if (expr->exprType == ExprType::SYMVAR) {
-    SymVar *sv = dynamic_cast<SymVar *>(expr.get());
-    unsigned int num = sv->getNum();
-
-    // Check if we've already created a Z3 variable for this SymVar
-    if (symVarMap.find(num) == symVarMap.end()) {
-      string varName = "X" + to_string(num);
-      z3::expr *z3Var = new z3::expr(ctx.int_const(varName.c_str()));
-      symVarMap[num] = z3Var;
-      variables.push_back(*z3Var);
-    }
-
-    return *symVarMap[num];
-  }
-
-  visit(expr.get());
-  if (theStack.empty()) {
-    throw runtime_error("Stack empty after visiting expression");
-  }
-  z3::expr result = theStack.top();
-  theStack.pop();
-  return result;
+  return makeZ3Input(expr.get());
 }
 
 z3::expr Z3InputMaker::makeZ3Input(Expr *expr) {
   if (!expr) {
     throw runtime_error("Null expression in Z3 conversion");
   }
-
-  // Handle SymVar specially
-  if (expr->exprType == ExprType::SYMVAR) {
-    SymVar *sv = dynamic_cast<SymVar *>(expr);
-    unsigned int num = sv->getNum();
-
-    if (symVarMap.find(num) == symVarMap.end()) {
-      string varName = "X" + to_string(num);
-      z3::expr *z3Var = new z3::expr(ctx.int_const(varName.c_str()));
-      symVarMap[num] = z3Var;
-      variables.push_back(*z3Var);
-    }
-
-    return *symVarMap[num];
+  nodeVariables.clear();
+  z3::expr result = translate(expr);
+  nodeVariables.clear();
+  // A number as a condition, e.g. a precondition of 1 for true
+  if (result.is_int()) {
+    return result != 0;
   }
-
-  visit(expr);
-  if (theStack.empty()) {
-    throw runtime_error("Stack empty after visiting expression");
-  }
-  z3::expr result = theStack.top();
-  theStack.pop();
   return result;
 }
 
@@ -176,6 +204,7 @@ vector<z3::expr> Z3InputMaker::getVariables() { return variables; }
 void Z3InputMaker::visitVar(const Var &node) {
   // Check if we already have this variable
   if (namedVarMap.find(node.name) != namedVarMap.end()) {
+    noteReferenced(*namedVarMap[node.name]);
     theStack.push(*namedVarMap[node.name]);
     return;
   }
@@ -191,6 +220,7 @@ void Z3InputMaker::visitVar(const Var &node) {
   z3::expr *z3Var = new z3::expr(ctx.constant(node.name.c_str(), varSort));
   namedVarMap[node.name] = z3Var;
   variables.push_back(*z3Var);
+  noteReferenced(*z3Var);
   theStack.push(*z3Var);
 }
 
@@ -207,218 +237,24 @@ void Z3InputMaker::visitBool(const Bool &node) {
 }
 
 void Z3InputMaker::visitFuncCall(const FuncCall &node) {
-  // Helper lambda to convert an argument
-
-  // ========== Arithmetic Operations ==========
-  if (node.name == "add" && node.args.size() == 2) {
-    z3::expr left = convertArg(node.args[0]);
-    z3::expr right = convertArg(node.args[1]);
-    theStack.push(left + right);
-  } else if (node.name == "sub" && node.args.size() == 2) {
-    z3::expr left = convertArg(node.args[0]);
-    z3::expr right = convertArg(node.args[1]);
-    theStack.push(left - right);
-  } else if (node.name == "mul" && node.args.size() == 2) {
-    z3::expr left = convertArg(node.args[0]);
-    z3::expr right = convertArg(node.args[1]);
-    theStack.push(left * right);
-  }
-
-  // ========== Comparison Operations ==========
-  else if ((node.name == "eq" || node.name == "=" || node.name == "==" ||
-            node.name == "Eq") &&
-           node.args.size() == 2) {
-    z3::expr left = convertArg(node.args[0]);
-    z3::expr right = convertArg(node.args[1]);
-    theStack.push(left == right);
-  } else if ((node.name == "neq" || node.name == "Neq" || node.name == "!=" ||
-              node.name == "<>") &&
-             node.args.size() == 2) {
-    z3::expr left = convertArg(node.args[0]);
-    z3::expr right = convertArg(node.args[1]);
-    theStack.push(left != right);
-  } else if ((node.name == "lt" || node.name == "<") && node.args.size() == 2) {
-    z3::expr left = convertArg(node.args[0]);
-    z3::expr right = convertArg(node.args[1]);
-    theStack.push(left < right);
-  } else if ((node.name == "gt" || node.name == ">") && node.args.size() == 2) {
-    z3::expr left = convertArg(node.args[0]);
-    z3::expr right = convertArg(node.args[1]);
-    theStack.push(left > right);
-  } else if ((node.name == "le" || node.name == "<=") &&
-             node.args.size() == 2) {
-    z3::expr left = convertArg(node.args[0]);
-    z3::expr right = convertArg(node.args[1]);
-    theStack.push(left <= right);
-  } else if ((node.name == "ge" || node.name == ">=") &&
-             node.args.size() == 2) {
-    z3::expr left = convertArg(node.args[0]);
-    z3::expr right = convertArg(node.args[1]);
-    theStack.push(left >= right);
-  }
-
-  // ========== Logical Operations ==========
-  else if ((node.name == "And" || node.name == "and" || node.name == "&&") &&
-           node.args.size() == 2) {
-    z3::expr left = convertArg(node.args[0]);
-    z3::expr right = convertArg(node.args[1]);
-    theStack.push(left && right);
-  } else if ((node.name == "Or" || node.name == "or" || node.name == "||") &&
-             node.args.size() == 2) {
-    z3::expr left = convertArg(node.args[0]);
-    z3::expr right = convertArg(node.args[1]);
-    theStack.push(left || right);
-  } else if ((node.name == "Not" || node.name == "not" || node.name == "!") &&
-             node.args.size() == 1) {
-    z3::expr arg = convertArg(node.args[0]);
-    theStack.push(!arg);
-  } else if (node.name == "implies" && node.args.size() == 2) {
-    z3::expr left = convertArg(node.args[0]);
-    z3::expr right = convertArg(node.args[1]);
-    theStack.push(z3::implies(left, right));
-  }
-
-  // ========== Set/Map Membership Operations ==========
-  else if ((node.name == "in" || node.name == "member" ||
-            node.name == "contains") &&
-           node.args.size() == 2) {
-    // in(element, set) or in(key, map) - check if element/key is in set/map
-    z3::expr element = convertArg(node.args[0]);
-    z3::expr setOrMap = convertArg(node.args[1]);
-    // For sets (array to bool): select returns true if member
-    // For maps (array to value): we check if key exists
-    theStack.push(z3::select(setOrMap, element));
-  } else if ((node.name == "not_in" || node.name == "not_member" ||
-              node.name == "not_contains") &&
-             node.args.size() == 2) {
-    // not_in(element, set) - check if element is NOT in set
-    z3::expr element = convertArg(node.args[0]);
-    z3::expr setOrMap = convertArg(node.args[1]);
-    theStack.push(!z3::select(setOrMap, element));
-  }
-
-  // ========== Set Operations ==========
-  else if (node.name == "union" && node.args.size() == 2) {
-    // union(set1, set2) - set union using Z3's set_union
-    z3::expr set1 = convertArg(node.args[0]);
-    z3::expr set2 = convertArg(node.args[1]);
-    theStack.push(z3::set_union(set1, set2));
-  } else if ((node.name == "intersection" || node.name == "intersect") &&
-             node.args.size() == 2) {
-    // intersection(set1, set2) - set intersection
-    z3::expr set1 = convertArg(node.args[0]);
-    z3::expr set2 = convertArg(node.args[1]);
-    theStack.push(z3::set_intersect(set1, set2));
-  } else if ((node.name == "difference" || node.name == "diff" ||
-              node.name == "minus") &&
-             node.args.size() == 2) {
-    // difference(set1, set2) - set difference
-    z3::expr set1 = convertArg(node.args[0]);
-    z3::expr set2 = convertArg(node.args[1]);
-    theStack.push(z3::set_difference(set1, set2));
-  } else if ((node.name == "subset" || node.name == "is_subset") &&
-             node.args.size() == 2) {
-    // subset(set1, set2) - check if set1 is subset of set2
-    z3::expr set1 = convertArg(node.args[0]);
-    z3::expr set2 = convertArg(node.args[1]);
-    theStack.push(z3::set_subset(set1, set2));
-  } else if (node.name == "add_to_set" && node.args.size() == 2) {
-    // add_to_set(set, element) - add element to set
-    z3::expr set = convertArg(node.args[0]);
-    z3::expr element = convertArg(node.args[1]);
-    theStack.push(z3::set_add(set, element));
-  } else if (node.name == "remove_from_set" && node.args.size() == 2) {
-    // remove_from_set(set, element) - remove element from set
-    z3::expr set = convertArg(node.args[0]);
-    z3::expr element = convertArg(node.args[1]);
-    theStack.push(z3::set_del(set, element));
-  } else if (node.name == "is_empty_set" && node.args.size() == 1) {
-    // is_empty_set(set) - check if set is empty
-    z3::expr set = convertArg(node.args[0]);
-    z3::sort elemSort = set.get_sort().array_domain();
-    z3::expr emptySet = makeEmptySet(elemSort);
-    theStack.push(set == emptySet);
-  }
-
-  // ========== Map Operations ==========
-  else if ((node.name == "get" || node.name == "lookup" ||
-            node.name == "select") &&
-           node.args.size() == 2) {
-    // get(map, key) - get value for key from map
-    z3::expr map = convertArg(node.args[0]);
-    z3::expr key = convertArg(node.args[1]);
-    theStack.push(z3::select(map, key));
-  } else if ((node.name == "put" || node.name == "store" ||
-              node.name == "update") &&
-             node.args.size() == 3) {
-    // put(map, key, value) - store value at key in map
-    z3::expr map = convertArg(node.args[0]);
-    z3::expr key = convertArg(node.args[1]);
-    z3::expr value = convertArg(node.args[2]);
-    theStack.push(z3::store(map, key, value));
-  } else if ((node.name == "contains_key" || node.name == "has_key") &&
-             node.args.size() == 2) {
-    // contains_key(map, key) - check if map contains key
-    // For maps represented as arrays, we need domain tracking
-    // Simplified: assume all keys exist (return true)
-    // For proper implementation, need separate domain set
-    z3::expr map = convertArg(node.args[0]);
-    z3::expr key = convertArg(node.args[1]);
-    // Use select and check against default - simplified version
-    theStack.push(ctx.bool_val(true)); // Placeholder
-  }
-
-  // ========== List/Sequence Operations ==========
-  else if ((node.name == "concat" || node.name == "append_list") &&
-           node.args.size() == 2) {
-    // concat(list1, list2) - concatenate two lists
-    z3::expr list1 = convertArg(node.args[0]);
-    z3::expr list2 = convertArg(node.args[1]);
-    theStack.push(z3::concat(list1, list2));
-  } else if (node.name == "length" && node.args.size() == 1) {
-    // length(list) - get length of list
-    z3::expr list = convertArg(node.args[0]);
-    theStack.push(list.length());
-  } else if ((node.name == "at" || node.name == "nth") &&
-             node.args.size() == 2) {
-    // at(list, index) - get element at index
-    z3::expr list = convertArg(node.args[0]);
-    z3::expr index = convertArg(node.args[1]);
-    theStack.push(list.at(index));
-  } else if (node.name == "prefix" && node.args.size() == 2) {
-    // prefix(list1, list2) - check if list1 is prefix of list2
-    z3::expr list1 = convertArg(node.args[0]);
-    z3::expr list2 = convertArg(node.args[1]);
-    theStack.push(z3::prefixof(list1, list2));
-  } else if (node.name == "suffix" && node.args.size() == 2) {
-    // suffix(list1, list2) - check if list1 is suffix of list2
-    z3::expr list1 = convertArg(node.args[0]);
-    z3::expr list2 = convertArg(node.args[1]);
-    theStack.push(z3::suffixof(list1, list2));
-  } else if (node.name == "contains_seq" && node.args.size() == 2) {
-    // contains_seq(list, sublist) - check if list contains sublist
-    z3::expr list = convertArg(node.args[0]);
-    z3::expr sublist = convertArg(node.args[1]);
-    // Use Z3's seq.contains via the C API
-    Z3_ast args[2] = {list, sublist};
-    Z3_ast result = Z3_mk_seq_contains(ctx, list, sublist);
-    theStack.push(z3::expr(ctx, result));
-  }
-
-  // ========== Special Functions ==========
-  else if ((node.name == "Any" || node.name == "any") &&
-           node.args.size() == 1) {
-    // Any(x) - No condition, but ensures variable is registered
-    z3::expr arg = convertArg(node.args[0]);
-    // Return true (tautology) so it satisfies constraints
-    theStack.push(ctx.bool_val(true));
-  }
-
-  // ========== Unknown Function ==========
-  else {
+  // The opcode was resolved when the node was built, so every spelling of a
+  // built-in finds the same translation. API calls never reach the solver
+  // unless an app registered a theory function under their name.
+  const Z3Translation *translation =
+      Z3OperatorRegistry::getInstance().lookup(node);
+  if (translation == nullptr) {
     throw runtime_error("Unsupported function: " + node.name + " with " +
                         to_string(node.args.size()) + " args");
   }
+
+  // All arguments are translated, also where the result does not use them,
+  // so that Any(x) and contains_key register their variables
+  vector<z3::expr> args;
+  args.reserve(node.args.size());
+  for (const auto &arg : node.args) {
+    args.push_back(convertArg(arg));
+  }
+  theStack.push((*translation)(ctx, args));
 }
 
 void Z3InputMaker::visitSet(const Set &node) {
@@ -432,18 +268,14 @@ void Z3InputMaker::visitSet(const Set &node) {
   }
 
   // Get first element to determine sort
-  visit(node.elements[0].get());
-  z3::expr firstElem = theStack.top();
-  theStack.pop();
+  z3::expr firstElem = translate(node.elements[0].get());
 
   z3::sort elemSort = firstElem.get_sort();
   z3::expr result = z3::set_add(makeEmptySet(elemSort), firstElem);
 
   // Add remaining elements
   for (size_t i = 1; i < node.elements.size(); i++) {
-    visit(node.elements[i].get());
-    z3::expr elem = theStack.top();
-    theStack.pop();
+    z3::expr elem = translate(node.elements[i].get());
     result = z3::set_add(result, elem);
   }
 
@@ -459,13 +291,8 @@ void Z3InputMaker::visitMap(const Map &node) {
   }
 
   // Get first key-value to determine sorts
-  visit(node.value[0].first.get());
-  z3::expr firstKey = theStack.top();
-  theStack.pop();
-
-  visit(node.value[0].second.get());
-  z3::expr firstVal = theStack.top();
-  theStack.pop();
+  z3::expr firstKey = translate(node.value[0].first.get());
+  z3::expr firstVal = translate(node.value[0].second.get());
 
   z3::sort keySort = firstKey.get_sort();
   z3::sort valSort = firstVal.get_sort();
@@ -476,13 +303,8 @@ void Z3InputMaker::visitMap(const Map &node) {
 
   // Add remaining pairs
   for (size_t i = 1; i < node.value.size(); i++) {
-    visit(node.value[i].first.get());
-    z3::expr key = theStack.top();
-    theStack.pop();
-
-    visit(node.value[i].second.get());
-    z3::expr val = theStack.top();
-    theStack.pop();
+    z3::expr key = translate(node.value[i].first.get());
+    z3::expr val = translate(node.value[i].second.get());
 
     result = z3::store(result, key, val);
   }
@@ -565,69 +387,703 @@ void Z3InputMaker::visitProgram(const Program &node) {
   throw runtime_error("Program not supported in Z3 conversion");
 }
 
+// ============================================================================
+// Model Helpers
+// ============================================================================
+
+// Value of var in m; nullptr for an integer that does not fit in an int
+static unique_ptr<ResultValue> extractValue(z3::model &m, const z3::expr &var,
+                                            z3::context &ctx) {
+  z3::expr val = m.eval(var, true);
+
+  // Handle different types of values
+  if (val.is_numeral()) {
+    int intVal;
+    if (val.is_int() && Z3_get_numeral_int(ctx, val, &intVal)) {
+      TRACE(DEBUG, "[Z3Solver] " << var << " = " << intVal);
+      return make_unique<IntResultValue>(intVal);
+    }
+    return nullptr;
+  } else if (val.is_string_value()) {
+    string strVal = val.get_string();
+    TRACE(DEBUG, "[Z3Solver] " << var << " = \"" << strVal << "\"");
+    return make_unique<StringResultValue>(strVal);
+  } else if (val.is_bool()) {
+    bool boolVal = val.is_true();
+    TRACE(DEBUG, "[Z3Solver] " << var << " = "
+                 << (boolVal ? "true" : "false"));
+    return make_unique<BoolResultValue>(boolVal);
+  } else if (val.is_array()) {
+    // For arrays (sets/maps), store as string representation
+    TRACE(DEBUG, "[Z3Solver] " << var << " = " << val << " (array)");
+    return make_unique<StringResultValue>(val.to_string());
+  }
+  TRACE(DEBUG, "[Z3Solver] " << var << " = " << val << " (unknown type)");
+  return make_unique<StringResultValue>(val.to_string());
+}
+
+map<string, unique_ptr<ResultValue>>
+extractModel(z3::model &m, const vector<z3::expr> &vars, z3::context &ctx) {
+  map<string, unique_ptr<ResultValue>> var_values;
+
+  for (const auto &var : vars) {
+    if (unique_ptr<ResultValue> value = extractValue(m, var, ctx)) {
+      var_values[var.to_string()] = std::move(value);
+    }
+  }
+
+  return var_values;
+}
+
+NumberedModel extractModel(z3::model &m, const vector<z3::expr> &vars,
+                           const Z3InputMaker &inputMaker) {
+  NumberedModel model;
+  for (const auto &var : vars) {
+    unique_ptr<ResultValue> value = extractValue(m, var, var.ctx());
+    if (value == nullptr) {
+      continue;
+    }
+    unsigned int num;
+    if (inputMaker.findSymVar(var, num)) {
+      model.symVars[num] = std::move(value);
+    } else {
+      model.vars[var.to_string()] = std::move(value);
+    }
+  }
+  return model;
+}
+
+Expr *resultValueToExpr(const ResultValue &value, ExprFactory &factory) {
+  switch (value.type) {
+  case ResultType::INT:
+    return factory.num(dynamic_cast<const IntResultValue &>(value).value);
+  case ResultType::BOOL:
+    return factory.boolean(dynamic_cast<const BoolResultValue &>(value).value);
+  case ResultType::STRING:
+    return factory.str(dynamic_cast<const StringResultValue &>(value).value);
+  default:
+    return nullptr;
+  }
+}
+
+TypedModel toTypedModel(const Result &result, const vector<unsigned int> &nums,
+                        ExprFactory &factory) {
+  TypedModel typed(result.status);
+  if (!result.isSat) {
+    return typed;
+  }
+  for (unsigned int num : nums) {
+    auto entry = result.model.find("X" + to_string(num));
+    if (entry == result.model.end()) {
+      continue;
+    }
+    if (num >= typed.values.size()) {
+      typed.values.resize(num + 1, nullptr);
+    }
+    typed.values[num] = resultValueToExpr(*entry->second, factory);
+  }
+  return typed;
+}
+
+// ============================================================================
+// Budget Helpers
+// ============================================================================
+
+namespace {
+
+// Interrupts the check running on a context once its time is up. Z3's own
+// "timeout" parameter can leave a check hanging instead of ending it (seen
+// with Z3 4.8.12 on nonlinear queries), so the limit is enforced from here.
+class Z3Watchdog {
+private:
+  mutex lock;
+  condition_variable wakeUp;
+  bool done;
+  bool fired;
+  thread timer;
+
+public:
+  Z3Watchdog(z3::context &ctx, unsigned int timeoutMs)
+      : done(false), fired(false) {
+    timer = thread([this, &ctx, timeoutMs] {
+      unique_lock<mutex> guard(lock);
+      if (!wakeUp.wait_for(guard, chrono::milliseconds(timeoutMs),
+                           [this] { return done; })) {
+        fired = true;
+        ctx.interrupt();
+      }
+    });
+  }
+  ~Z3Watchdog() {
+    {
+      lock_guard<mutex> guard(lock);
+      done = true;
+    }
+    wakeUp.notify_one();
+    timer.join();
+  }
+  bool hasFired() {
+    lock_guard<mutex> guard(lock);
+    return fired;
+  }
+};
+
+// The query as SMT-LIB, with the assumptions asserted, so that it replays
+// to the same result
+string toSmt2(z3::solver &s, const z3::expr_vector *assumptions) {
+  if (assumptions == nullptr || assumptions->empty()) {
+    return s.to_smt2();
+  }
+  z3::expr_vector formulas = s.assertions();
+  for (unsigned int i = 0; i < assumptions->size(); i++) {
+    formulas.push_back((*assumptions)[i]);
+  }
+  z3::array<Z3_ast> asts(formulas);
+  return Z3_benchmark_to_smtlib_string(s.ctx(), "", "", "unknown", "",
+                                       asts.size() - 1, asts.ptr(),
+                                       asts[asts.size() - 1]);
+}
+
+} // namespace
+
+SolverStatus checkWithBudget(z3::solver &s, Z3PooledContext &context,
+                             const SolverBudget &budget,
+                             unsigned int remainingMs, QueryLog *queryLog,
+                             const z3::expr_vector *assumptions) {
+  unsigned int timeoutMs = budget.queryTimeoutMs;
+  if (remainingMs > 0 && (timeoutMs == 0 || remainingMs < timeoutMs)) {
+    timeoutMs = remainingMs;
+  }
+  // Pooled solvers keep their parameters, so no limit is set explicitly
+  z3::params params(context.getContext());
+  params.set("max_memory", budget.memoryMb > 0 ? budget.memoryMb : UINT_MAX);
+  s.set(params);
+
+  z3::check_result result;
+  bool timedOut = false;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  if (timeoutMs > 0) {
+    Z3Watchdog watchdog(context.getContext(), timeoutMs);
+    result = assumptions ? s.check(*assumptions) : s.check();
+    timedOut = watchdog.hasFired();
+  } else {
+    result = assumptions ? s.check(*assumptions) : s.check();
+  }
+  double timeMs = chrono::duration<double, milli>(
+                      chrono::steady_clock::now() - start)
+                      .count();
+  context.noteQuery(result);
+  // A result found just as the time ran out still counts
+  SolverStatus status;
+  if (result == z3::sat) {
+    status = SolverStatus::SAT;
+  } else if (result == z3::unsat) {
+    status = SolverStatus::UNSAT;
+  } else {
+    string reason = s.reason_unknown();
+    timedOut = timedOut || reason == "timeout" || reason == "canceled";
+    TRACE(INFO, "[Z3Solver] " << (timedOut ? "TIMEOUT" : "UNKNOWN") << " - "
+                << reason);
+    status = timedOut ? SolverStatus::TIMEOUT : SolverStatus::UNKNOWN;
+  }
+  if (queryLog != nullptr) {
+    queryLog->record(toSmt2(s, assumptions), status, timeMs);
+  }
+  return status;
+}
+
+// ============================================================================
+// Z3Session Implementation
+// ============================================================================
+
+Z3Session::Z3Session(TypeMap *tm, shared_ptr<ExprFactory> factory,
+                     CexCache *cache, const SolverBudget &b)
+    : exprFactory(factory ? factory : make_shared<ExprFactory>()),
+      cexCache(cache), budget(b), timeUsedMs(0),
+      lease(Z3ContextPool::getInstance().acquire()),
+      inputMaker(lease->getContext(), tm), solver(lease->getSolver()),
+      cacheHits(0), groupSolver(lease->getContext()), groupsSolved(0), groupsReused(0), groupsSkipped(0),
+      fastPath(false), fastPathHits(0), queryLog(nullptr) {}
+
+// conjunct must be canonical
+const Z3Session::Translation &Z3Session::translate(Expr *conjunct) {
+  auto it = termCache.find(conjunct);
+  if (it != termCache.end()) {
+    cacheHits++;
+    return it->second;
+  }
+  z3::expr formula = inputMaker.makeZ3Input(conjunct);
+  vector<z3::expr> vars = inputMaker.takeReferencedVariables();
+  return termCache.emplace(conjunct, Translation{formula, vars})
+      .first->second;
+}
+
+// Variables referenced by the currently asserted scopes, in first-use order.
+// Variables of popped scopes stay known to the context but must not show up
+// in the model.
+vector<z3::expr> Z3Session::getAssertedVariables() {
+  set<unsigned int> seen;
+  vector<z3::expr> result;
+  for (const Translation *scope : scopes) {
+    for (const auto &var : scope->variables) {
+      if (seen.insert(var.id()).second) {
+        result.push_back(var);
+      }
+    }
+  }
+  return result;
+}
+
+Result Z3Session::solve(const vector<Expr *> &conjuncts) {
+  vector<Expr *> keys;
+  for (Expr *conjunct : conjuncts) {
+    keys.push_back(exprFactory->intern(*conjunct));
+  }
+
+  // Keep the scopes shared with the previous query, pop the rest
+  size_t common = 0;
+  while (common < scopeKeys.size() && common < keys.size() &&
+         scopeKeys[common] == keys[common]) {
+    common++;
+  }
+  if (common < scopeKeys.size()) {
+    solver.pop(scopeKeys.size() - common);
+    scopeKeys.resize(common);
+    scopes.resize(common);
+  }
+
+  TRACE(INFO, "[Z3Solver] Reusing " << common << " scope(s), asserting "
+              << (keys.size() - common) << " new conjunct(s)");
+
+  for (size_t i = common; i < conjuncts.size(); i++) {
+    const Translation &translation = translate(keys[i]);
+    solver.push();
+    solver.add(translation.formula);
+    scopeKeys.push_back(keys[i]);
+    scopes.push_back(&translation);
+  }
+
+  TRACE(INFO, "[Z3Solver] Checking satisfiability...");
+
+  SolverStatus status = check(solver);
+  if (status == SolverStatus::SAT) {
+    TRACE(INFO, "[Z3Solver] SAT - Model found!");
+    z3::model m = solver.get_model();
+    return Result(true, extractModel(m, getAssertedVariables(),
+                                     inputMaker.getContext()));
+  }
+  if (status == SolverStatus::UNSAT) {
+    TRACE(INFO, "[Z3Solver] UNSAT - No solution exists");
+  }
+  return Result(status, map<string, unique_ptr<ResultValue>>());
+}
+
+SolverStatus Z3Session::check(z3::solver &s,
+                              const z3::expr_vector *assumptions) {
+  unsigned int remainingMs = 0;
+  if (budget.sessionTimeoutMs > 0) {
+    if (timeUsedMs >= budget.sessionTimeoutMs) {
+      TRACE(INFO, "[Z3Solver] TIMEOUT - Session budget of "
+                  << budget.sessionTimeoutMs << " ms is used up");
+      return SolverStatus::TIMEOUT;
+    }
+    remainingMs = budget.sessionTimeoutMs - timeUsedMs;
+  }
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  SolverStatus status =
+      checkWithBudget(s, *lease, budget, remainingMs, queryLog, assumptions);
+  timeUsedMs += chrono::duration_cast<chrono::milliseconds>(
+                    chrono::steady_clock::now() - start)
+                    .count();
+  return status;
+}
+
+vector<unique_ptr<Result>>
+Z3Session::enumerateModels(const vector<Expr *> &conjuncts,
+                           const vector<unsigned int> &inputs,
+                           size_t maxModels) {
+  vector<unique_ptr<Result>> models;
+  if (maxModels == 0 || solve(conjuncts).status != SolverStatus::SAT) {
+    return models;
+  }
+
+  // Inputs the conjuncts leave unconstrained are part of the models too
+  z3::context &ctx = inputMaker.getContext();
+  vector<z3::expr> variables = getAssertedVariables();
+  vector<z3::expr> inputVars;
+  for (unsigned int num : inputs) {
+    inputVars.push_back(ctx.int_const(("X" + to_string(num)).c_str()));
+    bool asserted = false;
+    for (const z3::expr &var : variables) {
+      asserted = asserted || z3::eq(var, inputVars.back());
+    }
+    if (!asserted) {
+      variables.push_back(inputVars.back());
+    }
+  }
+
+  // The blocking clauses live in a scope of their own, so the conjuncts'
+  // scopes stay reusable by the next query. Pushing drops the current
+  // model, so the first one is read before.
+  z3::model m = solver.get_model();
+  solver.push();
+  while (true) {
+    models.push_back(
+        make_unique<Result>(true, extractModel(m, variables, ctx)));
+    if (models.size() >= maxModels || inputVars.empty()) {
+      break;
+    }
+    // The next model differs from this one in at least one input
+    z3::expr_vector differs(ctx);
+    for (const z3::expr &var : inputVars) {
+      differs.push_back(var != m.eval(var, true));
+    }
+    solver.add(z3::mk_or(differs));
+    if (check(solver) != SolverStatus::SAT) {
+      break;
+    }
+    m = solver.get_model();
+  }
+  solver.pop();
+  TRACE(INFO, "[Z3Solver] Enumerated " << models.size() << " model(s) over "
+              << inputs.size() << " input(s)");
+  return models;
+}
+
+vector<size_t> Z3Session::unsatCore(const vector<Expr *> &conjuncts) {
+  // Each conjunct is guarded by a literal of its own, so that the core
+  // names the conjuncts rather than their translations
+  z3::context &ctx = inputMaker.getContext();
+  z3::solver fresh(ctx);
+  z3::expr_vector literals(ctx);
+  map<unsigned int, size_t> conjunctOf; // literal id -> conjunct index
+  for (size_t i = 0; i < conjuncts.size(); i++) {
+    const Translation &translation =
+        translate(exprFactory->intern(*conjuncts[i]));
+    z3::expr literal = ctx.bool_const(("core!" + to_string(i)).c_str());
+    fresh.add(z3::implies(literal, translation.formula));
+    literals.push_back(literal);
+    conjunctOf[literal.id()] = i;
+  }
+
+  vector<size_t> core;
+  if (check(fresh, &literals) != SolverStatus::UNSAT) {
+    return core;
+  }
+  z3::expr_vector coreLiterals = fresh.unsat_core();
+  for (unsigned int i = 0; i < coreLiterals.size(); i++) {
+    core.push_back(conjunctOf.at(coreLiterals[i].id()));
+  }
+  sort(core.begin(), core.end());
+  TRACE(INFO, "[Z3Solver] Unsat core: " << core.size() << " of "
+              << conjuncts.size() << " conjunct(s)");
+  return core;
+}
+
+Result Z3Session::retry(const vector<Expr *> &conjuncts,
+                        const string &tactic) {
+  // A solver of its own, so nothing of the incremental one carries over
+  z3::context &ctx = inputMaker.getContext();
+  z3::solver fresh = z3::tactic(ctx, tactic.c_str()).mk_solver();
+  vector<z3::expr> variables;
+  set<unsigned int> seen;
+  for (Expr *conjunct : conjuncts) {
+    const Translation &translation = translate(exprFactory->intern(*conjunct));
+    fresh.add(translation.formula);
+    for (const auto &var : translation.variables) {
+      if (seen.insert(var.id()).second) {
+        variables.push_back(var);
+      }
+    }
+  }
+
+  TRACE(INFO, "[Z3Solver] Retrying " << conjuncts.size()
+              << " conjunct(s) with tactic " << tactic);
+  SolverStatus status = check(fresh);
+  if (status == SolverStatus::SAT) {
+    z3::model m = fresh.get_model();
+    return Result(true, extractModel(m, variables, ctx));
+  }
+  return Result(status, map<string, unique_ptr<ResultValue>>());
+}
+
+// Groups share no conjuncts, so solving them one after the other on the
+// scope stack would pop everything the previous group pushed. Instead every
+// conjunct is asserted once in groupSolver, guarded by a literal of its own,
+// and a group is checked under the guards of its conjuncts. The conjuncts of
+// other groups stay asserted, satisfied by their guards being false.
+SolverStatus Z3Session::solveGroup(const vector<Expr *> &conjuncts,
+                                   NumberedModel &model) {
+  z3::context &ctx = inputMaker.getContext();
+  z3::expr_vector assumptions(ctx);
+  vector<z3::expr> variables;
+  set<unsigned int> seen;
+  for (Expr *conjunct : conjuncts) {
+    const Translation &translation = translate(conjunct);
+    auto guard = guards.find(conjunct);
+    if (guard == guards.end()) {
+      z3::expr literal =
+          ctx.bool_const(("group!" + to_string(guards.size())).c_str());
+      groupSolver.add(z3::implies(literal, translation.formula));
+      guard = guards.emplace(conjunct, literal).first;
+    }
+    assumptions.push_back(guard->second);
+    for (const auto &var : translation.variables) {
+      if (seen.insert(var.id()).second) {
+        variables.push_back(var);
+      }
+    }
+  }
+
+  TRACE(INFO, "[Z3Solver] Checking a group of " << conjuncts.size()
+              << " conjunct(s) under " << guards.size() << " guard(s)");
+  SolverStatus status = check(groupSolver, &assumptions);
+  if (status == SolverStatus::SAT) {
+    z3::model m = groupSolver.get_model();
+    model = extractModel(m, variables, inputMaker);
+  }
+  return status;
+}
+
+SolverStatus Z3Session::solveGroups(const vector<Expr *> &conjuncts,
+                                    const set<unsigned int> &needed,
+                                    vector<const NumberedModel *> &models) {
+  vector<Expr *> keys;
+  for (Expr *conjunct : conjuncts) {
+    keys.push_back(exprFactory->intern(*conjunct));
+  }
+  vector<ConstraintGroup> groups = partitionConstraints(keys);
+
+  unsigned int solved = 0, reused = 0, skipped = 0;
+  for (const ConstraintGroup &group : groups) {
+    vector<const Expr *> groupKey(group.conjuncts.begin(),
+                                  group.conjuncts.end());
+    auto cached = groupModels.find(groupKey);
+    if (cached == groupModels.end()) {
+      bool isNeeded = false;
+      for (unsigned int num : group.symVars) {
+        isNeeded = isNeeded || needed.count(num) > 0;
+      }
+      bool isFeasible = true;
+      for (Expr *conjunct : group.conjuncts) {
+        isFeasible = isFeasible && feasible.count(conjunct) > 0;
+      }
+      if (!isNeeded && isFeasible) {
+        // Satisfiable as part of an earlier query and irrelevant to this one
+        skipped++;
+        continue;
+      }
+
+      // Groups of earlier generations recur with other SymVar numbers; the
+      // counterexample cache answers them without Z3. Groups of simple
+      // bounds are cheaper to decide than to look up.
+      SolverStatus status;
+      NumberedModel groupModel;
+      bool isSat;
+      if (fastPath &&
+          LinearFastPath::decide(group.conjuncts, isSat, groupModel)) {
+        fastPathHits++;
+        status = isSat ? SolverStatus::SAT : SolverStatus::UNSAT;
+      } else {
+        CanonicalQuery query = canonicalizeQuery(group.conjuncts);
+        if (cexCache != nullptr &&
+            cexCache->lookup(query, isSat, groupModel)) {
+          status = isSat ? SolverStatus::SAT : SolverStatus::UNSAT;
+        } else {
+          status = solveGroup(group.conjuncts, groupModel);
+          // A query the solver gave up on may succeed with another budget
+          if (cexCache != nullptr && (status == SolverStatus::SAT ||
+                                      status == SolverStatus::UNSAT)) {
+            cexCache->insert(query, status == SolverStatus::SAT, groupModel);
+          }
+        }
+      }
+      solved++;
+      if (status != SolverStatus::SAT) {
+        groupsSolved += solved;
+        groupsReused += reused;
+        groupsSkipped += skipped;
+        return status;
+      }
+      cached = groupModels.emplace(groupKey, std::move(groupModel)).first;
+    } else {
+      reused++;
+    }
+    models.push_back(&cached->second);
+  }
+
+  TRACE(INFO, "[Z3Solver] Independence: " << groups.size() << " group(s), "
+              << solved << " solved, " << reused << " reused, " << skipped
+              << " skipped");
+  groupsSolved += solved;
+  groupsReused += reused;
+  groupsSkipped += skipped;
+  feasible.insert(keys.begin(), keys.end());
+  return SolverStatus::SAT;
+}
+
+Result Z3Session::solveSliced(const vector<Expr *> &conjuncts,
+                              const set<unsigned int> &needed) {
+  vector<const NumberedModel *> models;
+  SolverStatus status = solveGroups(conjuncts, needed, models);
+  map<string, unique_ptr<ResultValue>> model;
+  if (status == SolverStatus::SAT) {
+    for (const NumberedModel *groupModel : models) {
+      for (auto &entry : toNamedModel(*groupModel)) {
+        model[entry.first] = std::move(entry.second);
+      }
+    }
+  }
+  return Result(status, std::move(model));
+}
+
+TypedModel Z3Session::solveInputs(const vector<Expr *> &conjuncts,
+                                  const vector<unsigned int> &inputs) {
+  set<unsigned int> needed(inputs.begin(), inputs.end());
+  unsigned int size = needed.empty() ? 0 : *needed.rbegin() + 1;
+  vector<const NumberedModel *> models;
+  TypedModel typed(solveGroups(conjuncts, needed, models));
+  if (!typed.isSat()) {
+    return typed;
+  }
+  vector<bool> isInput(size, false);
+  for (unsigned int num : inputs) {
+    isInput[num] = true;
+  }
+  typed.values.assign(size, nullptr);
+  for (const NumberedModel *groupModel : models) {
+    for (const auto &entry : groupModel->symVars) {
+      if (entry.first < size && isInput[entry.first]) {
+        typed.values[entry.first] =
+            resultValueToExpr(*entry.second, *exprFactory);
+      }
+    }
+  }
+  // The groups of the inputs are all part of the answer, so an input
+  // without a value is in none: no conjunct constrains it. Any value will
+  // do; 0 is the one Z3's model completion gives.
+  for (unsigned int num : inputs) {
+    if (typed.values[num] == nullptr) {
+      typed.values[num] = exprFactory->num(0);
+    }
+  }
+  return typed;
+}
+
 // ============================================================================
 // Z3Solver Implementation
 // ============================================================================
 
-Z3Solver::Z3Solver(TypeMap *tm) : typeMap(tm) {}
+Z3Solver::Z3Solver(TypeMap *tm)
+    : typeMap(tm), fastPath(false), queryLog(nullptr) {}
+
+static void flattenConjunction(Expr *expr, vector<Expr *> &conjuncts) {
+  FuncCall *fc = expr->exprType == ExprType::FUNC_CALL_EXPR
+                     ? dynamic_cast<FuncCall *>(expr)
+                     : nullptr;
+  if (fc != nullptr && fc->op == Opcode::AND && fc->args.size() == 2) {
+    flattenConjunction(fc->args[0].get(), conjuncts);
+    flattenConjunction(fc->args[1].get(), conjuncts);
+  } else {
+    conjuncts.push_back(expr);
+  }
+}
 
 Result Z3Solver::solve(unique_ptr<Expr> formula) const {
-  Z3InputMaker inputMaker(typeMap);
+  vector<Expr *> conjuncts;
+  flattenConjunction(formula.get(), conjuncts);
+  CanonicalQuery query = canonicalizeQuery(conjuncts);
+  bool isSat;
+  NumberedModel cached;
+  if (cexCache.lookup(query, isSat, cached)) {
+    TRACE(INFO, "[Z3Solver] Counterexample cache hit: "
+                << (isSat ? "SAT" : "UNSAT"));
+    return Result(isSat, toNamedModel(cached));
+  }
+
+  // The lease must outlive every Z3 object of the query
+  Z3ContextPool::Lease lease = Z3ContextPool::getInstance().acquire();
+  Z3InputMaker inputMaker(lease->getContext(), typeMap);
 
   // Convert the formula to Z3 format
   z3::expr z3Formula = inputMaker.makeZ3Input(formula);
 
-  // Create solver and add the constraint
-  z3::solver s(inputMaker.getContext());
+  // The pooled solver starts without assertions
+  z3::solver &s = lease->getSolver();
   s.add(z3Formula);
 
-  cout << "[Z3Solver] Checking satisfiability..." << endl;
-  cout << "[Z3Solver] Formula: " << z3Formula << endl;
+  TRACE(INFO, "[Z3Solver] Checking satisfiability...");
+  TRACE(DEBUG, "[Z3Solver] Formula: " << z3Formula);
 
-  if (s.check() == z3::sat) {
-    cout << "[Z3Solver] SAT - Model found!" << endl;
+  SolverStatus status = checkWithBudget(s, *lease, budget, 0, queryLog);
+  if (status == SolverStatus::SAT) {
+    TRACE(INFO, "[Z3Solver] SAT - Model found!");
     z3::model m = s.get_model();
 
-    // Extract variable values from the model
-    map<string, unique_ptr<ResultValue>> var_values;
-
-    // Get all variables that were used
-    vector<z3::expr> vars = inputMaker.getVariables();
-    for (const auto &var : vars) {
-      z3::expr val = m.eval(var, true);
-      string varName = var.to_string();
-
-      // Handle different types of values
-      if (val.is_numeral()) {
-        int intVal;
-        if (val.is_int() &&
-            Z3_get_numeral_int(inputMaker.getContext(), val, &intVal)) {
-          cout << "[Z3Solver] " << varName << " = " << intVal << endl;
-          var_values[varName] = make_unique<IntResultValue>(intVal);
-        }
-      } else if (val.is_string_value()) {
-        string strVal = val.get_string();
-        cout << "[Z3Solver] " << varName << " = \"" << strVal << "\"" << endl;
-        var_values[varName] = make_unique<StringResultValue>(strVal);
-      } else if (val.is_bool()) {
-        bool boolVal = val.is_true();
-        cout << "[Z3Solver] " << varName << " = "
-             << (boolVal ? "true" : "false") << endl;
-        var_values[varName] = make_unique<BoolResultValue>(boolVal);
-      } else if (val.is_array()) {
-        // For arrays (sets/maps), store as string representation
-        cout << "[Z3Solver] " << varName << " = " << val << " (array)" << endl;
-        var_values[varName] = make_unique<StringResultValue>(val.to_string());
-      } else {
-        cout << "[Z3Solver] " << varName << " = " << val << " (unknown type)"
-             << endl;
-        var_values[varName] = make_unique<StringResultValue>(val.to_string());
-      }
-    }
+    // Extract the values of all variables that were used
+    NumberedModel model =
+        extractModel(m, inputMaker.getVariables(), inputMaker);
+    cexCache.insert(query, true, model);
+    return Result(true, toNamedModel(model));
+  }
+  if (status == SolverStatus::UNSAT) {
+    TRACE(INFO, "[Z3Solver] UNSAT - No solution exists");
+    cexCache.insert(query, false, NumberedModel());
+  }
+  return Result(status, map<string, unique_ptr<ResultValue>>());
+}
 
-    return Result(true, std::move(var_values));
-  } else {
-    cout << "[Z3Solver] UNSAT - No solution exists" << endl;
-    return Result(false, map<string, unique_ptr<ResultValue>>());
+void Z3Solver::beginSession() {
+  session = make_unique<Z3Session>(typeMap, exprFactory, &cexCache, budget);
+  session->setFastPath(fastPath);
+  session->setQueryLog(queryLog);
+}
+
+void Z3Solver::endSession() { session.reset(); }
+
+Result Z3Solver::solveIncremental(const vector<Expr *> &conjuncts) {
+  if (!inSession()) {
+    beginSession();
+  }
+  return session->solve(conjuncts);
+}
+
+Result Z3Solver::solveSliced(const vector<Expr *> &conjuncts,
+                             const set<unsigned int> &needed) {
+  if (!inSession()) {
+    beginSession();
+  }
+  return session->solveSliced(conjuncts, needed);
+}
+
+TypedModel Z3Solver::solveInputs(const vector<Expr *> &conjuncts,
+                                 const vector<unsigned int> &inputs) {
+  if (!inSession()) {
+    beginSession();
+  }
+  return session->solveInputs(conjuncts, inputs);
+}
+
+vector<unique_ptr<Result>>
+Z3Solver::enumerateModels(const vector<Expr *> &conjuncts,
+                          const vector<unsigned int> &inputs,
+                          size_t maxModels) {
+  if (!inSession()) {
+    beginSession();
+  }
+  return session->enumerateModels(conjuncts, inputs, maxModels);
+}
+
+vector<size_t> Z3Solver::unsatCore(const vector<Expr *> &conjuncts) {
+  if (!inSession()) {
+    beginSession();
+  }
+  return session->unsatCore(conjuncts);
+}
+
+Result Z3Solver::retry(const vector<Expr *> &conjuncts, const string &tactic) {
+  if (!inSession()) {
+    beginSession();
   }
+  return session->retry(conjuncts, tactic);
 }
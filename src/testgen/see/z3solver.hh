@@ -1,25 +1,56 @@
 #ifndef Z3SOLVER_HH
 #define Z3SOLVER_HH
 
+#include <map>
 #include <memory>
+#include <set>
 #include <stack>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "../language/exprfactory.hh"
 #include "../language/typemap.hh"
 #include "../language/visitor.hh"
+#include "cexcache.hh"
+#include "querylog.hh"
 #include "solver.hh"
+#include "z3pool.hh"
 #include "z3++.h"
 
 using namespace std;
 
+// Translates expressions to Z3 terms on a context it borrows; the context must
+// outlive it.
 class Z3InputMaker : public Visitor {
 private:
-  z3::context ctx;
+  z3::context &ctx;
   stack<z3::expr> theStack;
   vector<z3::expr> variables;
-  map<unsigned int, z3::expr *> symVarMap; // Map SymVar numbers to Z3 variables
+  // Z3 variable of each SymVar, indexed by its number; SymVars are numbered
+  // densely per session
+  vector<unique_ptr<z3::expr>> symVarExprs;
+  unordered_map<unsigned int, unsigned int> symVarNums; // Z3 id -> number
   map<string, z3::expr *> namedVarMap; // Map named variables to Z3 expressions
   TypeMap *typeMap;                    // Type information for variables
+  vector<z3::expr> referenced; // Variables used since the last take
+  set<unsigned int> referencedIds;
+
+  // Translation of every node translated so far, with the variables it
+  // refers to, so that shared subexpressions are translated once. Nodes are
+  // keyed by address and must outlive the maker: in a session they are the
+  // canonical nodes of its ExprFactory.
+  struct MemoEntry {
+    z3::expr term;
+    vector<z3::expr> variables;
+  };
+  unordered_map<const Expr *, MemoEntry> memo;
+  vector<z3::expr> nodeVariables; // met by the translations in progress
+  unsigned int memoHits;
+
+  z3::expr translate(const Expr *expr);
+  z3::expr symVarToZ3(unsigned int num);
+  void noteReferenced(const z3::expr &var);
 
   // Z3 sorts for custom types
   z3::sort getStringSort();
@@ -36,12 +67,19 @@ private:
   z3::expr makeEmptyMap(z3::sort keySort, z3::sort valueSort);
 
 public:
-  Z3InputMaker(TypeMap *typeMap = nullptr);
+  Z3InputMaker(z3::context &ctx, TypeMap *typeMap = nullptr);
   ~Z3InputMaker();
   z3::expr makeZ3Input(unique_ptr<Expr> &expr);
   z3::expr makeZ3Input(Expr *expr);
   vector<z3::expr> getVariables();
+  // Whether var is the Z3 variable of a SymVar, and which
+  bool findSymVar(const z3::expr &var, unsigned int &num) const;
+  // Variables referenced by the translations since the previous call,
+  // including ones that only register a variable such as Any(x).
+  vector<z3::expr> takeReferencedVariables();
   z3::context &getContext() { return ctx; }
+  size_t getMemoSize() const { return memo.size(); }
+  unsigned int getMemoHits() const { return memoHits; }
 
 protected:
   // Expression visitor methods (protected, called by base class)
@@ -67,7 +105,7 @@ protected:
   void visitAssert(const Assert &node) override;
 
   // Declaration/High-level visitor methods
-  z3::expr convertArg(const unique_ptr<Expr> &arg);
+  z3::expr convertArg(const shared_ptr<Expr> &arg);
 
 public:
   // High-level visitor methods
@@ -80,12 +118,208 @@ public:
   void visitProgram(const Program &node) override;
 };
 
+// Read the values of vars out of a model in the form expected by Result
+map<string, unique_ptr<ResultValue>>
+extractModel(z3::model &m, const vector<z3::expr> &vars, z3::context &ctx);
+// The same with the SymVars among vars by number
+NumberedModel extractModel(z3::model &m, const vector<z3::expr> &vars,
+                           const Z3InputMaker &inputMaker);
+
+// A model as constants of an ExprFactory, indexed by SymVar number: values[n]
+// is the value of X<n>, nullptr for a SymVar the model has no value for or
+// that was not asked for
+struct TypedModel {
+  SolverStatus status;
+  vector<Expr *> values;
+  TypedModel(SolverStatus s = SolverStatus::UNKNOWN) : status(s) {}
+  Expr *get(unsigned int num) const {
+    return num < values.size() ? values[num] : nullptr;
+  }
+  bool isSat() const { return status == SolverStatus::SAT; }
+  bool isDecided() const {
+    return status == SolverStatus::SAT || status == SolverStatus::UNSAT;
+  }
+};
+
+// Constant of a model value; nullptr for values without one, e.g. arrays
+Expr *resultValueToExpr(const ResultValue &value, ExprFactory &factory);
+// The values of the given SymVars in a result, which names them X<n> as
+// every Solver does
+TypedModel toTypedModel(const Result &result, const vector<unsigned int> &nums,
+                        ExprFactory &factory);
+
+// Check s within the budget, under the assumptions if given. remainingMs is
+// what is left of a session budget, 0 if there is none. The query goes to
+// the log, if any, with its result and time.
+SolverStatus checkWithBudget(z3::solver &s, Z3PooledContext &context,
+                             const SolverBudget &budget,
+                             unsigned int remainingMs,
+                             QueryLog *queryLog = nullptr,
+                             const z3::expr_vector *assumptions = nullptr);
+
+// Z3Session: a Z3 context and solver that live across several queries. Both
+// are leased from the Z3ContextPool for the lifetime of the session.
+// Every conjunct of a path constraint is asserted in its own push scope. A
+// query that extends the previous one only translates and asserts the new
+// conjuncts; a query that diverges pops back to the longest common prefix.
+// Learned clauses stay in the solver and the translated conjuncts are kept in
+// termCache for the lifetime of the session; below the conjuncts, the input
+// maker translates each shared subexpression once. Conjuncts are identified by their
+// canonical node in the session's ExprFactory, so comparing them is a pointer
+// comparison.
+class Z3Session {
+private:
+  struct Translation {
+    z3::expr formula;
+    vector<z3::expr> variables; // variables the conjunct refers to
+  };
+
+  shared_ptr<ExprFactory> exprFactory;
+  CexCache *cexCache; // consulted by solveSliced, may be null
+  SolverBudget budget;
+  unsigned long timeUsedMs; // by the checks of this session
+  // Declared first: every Z3 object below lives on the leased context
+  Z3ContextPool::Lease lease;
+  Z3InputMaker inputMaker;
+  z3::solver &solver;
+  vector<const Expr *> scopeKeys;       // canonical conjunct in each scope
+  vector<const Translation *> scopes;   // its translation, from termCache
+  map<const Expr *, Translation> termCache;
+  unsigned int cacheHits;
+  // Solves the groups of independence slicing, each under the guards of its
+  // conjuncts, leaving the scope stack of solver alone
+  z3::solver groupSolver;
+  map<const Expr *, z3::expr> guards; // canonical conjunct -> its guard
+
+  // Independence slicing: models of the groups solved so far, keyed by the
+  // group's canonical conjuncts, and the conjuncts known to be satisfiable
+  // together because they were part of a satisfiable query
+  map<vector<const Expr *>, NumberedModel> groupModels;
+  set<const Expr *> feasible;
+  unsigned int groupsSolved;
+  unsigned int groupsReused;
+  unsigned int groupsSkipped;
+  // Decide groups within LinearFastPath's fragment without Z3
+  bool fastPath;
+  unsigned int fastPathHits;
+  QueryLog *queryLog; // may be null
+
+  const Translation &translate(Expr *conjunct);
+  vector<z3::expr> getAssertedVariables();
+  // TIMEOUT without calling Z3 once the session budget is used up
+  SolverStatus check(z3::solver &s,
+                     const z3::expr_vector *assumptions = nullptr);
+  // One group of solveGroups, in groupSolver; conjuncts must be canonical
+  SolverStatus solveGroup(const vector<Expr *> &conjuncts,
+                          NumberedModel &model);
+  // The slicing of solveSliced; on SAT, models holds the model of every
+  // group that is part of the answer
+  SolverStatus solveGroups(const vector<Expr *> &conjuncts,
+                           const set<unsigned int> &needed,
+                           vector<const NumberedModel *> &models);
+
+public:
+  Z3Session(TypeMap *typeMap, shared_ptr<ExprFactory> exprFactory = nullptr,
+            CexCache *cexCache = nullptr,
+            const SolverBudget &budget = SolverBudget());
+  Result solve(const vector<Expr *> &conjuncts);
+  // Solve the conjuncts together, without slicing, on a new solver built
+  // from the given Z3 tactic, e.g. after the incremental solver gave up.
+  // Counts against the session budget.
+  Result retry(const vector<Expr *> &conjuncts, const string &tactic);
+  // Indices of a subset of the conjuncts that is UNSAT by itself, in
+  // increasing order; empty if the conjuncts are not UNSAT or the solver
+  // gave up. Not minimal, but usually small. Counts against the session
+  // budget.
+  vector<size_t> unsatCore(const vector<Expr *> &conjuncts);
+  // Up to maxModels models of the conjuncts, each differing from the ones
+  // before in the value of at least one of the input SymVars. Every later
+  // model costs one check with a blocking clause, in the same solver. Empty
+  // if the conjuncts are not SAT.
+  vector<unique_ptr<Result>> enumerateModels(const vector<Expr *> &conjuncts,
+                                             const vector<unsigned int> &inputs,
+                                             size_t maxModels);
+  // Splits the conjuncts into independent groups and only solves the groups
+  // that mention a needed SymVar or a conjunct not yet known to be
+  // feasible. A group solved before answers with its cached model; any
+  // other group is left out of the model. Groups to solve go through the
+  // fast path, if enabled, and then the counterexample cache.
+  Result solveSliced(const vector<Expr *> &conjuncts,
+                     const set<unsigned int> &needed);
+  // solveSliced for the given input SymVars, with their values as
+  // constants of the session's ExprFactory. Only the inputs are converted;
+  // inputs the conjuncts do not constrain are 0.
+  TypedModel solveInputs(const vector<Expr *> &conjuncts,
+                         const vector<unsigned int> &inputs);
+  size_t getNumScopes() const { return scopeKeys.size(); }
+  unsigned int getCacheHits() const { return cacheHits; }
+  // Subexpressions of new conjuncts that were translated before
+  unsigned int getSubtermHits() const { return inputMaker.getMemoHits(); }
+  unsigned int getGroupsSolved() const { return groupsSolved; }
+  unsigned int getGroupsReused() const { return groupsReused; }
+  unsigned int getGroupsSkipped() const { return groupsSkipped; }
+  unsigned long getTimeUsedMs() const { return timeUsedMs; }
+  void setFastPath(bool enabled) { fastPath = enabled; }
+  // Groups decided by LinearFastPath
+  unsigned int getFastPathHits() const { return fastPathHits; }
+  void setQueryLog(QueryLog *log) { queryLog = log; }
+};
+
 class Z3Solver : public Solver {
 private:
   TypeMap *typeMap;
+  shared_ptr<ExprFactory> exprFactory;
+  unique_ptr<Z3Session> session;
+  // Outlives sessions, so that the queries of one generation answer the
+  // ones of the next
+  mutable CexCache cexCache;
+  SolverBudget budget;
+  bool fastPath;
+  QueryLog *queryLog;
 
 public:
   Z3Solver(TypeMap *typeMap = nullptr);
+  // The conjuncts of a top-level conjunction go through the counterexample
+  // cache. A query borrows a context from the Z3ContextPool.
   Result solve(unique_ptr<Expr>) const;
+  CexCache &getCexCache() { return cexCache; }
+  // Limits of later queries and sessions. A query that runs out of them is
+  // UNKNOWN or TIMEOUT, and is not cached.
+  void setBudget(const SolverBudget &b) { budget = b; }
+  const SolverBudget &getBudget() const { return budget; }
+  // Let sessions begun afterwards decide simple groups in solveSliced
+  // without Z3, see LinearFastPath. Off by default.
+  void setFastPath(bool enabled) { fastPath = enabled; }
+  // Capture every query checked from now on, including the ones of sessions
+  // begun afterwards; nullptr to stop. The log must outlive its use.
+  void setQueryLog(QueryLog *log) { queryLog = log; }
+
+  // Factory the conjuncts passed to solveIncremental come from. Sessions
+  // begun afterwards use it; without one each session has its own.
+  void setExprFactory(shared_ptr<ExprFactory> factory) {
+    exprFactory = factory;
+  }
+
+  // Incremental mode: solveIncremental reuses one Z3Session until
+  // endSession() is called. It opens a session on first use if needed.
+  void beginSession();
+  void endSession();
+  bool inSession() const { return session != nullptr; }
+  Z3Session *getSession() { return session.get(); }
+  Result solveIncremental(const vector<Expr *> &conjuncts);
+  // Incremental mode with independence slicing, see Z3Session::solveSliced
+  Result solveSliced(const vector<Expr *> &conjuncts,
+                     const set<unsigned int> &needed);
+  // See Z3Session::solveInputs
+  TypedModel solveInputs(const vector<Expr *> &conjuncts,
+                         const vector<unsigned int> &inputs);
+  // See Z3Session::enumerateModels
+  vector<unique_ptr<Result>> enumerateModels(const vector<Expr *> &conjuncts,
+                                             const vector<unsigned int> &inputs,
+                                             size_t maxModels);
+  // See Z3Session::retry
+  Result retry(const vector<Expr *> &conjuncts, const string &tactic);
+  // See Z3Session::unsatCore
+  vector<size_t> unsatCore(const vector<Expr *> &conjuncts);
 };
 #endif
@@ -3,12 +3,20 @@
 #include "../../language/env.hh"
 #include "../../language/printer.hh"
 #include "../../language/typemap.hh"
+#include "../../tester/enumerator.hh"
 #include "../../tester/genATC.hh"
+#include "../../tester/prefixes.hh"
 #include "../../tester/test_utils.hh"
 #include "../../tester/tester.hh"
+#include "../../util/threadpool.hh"
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
 
 using namespace std;
 
@@ -638,6 +646,399 @@ protected:
   }
 };
 
+/**
+ * Batch generation runs jobs on a WorkStealingPool: every job must run
+ * exactly once, per-worker state must not be shared, and a failing job must
+ * surface deterministically
+ */
+/**
+ * E2E Test 4: several CTCs of the f1 ATC of test 1, from distinct models of
+ * its path constraint x0 > 0 AND z0 > 0
+ */
+class MultiModelTest : public E2ETest1 {
+public:
+  void execute() {
+    std::cout << "\n" << string(80, '=') << std::endl;
+    std::cout << "E2E Test: Several CTCs per ATC" << std::endl;
+    std::cout << string(80, '=') << std::endl;
+
+    std::unique_ptr<Spec> spec = makeSpec();
+    SymbolTable *globalSymTable = makeSymbolTables();
+    ATCGenerator generator(spec.get(), TypeMap());
+    Program atc =
+        generator.generate(spec.get(), globalSymTable, makeTestString());
+    std::unique_ptr<Program> atcCopy = std::make_unique<Program>(std::move(
+        const_cast<std::vector<std::unique_ptr<Stmt>> &>(atc.statements)));
+
+    App1FunctionFactory functionFactory;
+    Tester tester(&functionFactory);
+    ValueEnvironment ve(nullptr);
+    std::vector<std::unique_ptr<Program>> ctcs =
+        tester.generateCTCs(std::move(atcCopy), 3, &ve);
+    assert(ctcs.size() == 3);
+
+    // Every CTC is complete, and no two give the inputs the same values
+    std::set<std::vector<int>> assignments;
+    for (const auto &ctc : ctcs) {
+      printer.visitProgram(*ctc);
+      verify(*ctc);
+      std::vector<int> values;
+      for (const auto &stmt : ctc->statements) {
+        const Assign *assign = dynamic_cast<const Assign *>(stmt.get());
+        if (assign && assign->right->exprType == ExprType::NUM) {
+          values.push_back(
+              dynamic_cast<const Num *>(assign->right.get())->value);
+        }
+      }
+      assignments.insert(values);
+    }
+    assert(assignments.size() == 3);
+    cleanup(globalSymTable);
+
+    std::cout << "  ✓ 3 CTCs with distinct inputs" << std::endl;
+  }
+};
+
+class UnsatCoreTest {
+  static std::unique_ptr<Stmt> assume(const string &op, const string &var,
+                                      int value) {
+    return std::make_unique<Assume>(TestUtils::makeBinOp(
+        op, std::make_unique<Var>(var), std::make_unique<Num>(value)));
+  }
+
+  static std::unique_ptr<Stmt> call(const string &api,
+                                    std::vector<string> args) {
+    std::vector<std::unique_ptr<Expr>> callArgs;
+    for (const string &arg : args) {
+      callArgs.push_back(std::make_unique<Var>(arg));
+    }
+    return std::make_unique<Assign>(
+        std::make_unique<Var>("r"),
+        std::make_unique<FuncCall>(api, std::move(callArgs)));
+  }
+
+public:
+  void execute() {
+    std::cout << "\n" << string(80, '=') << std::endl;
+    std::cout << "E2E Test: Unsat cores and infeasible prefixes" << std::endl;
+    std::cout << string(80, '=') << std::endl;
+
+    App1FunctionFactory functionFactory;
+    Tester tester(&functionFactory);
+    ValueEnvironment ve(nullptr);
+
+    // The second block contradicts the first whatever the inputs
+    std::vector<std::unique_ptr<Stmt>> stmts;
+    stmts.push_back(TestUtils::makeInputAssign("x0"));
+    stmts.push_back(assume("gt", "x0", 5));
+    stmts.push_back(call("f2", {}));
+    stmts.push_back(TestUtils::makeInputAssign("z1"));
+    stmts.push_back(assume("lt", "x0", 3));
+    stmts.push_back(assume("gt", "z1", 0));
+    tester.generateCTC(std::make_unique<Program>(std::move(stmts)), {}, &ve);
+    assert(tester.getUnsatCoreStatements() == std::vector<size_t>({1, 4}));
+    assert(InfeasiblePrefixes::prefixLength(
+               {0, 3}, tester.getUnsatCoreStatements()) == 2);
+    assert(InfeasiblePrefixes::prefixLength(
+               {0, 5}, tester.getUnsatCoreStatements()) == 1);
+    assert(InfeasiblePrefixes::prefixLength({2}, {0, 1}) == 0);
+
+    // Infeasible only with the value chosen for x0 before f1: no core
+    stmts.clear();
+    stmts.push_back(TestUtils::makeInputAssign("x0"));
+    stmts.push_back(assume("gt", "x0", 0));
+    stmts.push_back(call("f1", {"x0", "x0"}));
+    stmts.push_back(assume("gt", "x0", 5));
+    tester.generateCTC(std::make_unique<Program>(std::move(stmts)), {}, &ve);
+    assert(tester.getUnsatCoreStatements().empty());
+
+    // x0 was given its value by an earlier generation, as in the prefix of
+    // a SequenceEnumerator node: r is a response to that choice, so an
+    // assume on it that fails makes no core
+    stmts.clear();
+    stmts.push_back(std::make_unique<Assign>(std::make_unique<Var>("x0"),
+                                             std::make_unique<Num>(1)));
+    stmts.push_back(call("f1", {"x0", "x0"}));
+    stmts.push_back(TestUtils::makeInputAssign("z1"));
+    stmts.push_back(assume("gt", "r", 5));
+    stmts.push_back(assume("gt", "z1", 0));
+    tester.setChosenStatements({0});
+    tester.generateCTC(std::make_unique<Program>(std::move(stmts)), {}, &ve);
+    tester.setChosenStatements({});
+    assert(tester.getUnsatCoreStatements().empty());
+
+    // Folds to false: the assume is the core, found without the solver
+    stmts.clear();
+    stmts.push_back(TestUtils::makeInputAssign("x0"));
+    stmts.push_back(assume("gt", "x0", 0));
+    stmts.push_back(std::make_unique<Assume>(TestUtils::makeBinOp(
+        "lt", std::make_unique<Num>(3), std::make_unique<Num>(2))));
+    tester.generateCTC(std::make_unique<Program>(std::move(stmts)), {}, &ve);
+    assert(tester.getUnsatCoreStatements() == std::vector<size_t>({2}));
+
+    InfeasiblePrefixes prefixes;
+    prefixes.add({"f1", "f2"});
+    std::vector<string> prefix;
+    assert(prefixes.blocks({"f1", "f2", "f1"}, &prefix));
+    assert(prefix == std::vector<string>({"f1", "f2"}));
+    assert(!prefixes.blocks({"f1"}));
+    assert(!prefixes.blocks({"f2", "f1", "f2"}));
+    assert(prefixes.getSkips() == 1);
+    // The initialization alone: every test string
+    prefixes.add({});
+    assert(prefixes.blocks({"f2"}));
+    assert(prefixes.size() == 2);
+
+    std::cout << "  ✓ Core mapped to its assume statements and blocks"
+              << std::endl;
+  }
+};
+
+class ForkingTest {
+public:
+  void execute() {
+    std::cout << "\n" << string(80, '=') << std::endl;
+    std::cout << "E2E Test: Infeasible disjunct of a precondition"
+              << std::endl;
+    std::cout << string(80, '=') << std::endl;
+
+    App1FunctionFactory functionFactory;
+    Tester tester(&functionFactory);
+    tester.setForking(true);
+    ValueEnvironment ve(nullptr);
+
+    // x0 := input(); assume(or(and(gt(x0, 5), lt(x0, 3)), gt(x0, 0)));
+    // r := f1(x0, x0)
+    std::vector<std::unique_ptr<Stmt>> stmts;
+    stmts.push_back(TestUtils::makeInputAssign("x0"));
+    stmts.push_back(std::make_unique<Assume>(TestUtils::makeBinOp(
+        "or",
+        TestUtils::makeBinOp(
+            "and",
+            TestUtils::makeBinOp("gt", std::make_unique<Var>("x0"),
+                                 std::make_unique<Num>(5)),
+            TestUtils::makeBinOp("lt", std::make_unique<Var>("x0"),
+                                 std::make_unique<Num>(3))),
+        TestUtils::makeBinOp("gt", std::make_unique<Var>("x0"),
+                             std::make_unique<Num>(0)))));
+    std::vector<std::unique_ptr<Expr>> args;
+    args.push_back(std::make_unique<Var>("x0"));
+    args.push_back(std::make_unique<Var>("x0"));
+    stmts.push_back(std::make_unique<Assign>(
+        std::make_unique<Var>("r"),
+        std::make_unique<FuncCall>("f1", std::move(args))));
+    std::unique_ptr<Program> ctc = tester.generateCTC(
+        std::make_unique<Program>(std::move(stmts)), {}, &ve);
+
+    // The first disjunct's path is infeasible; the second one's gives x0
+    const Assign *input = dynamic_cast<const Assign *>(ctc->statements[0].get());
+    const Num *value = dynamic_cast<const Num *>(input->right.get());
+    assert(value && value->value > 0);
+    assert(tester.getUnsatCoreStatements().empty());
+
+    std::cout << "  ✓ Input chosen on the path of the feasible disjunct"
+              << std::endl;
+  }
+};
+
+class WorkStealingPoolTest {
+public:
+  void execute() {
+    std::cout << "\n" << string(80, '=') << std::endl;
+    std::cout << "Pool Test: WorkStealingPool" << std::endl;
+    std::cout << string(80, '=') << std::endl;
+
+    WorkStealingPool pool(4);
+    assert(pool.getNumWorkers() == 4);
+
+    // Uneven jobs so that the workers with cheap jobs steal
+    const size_t numJobs = 200;
+    std::vector<std::atomic<int>> runs(numJobs);
+    std::vector<size_t> results(numJobs);
+    std::vector<size_t> busy(pool.getNumWorkers(), 0);
+    pool.run(numJobs, [&](size_t job, size_t worker) {
+      assert(worker < busy.size());
+      assert(busy[worker] == 0);
+      busy[worker]++;
+      runs[job]++;
+      if (job % 4 == 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+      results[job] = job * job;
+      busy[worker]--;
+    });
+    for (size_t job = 0; job < numJobs; job++) {
+      assert(runs[job] == 1);
+      assert(results[job] == job * job);
+    }
+    std::cout << "  ✓ Every job ran exactly once" << std::endl;
+
+    bool caught = false;
+    try {
+      pool.run(numJobs, [](size_t job, size_t) {
+        if (job == 7 || job == 150) {
+          throw std::runtime_error("job " + std::to_string(job));
+        }
+      });
+    } catch (const std::runtime_error &e) {
+      caught = true;
+      assert(string(e.what()) == "job 7");
+    }
+    assert(caught);
+    std::cout << "  ✓ Lowest failing job is rethrown" << std::endl;
+  }
+};
+
+/**
+ * Enumerates the test strings of up to 2 calls over the spec of E2ETest2.
+ * Every child in the trie starts with the CTC of its parent, so that the
+ * inputs of a prefix are solved for once.
+ */
+class SequenceEnumerationTest : public E2ETest2 {
+  static string stmtToString(const Stmt &stmt) {
+    if (const Assign *assign = dynamic_cast<const Assign *>(&stmt)) {
+      return assign->left->name + " := " + assign->right->toString();
+    }
+    if (const Assume *assume = dynamic_cast<const Assume *>(&stmt)) {
+      return "assume(" + assume->expr->toString() + ")";
+    }
+    if (const Assert *check = dynamic_cast<const Assert *>(&stmt)) {
+      return "assert(" + check->expr->toString() + ")";
+    }
+    return "";
+  }
+
+public:
+  void execute() {
+    std::cout << "\n" << string(80, '=') << std::endl;
+    std::cout << "E2E Test: API sequence enumeration" << std::endl;
+    std::cout << string(80, '=') << std::endl;
+
+    std::unique_ptr<Spec> spec = makeSpec();
+    SymbolTable *globalSymTable = makeSymbolTables();
+    App1FunctionFactory functionFactory;
+    Tester tester(&functionFactory);
+    SequenceEnumerator enumerator(
+        spec.get(), globalSymTable, tester,
+        [] { return std::make_unique<App1FunctionFactory>(); }, 2);
+    std::vector<EnumeratedTest> tests = enumerator.enumerate();
+
+    std::vector<std::vector<string>> expected = {
+        {"f1"}, {"f1", "f1"}, {"f1", "f2"},
+        {"f2"}, {"f2", "f1"}, {"f2", "f2"}};
+    assert(tests.size() == expected.size());
+    for (size_t i = 0; i < tests.size(); i++) {
+      assert(tests[i].testString == expected[i]);
+      assert(tests[i].ctc != nullptr);
+    }
+    assert(enumerator.getPruned() == 0);
+    assert(enumerator.getSolvedBlocks() == 6);
+
+    // A child repeats its parent's CTC, then concretizes its own block
+    for (size_t parent : {0, 3}) {
+      const Program &prefix = *tests[parent].ctc;
+      for (size_t child = parent + 1; child < parent + 3; child++) {
+        const Program &ctc = *tests[child].ctc;
+        assert(ctc.statements.size() > prefix.statements.size());
+        for (size_t i = 0; i < prefix.statements.size(); i++) {
+          assert(stmtToString(*ctc.statements[i]) ==
+                 stmtToString(*prefix.statements[i]));
+        }
+      }
+    }
+    for (const auto &test : tests) {
+      for (const auto &stmt : test.ctc->statements) {
+        const Assign *assign = dynamic_cast<const Assign *>(stmt.get());
+        const FuncCall *call =
+            assign ? dynamic_cast<const FuncCall *>(assign->right.get())
+                   : nullptr;
+        assert(!call || call->name != "input");
+      }
+    }
+    cleanup(globalSymTable);
+
+    std::cout << "  ✓ 6 test strings, prefixes concretized once" << std::endl;
+  }
+};
+
+class ExplorationTest {
+  static std::unique_ptr<Expr> compare(const string &op, const string &var,
+                                       int value) {
+    return TestUtils::makeBinOp(op, std::make_unique<Var>(var),
+                                std::make_unique<Num>(value));
+  }
+
+  static int inputValue(const Program &ctc, size_t statement) {
+    const Assign *input =
+        dynamic_cast<const Assign *>(ctc.statements[statement].get());
+    const Num *value = dynamic_cast<const Num *>(input->right.get());
+    assert(value);
+    return value->value;
+  }
+
+  // x0 := input(); assume(or(lt(x0, 0), gt(x0, 10)));
+  // z1 := input(); assume(or(eq(z1, 1), or(eq(z1, 2),
+  //                          and(gt(z1, 5), lt(z1, 3)))));
+  // r := f1(x0, z1)
+  // 2 * 3 paths, of which the 2 through the last disjunct are infeasible
+  static std::unique_ptr<Program> makeATC() {
+    std::vector<std::unique_ptr<Stmt>> stmts;
+    stmts.push_back(TestUtils::makeInputAssign("x0"));
+    stmts.push_back(std::make_unique<Assume>(TestUtils::makeBinOp(
+        "or", compare("lt", "x0", 0), compare("gt", "x0", 10))));
+    stmts.push_back(TestUtils::makeInputAssign("z1"));
+    stmts.push_back(std::make_unique<Assume>(TestUtils::makeBinOp(
+        "or", compare("eq", "z1", 1),
+        TestUtils::makeBinOp(
+            "or", compare("eq", "z1", 2),
+            TestUtils::makeBinOp("and", compare("gt", "z1", 5),
+                                 compare("lt", "z1", 3))))));
+    std::vector<std::unique_ptr<Expr>> args;
+    args.push_back(std::make_unique<Var>("x0"));
+    args.push_back(std::make_unique<Var>("z1"));
+    stmts.push_back(std::make_unique<Assign>(
+        std::make_unique<Var>("r"),
+        std::make_unique<FuncCall>("f1", std::move(args))));
+    return std::make_unique<Program>(std::move(stmts));
+  }
+
+public:
+  void execute() {
+    std::cout << "\n" << string(80, '=') << std::endl;
+    std::cout << "E2E Test: Path exploration with each searcher" << std::endl;
+    std::cout << string(80, '=') << std::endl;
+
+    for (const char *name : {"dfs", "bfs", "random", "coverage"}) {
+      App1FunctionFactory functionFactory;
+      Tester tester(&functionFactory);
+      ValueEnvironment ve(nullptr);
+      std::unique_ptr<Searcher> searcher = makeSearcher(name, {}, 1);
+      Exploration exploration = tester.explorePaths(
+          makeATC(), *searcher,
+          [] { return std::make_unique<App1FunctionFactory>(); }, 0, &ve);
+
+      assert(exploration.stats.searcher == name);
+      assert(exploration.stats.paths == 6);
+      assert(exploration.stats.tests == 4);
+      assert(exploration.stats.firstTestSeconds >= 0);
+      // One test for each feasible pair of disjuncts
+      std::set<std::pair<bool, int>> taken;
+      for (const auto &ctc : exploration.ctcs) {
+        int x0 = inputValue(*ctc, 0);
+        int z1 = inputValue(*ctc, 2);
+        assert(x0 < 0 || x0 > 10);
+        taken.insert(std::make_pair(x0 < 0, z1));
+      }
+      std::set<std::pair<bool, int>> expected = {
+          {true, 1}, {true, 2}, {false, 1}, {false, 2}};
+      assert(taken == expected);
+      std::cout << "  ✓ " << name << ": " << exploration.stats.paths
+                << " paths, " << exploration.stats.tests << " tests, frontier "
+                << "up to " << exploration.stats.maxFrontier << std::endl;
+    }
+  }
+};
+
 int main() {
   std::cout << "\n" << string(80, '=') << std::endl;
   std::cout << "End-to-End Test Suite: Spec -> ATC -> CTC" << std::endl;
@@ -665,6 +1066,53 @@ int main() {
     }
   }
 
+  try {
+    WorkStealingPoolTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    std::cout << "\n✗ Test failed with exception: " << e.what() << std::endl;
+    failed++;
+  }
+  try {
+    MultiModelTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    std::cout << "\n✗ Test failed with exception: " << e.what() << std::endl;
+    failed++;
+  }
+
+  try {
+    UnsatCoreTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    std::cout << "\n✗ Test failed with exception: " << e.what() << std::endl;
+    failed++;
+  }
+
+  try {
+    ForkingTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    std::cout << "\n✗ Test failed with exception: " << e.what() << std::endl;
+    failed++;
+  }
+
+  try {
+    SequenceEnumerationTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    std::cout << "\n✗ Test failed with exception: " << e.what() << std::endl;
+    failed++;
+  }
+
+  try {
+    ExplorationTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    std::cout << "\n✗ Test failed with exception: " << e.what() << std::endl;
+    failed++;
+  }
+
   std::cout << "\n" << string(80, '=') << std::endl;
   std::cout << "Test Results: " << passed << " passed, " << failed << " failed"
             << std::endl;
@@ -307,14 +307,15 @@ protected:
     assert(assumeCall->name == "not_in");
     cout << "  ✓ Precondition assume() verified" << endl;
 
-    // Check API call - LHS is now _RESPONSE_CODE_200 (from ResponseExpr)
+    // Check API call - the response has no ResponseExpr, so the LHS is the
+    // default result variable
     const Assign *apiCall =
         dynamic_cast<const Assign *>(atc.statements[4].get());
     assert(apiCall != nullptr);
     assert(apiCall->left->exprType == ExprType::VAR);
     const Var *resultVar = dynamic_cast<const Var *>(apiCall->left.get());
     assert(resultVar != nullptr);
-    assert(resultVar->name == "_RESPONSE_CODE_200");
+    assert(resultVar->name == "_result0");
     assert(apiCall->right->exprType == ExprType::FUNC_CALL_EXPR);
     const FuncCall *callFunc =
         dynamic_cast<const FuncCall *>(apiCall->right.get());
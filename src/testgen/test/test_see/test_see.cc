@@ -1,11 +1,17 @@
 #include "../../apps/app1/app1.hh"
 #include "../../language/ast.hh"
 #include "../../language/env.hh"
+#include "../../language/exprfactory.hh"
 #include "../../language/symvar.hh"
+#include "../../see/folder.hh"
+#include "../../see/searcher.hh"
 #include "../../see/see.hh"
 #include "../../see/z3solver.hh"
 #include "../../tester/test_utils.hh"
+#include "../../util/trace.hh"
+#include <algorithm>
 #include <cassert>
+#include <climits>
 #include <iostream>
 using namespace std;
 
@@ -101,7 +107,7 @@ protected:
     assert(sigma.getValue("y")->exprType == ExprType::SYMVAR);
     assert(sigma.getValue("z")->exprType == ExprType::FUNC_CALL_EXPR);
 
-    vector<Expr *> &pathConstraint = see.getPathConstraint();
+    const vector<Expr *> &pathConstraint = see.getPathConstraint();
     assert(pathConstraint.size() == 2);
 
     assert(!isSat);
@@ -135,7 +141,7 @@ protected:
     ValueEnvironment &sigma = see.getSigma();
     assert(sigma.hasValue("x"));
 
-    vector<Expr *> &pathConstraint = see.getPathConstraint();
+    const vector<Expr *> &pathConstraint = see.getPathConstraint();
     assert(pathConstraint.size() == 1);
 
     assert(isSat);
@@ -182,7 +188,7 @@ protected:
     assert(sigma.hasValue("x"));
     assert(sigma.hasValue("y"));
 
-    vector<Expr *> &pathConstraint = see.getPathConstraint();
+    const vector<Expr *> &pathConstraint = see.getPathConstraint();
     assert(pathConstraint.size() == 2);
 
     assert(isSat);
@@ -252,7 +258,7 @@ protected:
 
     assert(sigma.getValue("U")->exprType == ExprType::SET);
 
-    vector<Expr *> &pathConstraint = see.getPathConstraint();
+    const vector<Expr *> &pathConstraint = see.getPathConstraint();
     assert(pathConstraint.size() == 3);
 
     assert(isSat);
@@ -630,6 +636,676 @@ protected:
   }
 };
 
+/*
+Test: Resume from the interruption point
+Program:
+    x := input
+    assume(x > 0)
+    r := set_y(x)
+    y := get_y()
+Execution stops at set_y(x). After rewriting the input to x := 7, resume
+continues at set_y without re-running the earlier statements.
+Expected: x and r bound to 7, Eq(X, 7) appended to the path constraint
+*/
+class SEEResumeTest {
+public:
+  void execute() {
+    cout << "\n*********************Test case: Resume from the interruption "
+            "point *************"
+         << endl;
+
+    vector<unique_ptr<Stmt>> statements;
+    statements.push_back(TestUtils::makeInputAssign("x"));
+    statements.push_back(make_unique<Assume>(TestUtils::makeBinOp(
+        "gt", make_unique<Var>("x"), make_unique<Num>(0))));
+    vector<unique_ptr<Expr>> setArgs;
+    setArgs.push_back(make_unique<Var>("x"));
+    statements.push_back(make_unique<Assign>(
+        make_unique<Var>("r"),
+        make_unique<FuncCall>("set_y", std::move(setArgs))));
+    statements.push_back(make_unique<Assign>(
+        make_unique<Var>("y"),
+        make_unique<FuncCall>("get_y", vector<unique_ptr<Expr>>{})));
+    Program program(std::move(statements));
+
+    SymbolTable st(nullptr);
+    App1FunctionFactory functionFactory;
+    SEE see(&functionFactory);
+
+    see.execute(program, st);
+    assert(see.hasCheckpoint());
+    assert(see.getPathConstraint().size() == 1);
+    assert(see.getPendingInputs().size() == 1);
+    assert(!see.getSigma().hasValue("r"));
+
+    // What rewriteATC does with the model value 7
+    vector<unique_ptr<Stmt>> rewritten;
+    rewritten.push_back(
+        make_unique<Assign>(make_unique<Var>("x"), make_unique<Num>(7)));
+    for (size_t i = 1; i < program.statements.size(); i++) {
+      rewritten.push_back(program.statements[i]->clone());
+    }
+    Program concrete(std::move(rewritten));
+
+    see.resume(concrete, st);
+    assert(!see.hasCheckpoint());
+    assert(see.getPendingInputs().empty());
+    assert(see.getPathConstraint().size() == 2);
+    assert(dynamic_cast<Num *>(see.getSigma().getValue("x"))->value == 7);
+    assert(dynamic_cast<Num *>(see.getSigma().getValue("r"))->value == 7);
+    assert(dynamic_cast<Num *>(see.getSigma().getValue("y"))->value == 7);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+/*
+Test case: Hash-consed expressions
+x := input(); assume gt(x, 0); assume lt(add(x, 1), 10); assume gt(x, 0)
+Expected: equal terms built by SEE are the same node, so the repeated
+assumption and the SymVar of x are shared between the constraints
+*/
+class ExprFactoryTest {
+public:
+  void execute() {
+    cout << "\n*********************Test case: Hash-consed expressions "
+            "*************"
+         << endl;
+
+    ExprFactory factory;
+    assert(factory.num(3) == factory.num(3));
+    assert(factory.num(3) != factory.num(4));
+    Expr *x = factory.symVar(0);
+    Expr *gt = factory.funcCall("gt", {x, factory.num(0)});
+    assert(gt == factory.funcCall("gt", {factory.symVar(0), factory.num(0)}));
+
+    // Interning a tree built outside the factory finds the same node
+    unique_ptr<FuncCall> outside = TestUtils::makeBinOp(
+        "gt", make_unique<SymVar>(0), make_unique<Num>(0));
+    assert(factory.intern(*outside) == gt);
+    assert(factory.intern(*gt) == gt);
+    size_t size = factory.size();
+    factory.intern(*outside);
+    assert(factory.size() == size);
+
+    // Every spelling of a built-in is the same node
+    Expr *eq = factory.funcCall("eq", {x, factory.num(1)});
+    assert(factory.funcCall("Eq", {x, factory.num(1)}) == eq);
+    assert(factory.funcCall("=", {x, factory.num(1)}) == eq);
+    FuncCall *f1 = factory.funcCall("f1", {x, factory.num(1)});
+    assert(f1 != eq);
+    // and a call built from resolved names finds the same nodes
+    assert(factory.funcCall(Opcode::EQ, NO_API_ID, "Eq",
+                            {x, factory.num(1)}) == eq);
+    assert(factory.funcCall(f1->op, f1->apiId, "f1", {x, factory.num(1)}) ==
+           f1);
+    FuncCall *f1Other = factory.funcCall(f1->op, f1->apiId, "f1", {x, x});
+    assert(f1Other->op == Opcode::API && f1Other->apiId == f1->apiId);
+
+    // A clone owns its nodes and outlives the factory
+    unique_ptr<Expr> copy;
+    {
+      ExprFactory session;
+      copy = session
+                 .funcCall("add", {session.symVar(1),
+                                   session.set({session.num(2)})})
+                 ->clone();
+    }
+    assert(copy->toString() == "add(SymVar_1, {2})");
+
+    vector<unique_ptr<Stmt>> statements;
+    statements.push_back(TestUtils::makeInputAssign("x"));
+    statements.push_back(make_unique<Assume>(TestUtils::makeBinOp(
+        "gt", make_unique<Var>("x"), make_unique<Num>(0))));
+    statements.push_back(make_unique<Assume>(TestUtils::makeBinOp(
+        "lt",
+        TestUtils::makeBinOp("add", make_unique<Var>("x"),
+                             make_unique<Num>(1)),
+        make_unique<Num>(10))));
+    statements.push_back(make_unique<Assume>(TestUtils::makeBinOp(
+        "gt", make_unique<Var>("x"), make_unique<Num>(0))));
+    Program program(std::move(statements));
+
+    SymbolTable st(nullptr);
+    App1FunctionFactory functionFactory;
+    SEE see(&functionFactory);
+    see.execute(program, st);
+
+    const vector<Expr *> &pc = see.getPathConstraint();
+    assert(pc.size() == 3);
+    assert(pc[0] == pc[2]);
+    FuncCall *first = dynamic_cast<FuncCall *>(pc[0]);
+    FuncCall *second = dynamic_cast<FuncCall *>(pc[1]);
+    FuncCall *add = dynamic_cast<FuncCall *>(second->args[0].get());
+    assert(first->args[0] == add->args[0]);
+    assert(first->args[0].get() == see.getSigma().getValue("x"));
+    assert(see.getExprFactory().isCanonical(pc[1]));
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+/*
+Test case: Session arena
+x := input(); assume gt(x, 0)
+Expected: all nodes of a session are in the arena of its factory, the
+factory is freed as soon as the next session starts, and the next session
+numbers its SymVars from 0 again
+*/
+class SEESessionArenaTest {
+public:
+  void execute() {
+    cout << "\n*********************Test case: Session arena "
+            "*************"
+         << endl;
+
+    vector<unique_ptr<Stmt>> statements;
+    statements.push_back(TestUtils::makeInputAssign("x"));
+    statements.push_back(make_unique<Assume>(TestUtils::makeBinOp(
+        "gt", make_unique<Var>("x"), make_unique<Num>(0))));
+    Program program(std::move(statements));
+
+    SymbolTable st(nullptr);
+    App1FunctionFactory functionFactory;
+    SEE see(&functionFactory);
+
+    shared_ptr<ExprFactory> factory = make_shared<ExprFactory>();
+    weak_ptr<ExprFactory> first = factory;
+    see.beginSession(factory);
+    factory.reset();
+    see.execute(program, st);
+
+    const ExprArena &arena = see.getExprFactory().getArena();
+    assert(arena.getNumNodes() == see.getExprFactory().size());
+    assert(arena.getNumBlocks() == 1);
+    assert(see.getPathConstraint().size() == 1);
+
+    // The formula handed out survives the session
+    unsigned int x =
+        dynamic_cast<SymVar *>(see.getSigma().getValue("x"))->getNum();
+    unique_ptr<Expr> formula = see.computePathConstraint();
+    see.beginSession();
+    assert(first.expired());
+    assert(see.getPathConstraint().empty());
+    assert(!see.getSigma().hasValue("x"));
+    assert(formula->toString() == "gt(SymVar_" + to_string(x) + ", 0)");
+
+    // SymVars are numbered per session, from 0
+    assert(x == 0);
+    see.execute(program, st);
+    assert(dynamic_cast<SymVar *>(see.getSigma().getValue("x"))->getNum() == 0);
+    assert(see.getSymVarAllocator().size() == 1);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+/*
+Test case: Level-gated tracing
+x := input(); assume gt(x, 0)
+Expected: at INFO only the engine steps reach the sink, at OFF nothing does
+*/
+class SEETraceTest {
+public:
+  void execute() {
+    cout << "\n*********************Test case: Level-gated tracing "
+            "*************"
+         << endl;
+
+    vector<unique_ptr<Stmt>> statements;
+    statements.push_back(TestUtils::makeInputAssign("x"));
+    statements.push_back(make_unique<Assume>(TestUtils::makeBinOp(
+        "gt", make_unique<Var>("x"), make_unique<Num>(0))));
+    Program program(std::move(statements));
+
+    SymbolTable st(nullptr);
+    App1FunctionFactory functionFactory;
+    SEE see(&functionFactory);
+
+    TraceLevel previousLevel = Trace::getLevel();
+    unique_ptr<TraceSink> previousSink =
+        Trace::setSink(make_unique<RingBufferSink>(4));
+    RingBufferSink *ring = dynamic_cast<RingBufferSink *>(Trace::getSink());
+
+    Trace::setLevel(TraceLevel::INFO);
+    see.execute(program, st);
+    vector<string> lines = ring->getLines();
+    assert(ring->getNumWritten() == 1);
+    assert(lines.size() == 1);
+    assert(lines[0].find("[SEE] Path Constraint: gt(X") != string::npos);
+
+    Trace::setLevel(TraceLevel::DEBUG);
+    see.execute(program, st);
+    assert(ring->getNumWritten() > 5);
+    assert(ring->getLines().size() == 4);
+
+    size_t written = ring->getNumWritten();
+    Trace::setLevel(TraceLevel::OFF);
+    see.execute(program, st);
+    assert(ring->getNumWritten() == written);
+
+    Trace::setSink(std::move(previousSink));
+    Trace::setLevel(previousLevel);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+/*
+Test case: Interned opcodes
+x := Add(1, 2); r := f1(1, 2)
+Expected: every spelling of a built-in resolves to the same opcode, so Add is
+evaluated rather than called, and f1 is found by its interned ID
+*/
+class SEEOpcodeTest {
+public:
+  void execute() {
+    cout << "\n*********************Test case: Interned opcodes "
+            "*************"
+         << endl;
+
+    auto resolve = [](const string &name) {
+      return make_unique<FuncCall>(name, vector<shared_ptr<Expr>>());
+    };
+    assert(resolve("eq")->op == Opcode::EQ);
+    assert(resolve("Eq")->op == Opcode::EQ);
+    assert(resolve("==")->op == Opcode::EQ);
+    assert(resolve("And")->op == Opcode::AND);
+    assert(resolve("Any")->op == Opcode::ANY);
+    assert(resolve("input")->op == Opcode::INPUT);
+    assert(resolve("'")->op == Opcode::PRIME);
+    assert(resolve("Eq")->apiId == NO_API_ID);
+    assert(OpcodeTable::arity(Opcode::PUT) == 3);
+
+    unique_ptr<FuncCall> call = resolve("f1");
+    assert(call->op == Opcode::API);
+    assert(call->apiId == ApiRegistry::intern("f1"));
+    assert(resolve("f1")->apiId == call->apiId);
+    assert(resolve("f2")->apiId != call->apiId);
+    assert(ApiRegistry::name(call->apiId) == "f1");
+
+    vector<unique_ptr<Stmt>> statements;
+    statements.push_back(make_unique<Assign>(
+        make_unique<Var>("x"),
+        TestUtils::makeBinOp("Add", make_unique<Num>(1), make_unique<Num>(2))));
+    statements.push_back(make_unique<Assign>(
+        make_unique<Var>("r"),
+        TestUtils::makeBinOp("f1", make_unique<Num>(1), make_unique<Num>(2))));
+    Program program(std::move(statements));
+
+    SymbolTable st(nullptr);
+    App1FunctionFactory functionFactory;
+    SEE see(&functionFactory);
+    see.execute(program, st);
+
+    // The built-in is evaluated on its constant arguments, the API called
+    Num *x = dynamic_cast<Num *>(see.getSigma().getValue("x"));
+    assert(x != nullptr && x->value == 3);
+    Num *r = dynamic_cast<Num *>(see.getSigma().getValue("r"));
+    assert(r != nullptr && r->value == 3);
+
+    bool threw = false;
+    try {
+      functionFactory.getFunction(ApiRegistry::intern("no_such_api"), {});
+    } catch (const char *) {
+      threw = true;
+    }
+    assert(threw);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+/*
+Test case: Forking at a disjunctive assumption
+    x := input()
+    assume or(lt(x, 0), gt(x, 10))
+    y := add(x, 1)
+Expected: with forking on, the path goes on with lt(X0, 0) and one fork is
+left with Not(lt(X0, 0)) and gt(X0, 10), sharing everything the path did
+not write after the split. Exploring the fork runs it to the end. Once an
+API call has been made after the split, the fork cannot go on.
+*/
+class SEEForkTest {
+  static Program makeProgram(bool withCall) {
+    vector<unique_ptr<Stmt>> statements;
+    statements.push_back(TestUtils::makeInputAssign("x"));
+    statements.push_back(make_unique<Assume>(TestUtils::makeBinOp(
+        "or",
+        TestUtils::makeBinOp("lt", make_unique<Var>("x"), make_unique<Num>(0)),
+        TestUtils::makeBinOp("gt", make_unique<Var>("x"),
+                             make_unique<Num>(10)))));
+    statements.push_back(make_unique<Assign>(
+        make_unique<Var>("y"),
+        TestUtils::makeBinOp("add", make_unique<Var>("x"),
+                             make_unique<Num>(1))));
+    if (withCall) {
+      statements.push_back(make_unique<Assign>(
+          make_unique<Var>("r"),
+          make_unique<FuncCall>("get_y", vector<unique_ptr<Expr>>{})));
+    }
+    return Program(std::move(statements));
+  }
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Forking at a disjunctive "
+            "assumption *************"
+         << endl;
+
+    SymbolTable st(nullptr);
+    App1FunctionFactory functionFactory;
+    SEE see(&functionFactory);
+    Program program = makeProgram(false);
+
+    // Off: the disjunction is one conjunct
+    see.execute(program, st);
+    assert(see.getForks().empty());
+    assert(see.getPathConstraint().size() == 1);
+
+    see.beginSession();
+    see.setForking(true);
+    see.execute(program, st);
+    assert(see.getForks().size() == 1);
+    ExprFactory &factory = see.getExprFactory();
+    Expr *x = factory.symVar(0);
+    Expr *negative = factory.funcCall("lt", {x, factory.num(0)});
+    Expr *large = factory.funcCall("gt", {x, factory.num(10)});
+    assert(see.getPathConstraint() == vector<Expr *>({negative}));
+
+    const SymbolicState &fork = *see.getForks()[0];
+    assert(fork.pc == 2);
+    assert(fork.pathConstraint.get().conjuncts ==
+           vector<Expr *>({factory.funcCall("Not", {negative}), large}));
+    assert(fork.pathConstraint.get().origins == vector<size_t>({1, 1}));
+    // y was assigned on the path after the split, the inputs were not
+    assert(!fork.sigma.sharesBindings(see.getState().sigma));
+    assert(!fork.sigma.hasValue("y"));
+    assert(fork.pendingInputs.shares(see.getState().pendingInputs));
+    assert(see.isLive(fork));
+
+    see.explore(see.takeFork(0), program, st);
+    assert(see.getForks().empty());
+    assert(see.getPathConstraint().size() == 2);
+    assert(see.getSigma().getValue("y") ==
+           factory.funcCall("add", {x, factory.num(1)}));
+    assert(see.getPendingInputs() == vector<unsigned int>({0}));
+
+    // The application is not forked with the path
+    Program withCall = makeProgram(true);
+    see.beginSession();
+    see.execute(withCall, st);
+    assert(see.getForks().size() == 1);
+    assert(!see.isLive(*see.getForks()[0]));
+    bool refused = false;
+    try {
+      see.explore(see.takeFork(0), withCall, st);
+    } catch (const runtime_error &) {
+      refused = true;
+    }
+    assert(refused);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+/*
+Test case: Persistent value environment
+Expected: a copy is a snapshot that later updates of either side do not
+change; lookups fall through to the parent; keys whose hashes collide
+entirely, or agree on all but their last bits, are kept apart
+*/
+class PersistentEnvTest {
+  // Every key in one leaf
+  struct SameHash {
+    size_t operator()(const string &) const { return 42; }
+  };
+  // Hashes that differ only in their top bits, so that the trie is as
+  // deep as it gets
+  struct TopBitsHash {
+    size_t operator()(const string &key) const {
+      return (size_t)stoul(key) << (sizeof(size_t) * 8 - 6);
+    }
+  };
+
+  template <typename Hash> static void checkMap(size_t n) {
+    PersistentMap<int, Hash> map;
+    for (size_t i = 0; i < n; i++) {
+      map.set(to_string(i), (int)i);
+    }
+    PersistentMap<int, Hash> snapshot = map;
+    for (size_t i = 0; i < n; i += 2) {
+      map.set(to_string(i), -1);
+    }
+    map.set(to_string(n), (int)n);
+    assert(map.size() == n + 1 && snapshot.size() == n);
+    for (size_t i = 0; i < n; i++) {
+      assert(*snapshot.find(to_string(i)) == (int)i);
+      assert(*map.find(to_string(i)) == (i % 2 == 0 ? -1 : (int)i));
+    }
+    assert(!snapshot.contains(to_string(n)));
+    assert(map.entries().size() == n + 1);
+  }
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Persistent value environment "
+            "*************"
+         << endl;
+
+    ExprFactory factory;
+    ValueEnvironment sigma;
+    for (int i = 0; i < 1000; i++) {
+      sigma.setValue("v" + to_string(i), factory.num(i));
+    }
+    ValueEnvironment snapshot = sigma;
+    assert(snapshot.sharesBindings(sigma));
+    sigma.setValue("v7", factory.num(-7));
+    sigma.setValue("w", factory.num(1));
+    assert(!snapshot.sharesBindings(sigma));
+    assert(sigma.getValue("v7") == factory.num(-7));
+    assert(snapshot.getValue("v7") == factory.num(7));
+    assert(snapshot.getValue("v999") == factory.num(999));
+    assert(!snapshot.hasValue("w") && sigma.hasValue("w"));
+    assert(sigma.size() == 1001 && snapshot.size() == 1000);
+
+    vector<pair<string, Expr *>> bindings = snapshot.getBindings();
+    assert(bindings.size() == 1000);
+    assert(bindings.front().first == "v0" && bindings.back().first == "v999");
+
+    // Lookups fall through to the parent
+    ValueEnvironment local(&snapshot);
+    local.setValue("v7", factory.num(70));
+    assert(local.getValue("v7") == factory.num(70));
+    assert(local.getValue("v8") == factory.num(8));
+    assert(local.getValue("x") == nullptr && !local.hasValue("x"));
+    assert(local.size() == 1);
+
+    checkMap<SameHash>(20);
+    checkMap<TopBitsHash>(40);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+/*
+Test case: Search strategies
+Five pending states, added in order, with decisions
+    [], [(1, 1)], [(1, 0), (3, 1)], [(1, 0), (3, 2)], [(1, 1), (3, 1)]
+Expected: DFS runs the newest first and BFS the oldest. Once a test took
+disjunct 1 at statement 3, the coverage searcher runs the states that
+would take another disjunct there first. Random path runs them all.
+*/
+class SearcherTest {
+  static vector<vector<pair<size_t, unsigned int>>> paths() {
+    return {{}, {{1, 1}}, {{1, 0}, {3, 1}}, {{1, 0}, {3, 2}},
+            {{1, 1}, {3, 1}}};
+  }
+
+  static vector<size_t> run(Searcher &searcher) {
+    vector<vector<pair<size_t, unsigned int>>> all = paths();
+    for (const auto &decisions : all) {
+      auto state = make_unique<SymbolicState>();
+      state->decisions = decisions;
+      searcher.add(std::move(state));
+    }
+    assert(searcher.size() == all.size());
+    vector<size_t> order;
+    while (unique_ptr<SymbolicState> state = searcher.next()) {
+      order.push_back(find(all.begin(), all.end(), state->decisions) -
+                      all.begin());
+    }
+    assert(searcher.empty());
+    return order;
+  }
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Search strategies "
+            "*************"
+         << endl;
+
+    DFSSearcher dfs;
+    assert(run(dfs) == vector<size_t>({4, 3, 2, 1, 0}));
+    BFSSearcher bfs;
+    assert(run(bfs) == vector<size_t>({0, 1, 2, 3, 4}));
+
+    CoverageSearcher coverage;
+    SymbolicState tested;
+    tested.decisions = {{1, 0}, {3, 1}};
+    coverage.covered(tested);
+    assert(coverage.getCoveredChoices() == 2);
+    assert(run(coverage) == vector<size_t>({0, 1, 3, 2, 4}));
+
+    RandomPathSearcher random(7);
+    vector<size_t> order = run(random);
+    sort(order.begin(), order.end());
+    assert(order == vector<size_t>({0, 1, 2, 3, 4}));
+
+    assert(makeSearcher("coverage")->getName() == "coverage");
+    assert(makeSearcher("best-first") == nullptr);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+/*
+Test case: Constant folding
+    x := add(3, 4)
+    assume gt(x, 0)
+    y := input()
+    assume lt(y, mul(x, 2))
+    assume implies(gt(y, 0), le(x, 7))
+    assume lt(x, 5)
+    r := get_y()
+Expected: conjuncts that fold to true are dropped, lt(x, 5) folds to
+false, and execution stops there, before the API call
+*/
+class ConstantFolderTest {
+  static unique_ptr<Expr> binOp(const string &op, unique_ptr<Expr> left,
+                                unique_ptr<Expr> right) {
+    return TestUtils::makeBinOp(op, std::move(left), std::move(right));
+  }
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Constant folding "
+            "*************"
+         << endl;
+
+    ExprFactory factory;
+    auto fold = [&factory](const string &name, const vector<Expr *> &args) {
+      return ConstantFolder::call(factory, name, args);
+    };
+    Expr *x = factory.symVar(0);
+    Expr *one = factory.num(1), *two = factory.num(2), *three = factory.num(3);
+    Expr *yes = factory.boolean(true), *no = factory.boolean(false);
+
+    // Arithmetic, with the division of SMT-LIB and no overflow
+    assert(fold("add", {factory.num(3), factory.num(4)}) == factory.num(7));
+    assert(fold("div", {factory.num(-7), two}) == factory.num(-4));
+    assert(fold("div", {one, factory.num(0)}) ==
+           factory.funcCall("div", {one, factory.num(0)}));
+    assert(fold("add", {factory.num(INT_MAX), one}) ==
+           factory.funcCall("add", {factory.num(INT_MAX), one}));
+    assert(fold("Gt", {factory.num(9), factory.num(0)}) == yes);
+    assert(fold("add", {x, one}) == factory.funcCall("add", {x, one}));
+    // Equality within one sort only
+    assert(fold("eq", {factory.str("a"), factory.str("a")}) == yes);
+    assert(fold("eq", {one, factory.str("1")}) ==
+           factory.funcCall("eq", {one, factory.str("1")}));
+    // Logic, also with one constant side
+    Expr *positive = factory.funcCall("gt", {x, factory.num(0)});
+    assert(fold("and", {no, positive}) == no);
+    assert(fold("and", {positive, yes}) == positive);
+    assert(fold("or", {no, positive}) == positive);
+    assert(fold("implies", {positive, no}) ==
+           factory.funcCall("Not", {positive}));
+    // Sets
+    Expr *oneTwo = factory.set({one, two});
+    Expr *oneTwoThree = fold("union", {oneTwo, factory.set({two, three})});
+    assert(oneTwoThree == factory.set({one, two, three}));
+    assert(fold("in", {three, oneTwoThree}) == yes);
+    assert(fold("not_in", {three, oneTwo}) == yes);
+    assert(fold("eq", {oneTwo, factory.set({two, one, two})}) == yes);
+    assert(fold("intersection", {oneTwo, oneTwoThree}) == oneTwo);
+    assert(fold("subset", {oneTwoThree, oneTwo}) == no);
+    assert(fold("add_to_set", {oneTwo, three}) == oneTwoThree);
+    assert(fold("is_empty_set", {factory.set({x})}) == no);
+    assert(fold("in", {x, oneTwo}) == factory.funcCall("in", {x, oneTwo}));
+    // Maps, keyed by name
+    Expr *map = factory.map({{"a", x}, {"b", one}});
+    assert(fold("get", {map, factory.var("a")}) == x);
+    assert(fold("contains_key", {map, factory.str("c")}) == no);
+    assert(fold("put", {map, factory.var("b"), two}) ==
+           factory.map({{"a", x}, {"b", two}}));
+    // Sequences
+    assert(fold("concat", {factory.str("ab"), factory.str("c")}) ==
+           factory.str("abc"));
+    assert(fold("prefix", {factory.str("ab"), factory.str("abc")}) == yes);
+    assert(fold("at", {factory.str("ab"), factory.num(5)}) == factory.str(""));
+    // API calls are never evaluated
+    assert(fold("f1", {one, two}) == factory.funcCall("f1", {one, two}));
+
+    vector<unique_ptr<Stmt>> statements;
+    statements.push_back(make_unique<Assign>(
+        make_unique<Var>("x"),
+        binOp("add", make_unique<Num>(3), make_unique<Num>(4))));
+    statements.push_back(make_unique<Assume>(
+        binOp("gt", make_unique<Var>("x"), make_unique<Num>(0))));
+    statements.push_back(TestUtils::makeInputAssign("y"));
+    statements.push_back(make_unique<Assume>(
+        binOp("lt", make_unique<Var>("y"),
+              binOp("mul", make_unique<Var>("x"), make_unique<Num>(2)))));
+    statements.push_back(make_unique<Assume>(binOp(
+        "implies", binOp("gt", make_unique<Var>("y"), make_unique<Num>(0)),
+        binOp("le", make_unique<Var>("x"), make_unique<Num>(7)))));
+    statements.push_back(make_unique<Assume>(
+        binOp("lt", make_unique<Var>("x"), make_unique<Num>(5))));
+    statements.push_back(make_unique<Assign>(
+        make_unique<Var>("r"),
+        make_unique<FuncCall>("get_y", vector<unique_ptr<Expr>>{})));
+    Program program(std::move(statements));
+
+    SymbolTable st(nullptr);
+    App1FunctionFactory functionFactory;
+    SEE see(&functionFactory);
+    see.execute(program, st);
+    ExprFactory &seeFactory = see.getExprFactory();
+    assert(see.getSigma().getValue("x") == seeFactory.num(7));
+    Expr *bound =
+        seeFactory.funcCall("lt", {seeFactory.symVar(0), seeFactory.num(14)});
+    assert(see.getPathConstraint() ==
+           vector<Expr *>({bound, seeFactory.boolean(false)}));
+    assert(see.getConstraintOrigins() == vector<size_t>({3, 5}));
+    assert(see.isInfeasible() && see.getFalsified() == 1);
+    assert(!see.getSigma().hasValue("r"));
+    assert(!see.hasCheckpoint());
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
 int main() {
   vector<SEETest *> testcases = {new SEETest1(), new SEETest2(), new SEETest3(),
                                  new SEETest4(), new SEETest5(), new SEETest6(),
@@ -659,6 +1335,78 @@ int main() {
     }
   }
 
+  try {
+    SEEResumeTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+
+  try {
+    ExprFactoryTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+
+  try {
+    SEESessionArenaTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+
+  try {
+    SEETraceTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+
+  try {
+    SEEOpcodeTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+
+  try {
+    PersistentEnvTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+
+  try {
+    SEEForkTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+
+  try {
+    SearcherTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+
+  try {
+    ConstantFolderTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+
   cout << "\n========================================" << endl;
   cout << "SEE Test Results: " << passed << " passed, " << failed << " failed"
        << endl;
@@ -1,8 +1,17 @@
 #include <cassert>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <set>
+#include <stdexcept>
 
 #include "../..//language/ast.hh"
 #include "../../language/env.hh"
+#include "../../see/fastpath.hh"
+#include "../../see/independence.hh"
+#include "../../see/portfolio.hh"
+#include "../../see/querylog.hh"
+#include "../../see/z3operators.hh"
 #include "../../see/z3solver.hh"
 #include "../../tester/test_utils.hh"
 
@@ -11,6 +20,7 @@ using namespace std;
 class Z3Test {
 protected:
   string testName;
+  SymVarAllocator symVars;
   virtual unique_ptr<Expr> makeConstraint() = 0;
   virtual void verify(const Result &result) = 0;
 
@@ -64,8 +74,8 @@ public:
 protected:
   unique_ptr<Expr> makeConstraint() override {
     // Create symbolic variables X0 and X1
-    unique_ptr<SymVar> x0 = SymVar::getNewSymVar();
-    unique_ptr<SymVar> x1 = SymVar::getNewSymVar();
+    unique_ptr<SymVar> x0 = symVars.getNewSymVar();
+    unique_ptr<SymVar> x1 = symVars.getNewSymVar();
 
     // Create constraint: X0 + X1 = 10
     unique_ptr<Expr> addExpr =
@@ -113,7 +123,7 @@ public:
 protected:
   unique_ptr<Expr> makeConstraint() override {
     // Create symbolic variable X0
-    unique_ptr<SymVar> x0 = SymVar::getNewSymVar();
+    unique_ptr<SymVar> x0 = symVars.getNewSymVar();
 
     // Create constraint: X0 = 5
     unique_ptr<Expr> eq5 =
@@ -148,9 +158,9 @@ public:
 protected:
   unique_ptr<Expr> makeConstraint() override {
     // Create symbolic variables X0, X1, X2
-    unique_ptr<SymVar> x0 = SymVar::getNewSymVar();
-    unique_ptr<SymVar> x1 = SymVar::getNewSymVar();
-    unique_ptr<SymVar> x2 = SymVar::getNewSymVar();
+    unique_ptr<SymVar> x0 = symVars.getNewSymVar();
+    unique_ptr<SymVar> x1 = symVars.getNewSymVar();
+    unique_ptr<SymVar> x2 = symVars.getNewSymVar();
 
     // Create constraint: X0 + X1 = 15
     unique_ptr<Expr> add1 =
@@ -206,8 +216,8 @@ public:
 protected:
   unique_ptr<Expr> makeConstraint() override {
     // Create symbolic variables X0 and X1
-    unique_ptr<SymVar> x0 = SymVar::getNewSymVar();
-    unique_ptr<SymVar> x1 = SymVar::getNewSymVar();
+    unique_ptr<SymVar> x0 = symVars.getNewSymVar();
+    unique_ptr<SymVar> x1 = symVars.getNewSymVar();
 
     // Create constraint: X0 * X1 = 12
     unique_ptr<Expr> mulExpr =
@@ -262,7 +272,7 @@ public:
 protected:
   unique_ptr<Expr> makeConstraint() override {
     // Create symbolic variable X0
-    unique_ptr<SymVar> x0 = SymVar::getNewSymVar();
+    unique_ptr<SymVar> x0 = symVars.getNewSymVar();
 
     // Create constraint: X0 > 10
     unique_ptr<Expr> gt =
@@ -297,8 +307,8 @@ public:
 protected:
   unique_ptr<Expr> makeConstraint() override {
     // Create symbolic variables X0 and X1
-    unique_ptr<SymVar> x0 = SymVar::getNewSymVar();
-    unique_ptr<SymVar> x1 = SymVar::getNewSymVar();
+    unique_ptr<SymVar> x0 = symVars.getNewSymVar();
+    unique_ptr<SymVar> x1 = symVars.getNewSymVar();
 
     // Create constraint: X0 - X1 = 5
     unique_ptr<Expr> subExpr =
@@ -353,7 +363,7 @@ protected:
     auto setExpr = make_unique<Set>(std::move(elements));
 
     // Create symbolic variable x
-    unique_ptr<SymVar> x = SymVar::getNewSymVar();
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
 
     // Create constraint: not_in(x, S)
     vector<unique_ptr<Expr>> args;
@@ -408,7 +418,7 @@ protected:
     auto setExpr = make_unique<Set>(std::move(elements));
 
     // Create symbolic variable x
-    unique_ptr<SymVar> x = SymVar::getNewSymVar();
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
 
     // Create constraint: in(x, S)
     vector<unique_ptr<Expr>> args;
@@ -464,7 +474,7 @@ protected:
     auto unionExpr = make_unique<FuncCall>("union", std::move(unionArgs));
 
     // Create symbolic variable x
-    unique_ptr<SymVar> x = SymVar::getNewSymVar();
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
 
     // Create constraint: in(x, union(S1, S2))
     vector<unique_ptr<Expr>> inArgs;
@@ -511,7 +521,7 @@ protected:
     auto emptySet = make_unique<Set>(std::move(emptyElements));
 
     // Create symbolic variable x
-    unique_ptr<SymVar> x = SymVar::getNewSymVar();
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
 
     // not_in(x, {}) - should always be true
     vector<unique_ptr<Expr>> notInArgs;
@@ -583,7 +593,7 @@ protected:
     auto mapExpr = make_unique<Map>(std::move(pairs));
 
     // Create symbolic variable for value
-    unique_ptr<SymVar> v = SymVar::getNewSymVar();
+    unique_ptr<SymVar> v = symVars.getNewSymVar();
 
     // Create put(M, 5, v) using Num for key
     vector<unique_ptr<Expr>> putArgs;
@@ -641,7 +651,7 @@ protected:
         make_unique<FuncCall>("intersection", std::move(intersectArgs));
 
     // Create symbolic variable x
-    unique_ptr<SymVar> x = SymVar::getNewSymVar();
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
 
     // Create constraint: in(x, intersection(S1, S2))
     vector<unique_ptr<Expr>> inArgs;
@@ -698,7 +708,7 @@ protected:
     auto diffExpr = make_unique<FuncCall>("difference", std::move(diffArgs));
 
     // Create symbolic variable x
-    unique_ptr<SymVar> x = SymVar::getNewSymVar();
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
 
     // Create constraint: in(x, difference(S1, S2))
     vector<unique_ptr<Expr>> inArgs;
@@ -723,6 +733,787 @@ protected:
   }
 };
 
+/*
+Test: Incremental session over a growing path constraint
+Queries: [X > 3], [X > 3, X < 5], [X > 3, X > 10]
+Expected: every query SAT; the second one reuses the scope of the first and
+the third pops X < 5 again before asserting X > 10
+*/
+class Z3SessionTest {
+private:
+  SymVarAllocator symVars;
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Incremental session over a "
+            "growing path constraint *************"
+         << endl;
+
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
+    string name = "X" + to_string(x->getNum());
+    unique_ptr<Expr> gt3 =
+        TestUtils::makeBinOp("gt", x->clone(), make_unique<Num>(3));
+    unique_ptr<Expr> lt5 =
+        TestUtils::makeBinOp("lt", x->clone(), make_unique<Num>(5));
+    unique_ptr<Expr> gt10 =
+        TestUtils::makeBinOp("gt", x->clone(), make_unique<Num>(10));
+
+    Z3Solver solver;
+    solver.beginSession();
+
+    Result r1 = solver.solveIncremental({gt3.get()});
+    assert(r1.isSat);
+    assert(solver.getSession()->getNumScopes() == 1);
+
+    Result r2 = solver.solveIncremental({gt3.get(), lt5.get()});
+    assert(r2.isSat);
+    assert(solver.getSession()->getNumScopes() == 2);
+    assert(dynamic_cast<const IntResultValue *>(r2.model.at(name).get())
+               ->value == 4);
+
+    Result r3 = solver.solveIncremental({gt3.get(), gt10.get()});
+    assert(r3.isSat);
+    assert(solver.getSession()->getNumScopes() == 2);
+    assert(dynamic_cast<const IntResultValue *>(r3.model.at(name).get())
+               ->value > 10);
+
+    // Going back to a query seen before reuses its cached translation
+    Result r4 = solver.solveIncremental({gt3.get(), lt5.get()});
+    assert(r4.isSat);
+    assert(solver.getSession()->getCacheHits() == 1);
+
+    // A new conjunct only translates its own new nodes
+    shared_ptr<ExprFactory> factory = make_shared<ExprFactory>();
+    solver.setExprFactory(factory);
+    solver.beginSession();
+    Expr *sum = factory->funcCall(
+        "add", {factory->symVar(x->getNum()), factory->num(1)});
+    Expr *low = factory->funcCall("gt", {sum, factory->num(3)});
+    Expr *high = factory->funcCall("lt", {sum, factory->num(5)});
+    assert(solver.solveIncremental({low}).isSat);
+    assert(solver.getSession()->getSubtermHits() == 0);
+    Result r5 = solver.solveIncremental({low, high});
+    assert(r5.isSat);
+    assert(solver.getSession()->getSubtermHits() == 1);
+    assert(dynamic_cast<const IntResultValue *>(r5.model.at(name).get())
+               ->value == 3);
+
+    solver.endSession();
+    assert(!solver.inSession());
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+class Z3IndependenceTest {
+private:
+  SymVarAllocator symVars;
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Independence slicing "
+            "*************"
+         << endl;
+
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
+    unique_ptr<SymVar> y = symVars.getNewSymVar();
+    string xName = "X" + to_string(x->getNum());
+    string yName = "X" + to_string(y->getNum());
+    unique_ptr<Expr> gt3 =
+        TestUtils::makeBinOp("gt", x->clone(), make_unique<Num>(3));
+    unique_ptr<Expr> neg =
+        TestUtils::makeBinOp("lt", y->clone(), make_unique<Num>(0));
+    unique_ptr<Expr> lt5 =
+        TestUtils::makeBinOp("lt", x->clone(), make_unique<Num>(5));
+    unique_ptr<Expr> link = TestUtils::makeBinOp("eq", x->clone(), y->clone());
+
+    vector<ConstraintGroup> groups =
+        partitionConstraints({gt3.get(), neg.get(), lt5.get()});
+    assert(groups.size() == 2);
+    assert(groups[0].conjuncts.size() == 2);
+    assert(groups[0].conjuncts[1] == lt5.get());
+    assert(groups[0].symVars == set<unsigned int>{x->getNum()});
+    assert(groups[1].symVars == set<unsigned int>{y->getNum()});
+    assert(groups[0].vars.empty() && groups[1].vars.empty());
+    assert(partitionConstraints({gt3.get(), neg.get(), link.get()}).size() ==
+           1);
+
+    Z3Solver solver;
+    solver.beginSession();
+    Result r1 = solver.solveSliced({gt3.get(), neg.get()},
+                                   {x->getNum(), y->getNum()});
+    assert(r1.isSat);
+    assert(solver.getSession()->getGroupsSolved() == 2);
+
+    // Only the x group grew, the y group answers from its cached model
+    Result r2 =
+        solver.solveSliced({gt3.get(), neg.get(), lt5.get()}, {x->getNum()});
+    assert(r2.isSat);
+    assert(solver.getSession()->getGroupsSolved() == 3);
+    assert(solver.getSession()->getGroupsReused() == 1);
+    assert(dynamic_cast<const IntResultValue *>(r2.model.at(xName).get())
+               ->value == 4);
+
+    // Both groups were solved before
+    Result r3 =
+        solver.solveSliced({gt3.get(), neg.get(), lt5.get()}, {y->getNum()});
+    assert(r3.isSat);
+    assert(solver.getSession()->getGroupsSolved() == 3);
+    assert(solver.getSession()->getGroupsReused() == 3);
+    assert(dynamic_cast<const IntResultValue *>(r3.model.at(yName).get())
+               ->value < 0);
+
+    Result r4 = solver.solveSliced({gt3.get(), neg.get(), lt5.get(),
+                                    link.get()},
+                                   {x->getNum()});
+    assert(!r4.isSat);
+    solver.endSession();
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+class CexCacheTest {
+private:
+  SymVarAllocator symVars;
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Counterexample cache "
+            "*************"
+         << endl;
+
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
+    unique_ptr<SymVar> y = symVars.getNewSymVar();
+    string yName = "X" + to_string(y->getNum());
+    auto between = [](SymVar &v) {
+      return TestUtils::makeBinOp(
+          "And", TestUtils::makeBinOp("gt", v.clone(), make_unique<Num>(3)),
+          TestUtils::makeBinOp("lt", v.clone(), make_unique<Num>(5)));
+    };
+
+    // SymVar numbers, aliases and conjunct order do not matter
+    unique_ptr<Expr> a = TestUtils::makeBinOp("Gt", x->clone(),
+                                              make_unique<Num>(0));
+    unique_ptr<Expr> b = TestUtils::makeBinOp(">", y->clone(),
+                                              make_unique<Num>(0));
+    assert(canonicalizeQuery({a.get()}).conjuncts ==
+           canonicalizeQuery({b.get()}).conjuncts);
+
+    Z3Solver solver;
+    CexCache &cache = solver.getCexCache();
+    assert(solver.solve(between(*x)).isSat);
+    assert(cache.getMisses() == 1);
+
+    Result exact = solver.solve(between(*y));
+    assert(exact.isSat && cache.getExactHits() == 1);
+    assert(dynamic_cast<const IntResultValue *>(exact.model.at(yName).get())
+               ->value == 4);
+
+    // A subset of a SAT query is satisfied by its model
+    Result subset = solver.solve(
+        TestUtils::makeBinOp("lt", y->clone(), make_unique<Num>(5)));
+    assert(subset.isSat && cache.getSupersetHits() == 1);
+    assert(dynamic_cast<const IntResultValue *>(subset.model.at(yName).get())
+               ->value == 4);
+
+    // A superset of an UNSAT query is UNSAT
+    assert(!solver
+                .solve(TestUtils::makeBinOp(
+                    "And", between(*x),
+                    TestUtils::makeBinOp("gt", x->clone(),
+                                         make_unique<Num>(10))))
+                .isSat);
+    assert(cache.getMisses() == 2);
+    assert(!solver
+                .solve(TestUtils::makeBinOp(
+                    "And",
+                    TestUtils::makeBinOp(
+                        "And", between(*y),
+                        TestUtils::makeBinOp("gt", y->clone(),
+                                             make_unique<Num>(10))),
+                    TestUtils::makeBinOp("neq", y->clone(),
+                                         make_unique<Num>(7))))
+                .isSat);
+    assert(cache.getSubsetHits() == 1);
+    assert(cache.getMisses() == 2);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+class Z3OperatorRegistryTest {
+private:
+  SymVarAllocator symVars;
+
+  static unique_ptr<Expr> call(const string &name, unique_ptr<Expr> arg) {
+    vector<unique_ptr<Expr>> args;
+    args.push_back(std::move(arg));
+    return make_unique<FuncCall>(name, std::move(args));
+  }
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Z3 operator registry "
+            "*************"
+         << endl;
+
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
+    string name = "X" + to_string(x->getNum());
+    Z3Solver solver;
+
+    // Built-ins are found under every spelling
+    for (const char *eq : {"eq", "Eq", "=", "=="}) {
+      assert(solver
+                 .solve(TestUtils::makeBinOp(eq, x->clone(),
+                                             make_unique<Num>(2)))
+                 .isSat);
+    }
+
+    // Functions without a translation are rejected
+    bool rejected = false;
+    try {
+      solver.solve(TestUtils::makeBinOp(
+          "eq", call("twice", x->clone()), make_unique<Num>(10)));
+    } catch (const runtime_error &e) {
+      rejected = string(e.what()).find("twice") != string::npos;
+    }
+    assert(rejected);
+
+    // An app registers a theory function by name and arity
+    Z3OperatorRegistry::getInstance().registerFunction(
+        "twice", 1, [](z3::context &ctx, const vector<z3::expr> &args) {
+          return args[0] * ctx.int_val(2);
+        });
+    Result result = solver.solve(TestUtils::makeBinOp(
+        "eq", call("twice", x->clone()), make_unique<Num>(10)));
+    assert(result.isSat);
+    assert(dynamic_cast<const IntResultValue *>(result.model.at(name).get())
+               ->value == 5);
+
+    bool builtin = false;
+    try {
+      Z3OperatorRegistry::getInstance().registerFunction(
+          "Add", 2, [](z3::context &ctx, const vector<z3::expr> &) {
+            return ctx.int_val(0);
+          });
+    } catch (const invalid_argument &) {
+      builtin = true;
+    }
+    assert(builtin);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+class Z3BudgetTest {
+private:
+  SymVarAllocator symVars;
+
+public:
+  // x^3 + y^3 = z^3 with x, y, z > 1: no solution, and none Z3 can find
+  // quickly
+  static unique_ptr<Expr> makeHardQuery(SymVar &x, SymVar &y, SymVar &z) {
+    auto cube = [](SymVar &v) {
+      return TestUtils::makeBinOp(
+          "mul", TestUtils::makeBinOp("mul", v.clone(), v.clone()),
+          v.clone());
+    };
+    unique_ptr<Expr> fermat = TestUtils::makeBinOp(
+        "eq", TestUtils::makeBinOp("add", cube(x), cube(y)), cube(z));
+    for (SymVar *v : {&x, &y, &z}) {
+      fermat = TestUtils::makeBinOp(
+          "and", std::move(fermat),
+          TestUtils::makeBinOp("gt", v->clone(), make_unique<Num>(1)));
+    }
+    return fermat;
+  }
+
+  void execute() {
+    cout << "\n*********************Test case: Solver budgets "
+            "*************"
+         << endl;
+
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
+    unique_ptr<SymVar> y = symVars.getNewSymVar();
+    unique_ptr<SymVar> z = symVars.getNewSymVar();
+
+    // A query that runs out of time is TIMEOUT, not UNSAT, and not cached
+    Z3Solver solver;
+    SolverBudget budget;
+    budget.queryTimeoutMs = 10;
+    solver.setBudget(budget);
+    Result timedOut = solver.solve(makeHardQuery(*x, *y, *z));
+    assert(timedOut.status == SolverStatus::TIMEOUT);
+    assert(!timedOut.isSat && !timedOut.isDecided());
+    assert(solver.getCexCache().size() == 0);
+
+    // Once the session budget is used up, queries time out without Z3
+    budget = SolverBudget();
+    budget.sessionTimeoutMs = 20;
+    solver.setBudget(budget);
+    shared_ptr<ExprFactory> factory = make_shared<ExprFactory>();
+    solver.setExprFactory(factory);
+    solver.beginSession();
+    unique_ptr<Expr> hard = makeHardQuery(*x, *y, *z);
+    unique_ptr<Expr> easy =
+        TestUtils::makeBinOp("gt", x->clone(), make_unique<Num>(3));
+    assert(solver.solveIncremental({hard.get()}).status ==
+           SolverStatus::TIMEOUT);
+    assert(solver.getSession()->getTimeUsedMs() >= 20);
+    assert(solver.solveIncremental({easy.get()}).status ==
+           SolverStatus::TIMEOUT);
+    solver.endSession();
+
+    // A retry runs on a solver of its own
+    solver.setBudget(SolverBudget());
+    solver.beginSession();
+    Result retried = solver.retry({easy.get()}, "default");
+    assert(retried.status == SolverStatus::SAT);
+    assert(dynamic_cast<const IntResultValue *>(
+               retried.model.at("X" + to_string(x->getNum())).get())
+               ->value > 3);
+    solver.endSession();
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+class Z3ContextPoolTest {
+private:
+  SymVarAllocator symVars;
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Z3 context pool "
+            "*************"
+         << endl;
+
+    // Contexts are reused, and their solvers come back empty
+    Z3ContextPool pool;
+    z3::context *first;
+    {
+      Z3ContextPool::Lease lease = pool.acquire();
+      first = &lease->getContext();
+      lease->getSolver().add(first->bool_val(false));
+      lease->noteQuery(lease->getSolver().check());
+    }
+    {
+      Z3ContextPool::Lease a = pool.acquire();
+      Z3ContextPool::Lease b = pool.acquire();
+      assert(&a->getContext() == first);
+      assert(&b->getContext() != first);
+      assert(a->getSolver().assertions().size() == 0);
+      assert(a->getSolver().check() == z3::sat);
+      assert(pool.getNumIdle() == 0);
+    }
+    assert(pool.size() == 2 && pool.getNumIdle() == 2);
+    vector<Z3ContextStats> stats = pool.getStats();
+    assert(stats[0].leases == 2 && stats[0].queries == 1);
+    assert(stats[0].unsat == 1 && stats[0].sat == 0);
+    assert(stats[1].leases == 1 && stats[1].queries == 0);
+
+    // Queries and sessions of a solver borrow from the shared pool
+    Z3ContextPool &shared = Z3ContextPool::getInstance();
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
+    Z3Solver solver;
+    assert(solver.solve(TestUtils::makeBinOp("gt", x->clone(),
+                                             make_unique<Num>(3)))
+               .isSat);
+    size_t contexts = shared.size();
+    unsigned int queries = 0;
+    for (const Z3ContextStats &s : shared.getStats()) {
+      queries += s.queries;
+    }
+    assert(solver.solve(TestUtils::makeBinOp("lt", x->clone(),
+                                             make_unique<Num>(-3)))
+               .isSat);
+    solver.beginSession();
+    assert(shared.getNumIdle() == contexts - 1);
+    unique_ptr<Expr> eq =
+        TestUtils::makeBinOp("eq", x->clone(), make_unique<Num>(7));
+    assert(solver.solveIncremental({eq.get()}).isSat);
+    solver.endSession();
+    assert(shared.size() == contexts && shared.getNumIdle() == contexts);
+    unsigned int after = 0;
+    for (const Z3ContextStats &s : shared.getStats()) {
+      after += s.queries;
+    }
+    assert(after == queries + 2);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+class PortfolioSolverTest {
+private:
+  SymVarAllocator symVars;
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Portfolio solver "
+            "*************"
+         << endl;
+
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
+    unique_ptr<SymVar> y = symVars.getNewSymVar();
+    unique_ptr<SymVar> z = symVars.getNewSymVar();
+    string xName = "X" + to_string(x->getNum());
+
+    // The first configuration to decide answers, with its model
+    PortfolioSolver portfolio;
+    Result sat = portfolio.solve(
+        TestUtils::makeBinOp("gt", x->clone(), make_unique<Num>(3)));
+    assert(sat.status == SolverStatus::SAT);
+    assert(dynamic_cast<const IntResultValue *>(sat.model.at(xName).get())
+               ->value > 3);
+    string winner = portfolio.getLastWinner();
+    assert(!winner.empty());
+    assert(portfolio.getWins().at(winner) == 1);
+    assert(portfolio.getPreferredConfig() == winner);
+
+    Result unsat = portfolio.solve(TestUtils::makeBinOp(
+        "and", TestUtils::makeBinOp("gt", x->clone(), make_unique<Num>(3)),
+        TestUtils::makeBinOp("lt", x->clone(), make_unique<Num>(2))));
+    assert(unsat.status == SolverStatus::UNSAT && unsat.model.empty());
+    unsigned int total = 0;
+    for (const auto &entry : portfolio.getWins()) {
+      total += entry.second;
+    }
+    assert(total == 2);
+
+    // Out of time, every configuration is interrupted and nobody wins
+    SolverBudget budget;
+    budget.queryTimeoutMs = 50;
+    portfolio.setBudget(budget);
+    auto start = chrono::steady_clock::now();
+    Result timedOut = portfolio.solve(Z3BudgetTest::makeHardQuery(*x, *y, *z));
+    auto elapsed = chrono::steady_clock::now() - start;
+    assert(timedOut.status == SolverStatus::TIMEOUT);
+    assert(portfolio.getLastWinner().empty());
+    assert(elapsed < chrono::seconds(5));
+
+    // Wins are counted per configuration
+    PortfolioSolver single(nullptr, {{"lia", "qflia", 0}});
+    for (int i = 0; i < 3; i++) {
+      assert(single.solve(TestUtils::makeBinOp("eq", x->clone(),
+                                               make_unique<Num>(i)))
+                 .isSat);
+    }
+    assert(single.getWins().at("lia") == 3);
+    assert(single.getPreferredConfig() == "lia");
+
+    // Every context went back to the pool
+    Z3ContextPool &pool = Z3ContextPool::getInstance();
+    assert(pool.getNumIdle() == pool.size());
+
+    bool thrown = false;
+    try {
+      PortfolioSolver empty(nullptr, {});
+    } catch (const invalid_argument &) {
+      thrown = true;
+    }
+    assert(thrown);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+class LinearFastPathTest {
+private:
+  SymVarAllocator symVars;
+
+  static unique_ptr<Expr> num(int n) { return make_unique<Num>(n); }
+
+  static int valueOf(const Result &result, const SymVar &var) {
+    return dynamic_cast<const IntResultValue *>(
+               result.model.at("X" + to_string(var.getNum())).get())
+        ->value;
+  }
+
+  // The fast path agrees with Z3 wherever it answers
+  static unique_ptr<Result> solveBoth(const vector<Expr *> &conjuncts) {
+    unique_ptr<Result> fast = LinearFastPath::solve(conjuncts);
+    assert(fast != nullptr);
+    Z3Session session(nullptr);
+    assert(session.solve(conjuncts).status == fast->status);
+    return fast;
+  }
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Linear fast path "
+            "*************"
+         << endl;
+
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
+    unique_ptr<SymVar> y = symVars.getNewSymVar();
+    unique_ptr<SymVar> r = symVars.getNewSymVar();
+
+    // Bounds: the value nearest to 0 in range, as Z3 picks
+    unique_ptr<Expr> gt0 = TestUtils::makeBinOp("gt", x->clone(), num(0));
+    unique_ptr<Expr> lt10 = TestUtils::makeBinOp("lt", x->clone(), num(10));
+    unique_ptr<Result> result = solveBoth({gt0.get(), lt10.get()});
+    assert(result->status == SolverStatus::SAT && valueOf(*result, *x) == 1);
+    result = solveBoth({lt10.get()});
+    assert(valueOf(*result, *x) == 0);
+    unique_ptr<Expr> le = TestUtils::makeBinOp("le", y->clone(), num(-2));
+    vector<unique_ptr<Expr>> anyArgs;
+    anyArgs.push_back(r->clone());
+    unique_ptr<Expr> any = make_unique<FuncCall>("Any", std::move(anyArgs));
+    result = solveBoth({le.get(), any.get()});
+    assert(valueOf(*result, *y) == -2 && valueOf(*result, *r) == 0);
+
+    // Equalities are substituted: r = x + y, r >= 7, x > 0, y > 0
+    unique_ptr<Expr> sum = TestUtils::makeBinOp(
+        "Eq", r->clone(), TestUtils::makeBinOp("add", x->clone(), y->clone()));
+    unique_ptr<Expr> ge7 = TestUtils::makeBinOp("ge", r->clone(), num(7));
+    unique_ptr<Expr> ygt0 = TestUtils::makeBinOp("gt", y->clone(), num(0));
+    // r >= 7 becomes x + y >= 7, which is not a bound on one variable
+    assert(LinearFastPath::solve({sum.get(), gt0.get(), ygt0.get(),
+                                  ge7.get()}) == nullptr);
+    unique_ptr<Expr> y3 = TestUtils::makeBinOp("Eq", y->clone(), num(3));
+    result = solveBoth({sum.get(), gt0.get(), y3.get(), ge7.get()});
+    assert(result->status == SolverStatus::SAT);
+    assert(valueOf(*result, *x) == 4 && valueOf(*result, *y) == 3 &&
+           valueOf(*result, *r) == 7);
+
+    // Scaled variables: y = 2x, y >= 7 gives x >= 4
+    unique_ptr<Expr> twice = TestUtils::makeBinOp(
+        "Eq", y->clone(), TestUtils::makeBinOp("mul", num(2), x->clone()));
+    unique_ptr<Expr> yge7 = TestUtils::makeBinOp("ge", y->clone(), num(7));
+    result = solveBoth({twice.get(), yge7.get()});
+    assert(valueOf(*result, *x) == 4 && valueOf(*result, *y) == 8);
+
+    // Contradictions
+    unique_ptr<Expr> gt5 = TestUtils::makeBinOp("gt", x->clone(), num(5));
+    unique_ptr<Expr> lt3 = TestUtils::makeBinOp("lt", x->clone(), num(3));
+    assert(solveBoth({gt5.get(), lt3.get()})->status == SolverStatus::UNSAT);
+    unique_ptr<Expr> eq1 = TestUtils::makeBinOp("Eq", x->clone(), num(1));
+    unique_ptr<Expr> eq2 = TestUtils::makeBinOp("Eq", x->clone(), num(2));
+    assert(solveBoth({eq1.get(), eq2.get()})->status == SolverStatus::UNSAT);
+
+    // Outside the fragment
+    unique_ptr<Expr> product = TestUtils::makeBinOp(
+        "Eq", r->clone(), TestUtils::makeBinOp("mul", x->clone(), y->clone()));
+    unique_ptr<Expr> odd = TestUtils::makeBinOp(
+        "Eq", TestUtils::makeBinOp("mul", num(2), x->clone()), num(5));
+    unique_ptr<Expr> either = TestUtils::makeBinOp("or", gt5->clone(),
+                                                   lt3->clone());
+    assert(LinearFastPath::solve({product.get()}) == nullptr);
+    assert(LinearFastPath::solve({odd.get()}) == nullptr);
+    assert(LinearFastPath::solve({either.get()}) == nullptr);
+
+    // FastPathSolver falls back to Z3 outside the fragment
+    FastPathSolver solver;
+    assert(solver.solve(gt0->clone()).isSat);
+    assert(solver.solve(odd->clone()).status == SolverStatus::UNSAT);
+    assert(solver.getFastAnswers() == 1 && solver.getFallbacks() == 1);
+
+    // Sliced sessions decide simple groups without Z3
+    Z3Solver z3;
+    z3.setFastPath(true);
+    z3.beginSession();
+    // One group, joined by the product
+    assert(z3.solveSliced({gt0.get(), product.get(), le.get()},
+                          {x->getNum(), y->getNum()})
+               .isSat);
+    assert(z3.getSession()->getFastPathHits() == 0);
+    z3.endSession();
+    size_t cached = z3.getCexCache().size();
+    z3.beginSession();
+    assert(z3.solveSliced({gt0.get(), le.get()}, {x->getNum(), y->getNum()})
+               .isSat);
+    assert(z3.getSession()->getFastPathHits() == 2);
+    assert(z3.getCexCache().size() == cached);
+    z3.endSession();
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+class QueryLogTest {
+private:
+  SymVarAllocator symVars;
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Query log "
+            "*************"
+         << endl;
+
+    string dir =
+        (filesystem::temp_directory_path() / "test_z3solver_queries").string();
+    filesystem::remove_all(dir);
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
+    unique_ptr<SymVar> y = symVars.getNewSymVar();
+    unique_ptr<SymVar> z = symVars.getNewSymVar();
+
+    // Every query that reaches Z3 is captured with its result
+    {
+      QueryLog log(dir);
+      Z3Solver solver;
+      solver.setQueryLog(&log);
+      assert(solver.solve(TestUtils::makeBinOp("gt", x->clone(),
+                                               make_unique<Num>(3)))
+                 .isSat);
+      solver.beginSession();
+      unique_ptr<Expr> gt3 =
+          TestUtils::makeBinOp("gt", x->clone(), make_unique<Num>(3));
+      unique_ptr<Expr> lt2 =
+          TestUtils::makeBinOp("lt", x->clone(), make_unique<Num>(2));
+      assert(!solver.solveIncremental({gt3.get(), lt2.get()}).isSat);
+      // Independent groups are checked under assumptions, logged asserted
+      unique_ptr<Expr> yLt5 =
+          TestUtils::makeBinOp("lt", y->clone(), make_unique<Num>(5));
+      unique_ptr<Expr> zGt1 =
+          TestUtils::makeBinOp("gt", z->clone(), make_unique<Num>(1));
+      assert(solver.solveSliced({yLt5.get(), zGt1.get()}, {}).isSat);
+      solver.endSession();
+      assert(log.getCount() == 4);
+    }
+
+    // and replays to the same result
+    vector<CapturedQuery> queries = QueryLog::collect({dir});
+    assert(queries.size() == 4);
+    assert(queries[0].status == SolverStatus::SAT);
+    assert(queries[1].status == SolverStatus::UNSAT);
+    assert(queries[2].status == SolverStatus::SAT);
+    assert(queries[3].status == SolverStatus::SAT);
+    for (const CapturedQuery &query : queries) {
+      assert(query.timeMs >= 0);
+      z3::context ctx;
+      z3::solver s(ctx);
+      s.add(ctx.parse_file(query.path.c_str()));
+      assert(s.check() ==
+             (query.status == SolverStatus::SAT ? z3::sat : z3::unsat));
+    }
+    filesystem::remove_all(dir);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+class ModelEnumerationTest {
+private:
+  SymVarAllocator symVars;
+
+public:
+  void execute() {
+    cout << "\n*********************Test case: Model enumeration "
+            "*************"
+         << endl;
+
+    unique_ptr<SymVar> x = symVars.getNewSymVar();
+    unique_ptr<SymVar> y = symVars.getNewSymVar();
+    string xName = "X" + to_string(x->getNum());
+    string yName = "X" + to_string(y->getNum());
+    unique_ptr<Expr> gt0 =
+        TestUtils::makeBinOp("gt", x->clone(), make_unique<Num>(0));
+    unique_ptr<Expr> lt4 =
+        TestUtils::makeBinOp("lt", x->clone(), make_unique<Num>(4));
+
+    // 0 < x < 4 has three models, each found once
+    Z3Solver solver;
+    solver.beginSession();
+    vector<unique_ptr<Result>> models =
+        solver.enumerateModels({gt0.get(), lt4.get()}, {x->getNum()}, 5);
+    assert(models.size() == 3);
+    set<int> values;
+    for (const auto &model : models) {
+      assert(model->isSat);
+      values.insert(
+          dynamic_cast<const IntResultValue *>(model->model.at(xName).get())
+              ->value);
+    }
+    assert(values == set<int>({1, 2, 3}));
+
+    // The blocking clauses are gone afterwards, the conjuncts' scopes not
+    assert(solver.getSession()->getNumScopes() == 2);
+    assert(solver.solveIncremental({gt0.get(), lt4.get()}).isSat);
+
+    // An input the conjuncts leave free is part of the models and varies
+    models = solver.enumerateModels({gt0.get(), lt4.get()},
+                                    {x->getNum(), y->getNum()}, 4);
+    assert(models.size() == 4);
+    set<pair<int, int>> pairs;
+    for (const auto &model : models) {
+      pairs.insert(
+          {dynamic_cast<const IntResultValue *>(model->model.at(xName).get())
+               ->value,
+           dynamic_cast<const IntResultValue *>(model->model.at(yName).get())
+               ->value});
+    }
+    assert(pairs.size() == 4);
+
+    // Nothing to enumerate
+    unique_ptr<Expr> lt0 =
+        TestUtils::makeBinOp("lt", x->clone(), make_unique<Num>(0));
+    assert(solver.enumerateModels({gt0.get(), lt0.get()}, {x->getNum()}, 3)
+               .empty());
+    solver.endSession();
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
+class TypedModelTest {
+public:
+  void execute() {
+    cout << "\n*********************Test case: Typed models "
+            "*************"
+         << endl;
+
+    // X2 and X10, which sort the other way round by name
+    auto factory = make_shared<ExprFactory>();
+    unique_ptr<Expr> x2 = make_unique<SymVar>(2);
+    unique_ptr<Expr> x10 = make_unique<SymVar>(10);
+    unique_ptr<Expr> x3 = make_unique<SymVar>(3);
+    unique_ptr<Expr> gt5 =
+        TestUtils::makeBinOp("gt", x2->clone(), make_unique<Num>(5));
+    unique_ptr<Expr> lt0 =
+        TestUtils::makeBinOp("lt", x10->clone(), make_unique<Num>(-3));
+    unique_ptr<Expr> eq7 =
+        TestUtils::makeBinOp("eq", x3->clone(), make_unique<Num>(7));
+
+    Z3Solver solver;
+    solver.setExprFactory(factory);
+    solver.beginSession();
+    TypedModel model =
+        solver.solveInputs({gt5.get(), lt0.get(), eq7.get()}, {10, 2});
+    assert(model.isSat());
+    assert(model.values.size() == 11);
+    // Constants of the session's factory
+    Num *v2 = dynamic_cast<Num *>(model.get(2));
+    Num *v10 = dynamic_cast<Num *>(model.get(10));
+    assert(v2 != nullptr && v2->value > 5 && v2 == factory->num(v2->value));
+    assert(v10 != nullptr && v10->value < -3);
+    // Not an input
+    assert(model.get(3) == nullptr);
+    assert(model.get(42) == nullptr);
+
+    unique_ptr<Expr> gt0 =
+        TestUtils::makeBinOp("gt", x2->clone(), make_unique<Num>(0));
+    unique_ptr<Expr> lt1 =
+        TestUtils::makeBinOp("lt", x2->clone(), make_unique<Num>(1));
+    TypedModel unsat = solver.solveInputs({gt0.get(), lt1.get()}, {2});
+    assert(unsat.status == SolverStatus::UNSAT && unsat.values.empty());
+    solver.endSession();
+
+    // Values of other types keep them
+    map<string, unique_ptr<ResultValue>> values;
+    values["X0"] = make_unique<BoolResultValue>(true);
+    values["X1"] = make_unique<StringResultValue>("abc");
+    Result result(true, std::move(values));
+    TypedModel converted = toTypedModel(result, {0, 1, 5}, *factory);
+    assert(converted.get(0) == factory->boolean(true));
+    assert(converted.get(1) == factory->str("abc"));
+    assert(converted.get(5) == nullptr);
+
+    cout << "✓ Test passed!" << endl;
+  }
+};
+
 int main() {
   vector<Z3Test *> testcases = {new Z3Test1(),  new Z3Test2(),  new Z3Test3(),
                                 new Z3Test4(),  new Z3Test5(),  new Z3Test6(),
@@ -753,6 +1544,86 @@ int main() {
     }
   }
 
+  try {
+    Z3SessionTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+
+  try {
+    Z3IndependenceTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+
+  try {
+    CexCacheTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+  try {
+    Z3BudgetTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+  try {
+    Z3OperatorRegistryTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+  try {
+    Z3ContextPoolTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+  try {
+    PortfolioSolverTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+  try {
+    LinearFastPathTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+  try {
+    QueryLogTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+  try {
+    ModelEnumerationTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+  try {
+    TypedModelTest().execute();
+    passed++;
+  } catch (const exception &e) {
+    cout << "Test exception: " << e.what() << endl;
+    failed++;
+  }
+
   cout << "\n========================================" << endl;
   cout << "Test Results: " << passed << " passed, " << failed << " failed"
        << endl;
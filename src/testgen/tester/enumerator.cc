@@ -0,0 +1,107 @@
+#include "enumerator.hh"
+#include "../util/trace.hh"
+#include <algorithm>
+
+SequenceEnumerator::SequenceEnumerator(
+    const Spec *s, SymbolTable *symbols, Tester &t,
+    function<unique_ptr<FunctionFactory>()> makeApp, size_t length)
+    : spec(s), globalSymTable(symbols), tester(t), makeApplication(makeApp),
+      maxLength(length), generator(s, TypeMap()), pruned(0),
+      solvedBlocks(0) {
+  for (const auto &block : spec->blocks) {
+    if (block->call &&
+        find(apis.begin(), apis.end(), block->name) == apis.end()) {
+      apis.push_back(block->name);
+    }
+  }
+}
+
+unsigned long SequenceEnumerator::countSequences(size_t depth) const {
+  unsigned long count = 0, level = 1;
+  for (size_t i = 0; i < depth; i++) {
+    level *= apis.size();
+    count += level;
+  }
+  return count;
+}
+
+vector<EnumeratedTest> SequenceEnumerator::enumerate() {
+  vector<EnumeratedTest> tests;
+  // The root is the initialization, which is concrete
+  Program root(generator.generateInit(spec));
+  vector<string> prefix;
+  expand(prefix, root, {}, {}, tests);
+  TRACE(INFO, "[Enumerator] " << tests.size() << " test string(s), "
+              << solvedBlocks << " block(s) solved, " << pruned
+              << " pruned below " << infeasible.size()
+              << " infeasible prefix(es)");
+  return tests;
+}
+
+void SequenceEnumerator::expand(vector<string> &prefix,
+                                const Program &prefixCTC,
+                                const vector<size_t> &blockStarts,
+                                const set<size_t> &chosen,
+                                vector<EnumeratedTest> &tests) {
+  if (prefix.size() >= maxLength) {
+    return;
+  }
+  for (const string &api : apis) {
+    prefix.push_back(api);
+    if (infeasible.blocks(prefix)) {
+      pruned += 1 + countSequences(maxLength - prefix.size());
+      prefix.pop_back();
+      continue;
+    }
+
+    // The prefix's CTC, then the new block
+    vector<unique_ptr<Stmt>> stmts;
+    for (const auto &stmt : prefixCTC.statements) {
+      stmts.push_back(stmt->clone());
+    }
+    vector<size_t> starts = blockStarts;
+    starts.push_back(stmts.size());
+    vector<size_t> inputs;
+    for (auto &stmt : generator.generateBlock(spec, globalSymTable, api)) {
+      if (isInputStmt(*stmt)) {
+        inputs.push_back(stmts.size());
+      }
+      stmts.push_back(std::move(stmt));
+    }
+
+    unique_ptr<FunctionFactory> application = makeApplication();
+    tester.setFunctionFactory(application.get());
+    tester.setChosenStatements(chosen);
+    ValueEnvironment ve(nullptr);
+    unique_ptr<Program> ctc = tester.generateCTC(
+        make_unique<Program>(std::move(stmts)), {}, &ve);
+    tester.setChosenStatements({});
+    tester.setFunctionFactory(nullptr);
+    solvedBlocks++;
+    // The inputs of the block given a value are choices for the extensions
+    set<size_t> childChosen = chosen;
+    for (size_t input : inputs) {
+      if (!isInputStmt(*ctc->statements[input])) {
+        childChosen.insert(input);
+      }
+    }
+
+    const vector<size_t> &core = tester.getUnsatCoreStatements();
+    bool isInfeasible = !core.empty();
+    if (isInfeasible) {
+      size_t length = InfeasiblePrefixes::prefixLength(starts, core);
+      TRACE(INFO, "[Enumerator] Infeasible prefix of " << length
+                  << " API call(s)");
+      infeasible.add(vector<string>(prefix.begin(), prefix.begin() + length));
+      // Its extensions extend the infeasible prefix too
+      pruned += countSequences(maxLength - prefix.size());
+    }
+    // Reported before its extensions; the program outlives the move
+    const Program &node = *ctc;
+    tests.push_back(EnumeratedTest{prefix, std::move(ctc)});
+    if (!isInfeasible) {
+      expand(prefix, node, starts, childChosen, tests);
+    }
+    prefix.pop_back();
+  }
+}
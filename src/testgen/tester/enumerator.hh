@@ -0,0 +1,77 @@
+#ifndef ENUMERATOR_HH
+#define ENUMERATOR_HH
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../language/ast.hh"
+#include "../language/env.hh"
+#include "../see/functionfactory.hh"
+#include "genATC.hh"
+#include "prefixes.hh"
+#include "tester.hh"
+
+using namespace std;
+
+// A test string of an enumeration with its CTC
+struct EnumeratedTest {
+    vector<string> testString;
+    unique_ptr<Program> ctc;
+};
+
+// Enumerates the test strings of 1 to maxLength API calls over the blocks of
+// a spec, depth first over the trie of test strings, each API in spec order.
+// A child of a trie node starts from the node's CTC instead of its ATC: only
+// the new block is generated, and only its inputs are solved for, since the
+// inputs of the prefix are concrete already. So each prefix is generated and
+// solved once, whatever the number of its extensions; its API calls are
+// replayed, on a fresh application, for every extension. The values of
+// the prefix's inputs are choices, not part of the ATC, so no unsat core
+// rests on them (see Tester::setChosenStatements). A node whose assumptions
+// contradict each other whatever the inputs (see
+// Tester::getUnsatCoreStatements) is reported, but the test strings that
+// extend its infeasible prefix are not generated. A node without inputs is concrete once generated, and the
+// tester does not execute it, so a contradiction in it is only found by its
+// first extension with inputs.
+class SequenceEnumerator {
+    private:
+        const Spec* spec;
+        SymbolTable* globalSymTable;
+        Tester& tester;
+        // A fresh application per test string, so that the API calls of
+        // one do not see the state left by another
+        function<unique_ptr<FunctionFactory>()> makeApplication;
+        size_t maxLength;
+        vector<string> apis; // distinct block names, in spec order
+        ATCGenerator generator;
+        InfeasiblePrefixes infeasible;
+        unsigned int pruned;
+        unsigned int solvedBlocks;
+
+        // chosen: the statements of prefixCTC that give inputs the values
+        // chosen for them
+        void expand(vector<string>& prefix, const Program& prefixCTC,
+                    const vector<size_t>& blockStarts,
+                    const set<size_t>& chosen,
+                    vector<EnumeratedTest>& tests);
+        // Test strings of 1 to depth API calls
+        unsigned long countSequences(size_t depth) const;
+    public:
+        SequenceEnumerator(const Spec* spec, SymbolTable* globalSymTable,
+                           Tester& tester,
+                           function<unique_ptr<FunctionFactory>()> makeApplication,
+                           size_t maxLength);
+        vector<EnumeratedTest> enumerate();
+
+        // Test strings not generated because they extend an infeasible prefix
+        unsigned int getPruned() const { return pruned; }
+        // Blocks generated and concretized, one per trie node
+        unsigned int getSolvedBlocks() const { return solvedBlocks; }
+        const InfeasiblePrefixes& getInfeasiblePrefixes() const { return infeasible; }
+};
+
+#endif
@@ -1,5 +1,5 @@
 #include "genATC.hh"
-#include <iostream>
+#include "../util/trace.hh"
 
 // ============================================================================
 // ATCGenerator Implementation
@@ -7,10 +7,10 @@
 
 ATCGenerator::ATCGenerator(const Spec *spec, TypeMap typeMap)
     : spec(spec), typeMap(std::move(typeMap)) {
-  std::cout << "Received Spec with " << spec->globals.size() << " globals, "
-            << spec->init.size() << " init statements, "
-            << spec->functions.size() << " functions, and "
-            << spec->blocks.size() << " blocks." << std::endl;
+  TRACE(INFO, "Received Spec with " << spec->globals.size() << " globals, "
+              << spec->init.size() << " init statements, "
+              << spec->functions.size() << " functions, and "
+              << spec->blocks.size() << " blocks.");
 }
 
 /**
@@ -25,7 +25,7 @@ vector<std::unique_ptr<Stmt>> ATCGenerator::genInit(const Spec *spec) {
     // Create assignment: varName = expr
     auto assignStmt =
         std::make_unique<Assign>(std::make_unique<Var>(init->varName),
-                                 convertExpr(init->expr, nullptr, ""));
+                                 convertExpr(init->expr.get(), nullptr, ""));
     initStmts.push_back(std::move(assignStmt));
   }
 
@@ -37,15 +37,15 @@ vector<std::unique_ptr<Stmt>> ATCGenerator::genInit(const Spec *spec) {
  * Global variables (not in symTable) remain unchanged
  */
 std::unique_ptr<Expr>
-ATCGenerator::convertExpr(const std::unique_ptr<Expr> &expr,
-                          SymbolTable *symTable, const string &suffix) {
+ATCGenerator::convertExpr(Expr *expr, SymbolTable *symTable,
+                          const string &suffix) {
   if (!expr) {
     return nullptr;
   }
 
   // Handle Var
   if (expr->exprType == ExprType::VAR) {
-    Var *var = dynamic_cast<Var *>(expr.get());
+    Var *var = dynamic_cast<Var *>(expr);
     // If variable is in local scope, add suffix
     if (symTable && symTable->hasKey(const_cast<string *>(&var->name))) {
       return std::make_unique<Var>(var->name + suffix);
@@ -56,49 +56,47 @@ ATCGenerator::convertExpr(const std::unique_ptr<Expr> &expr,
 
   // Handle FuncCall
   else if (expr->exprType == ExprType::FUNC_CALL_EXPR) {
-    FuncCall *func = dynamic_cast<FuncCall *>(expr.get());
+    FuncCall *func = dynamic_cast<FuncCall *>(expr);
     vector<std::unique_ptr<Expr>> newArgs;
     for (const auto &arg : func->args) {
-      newArgs.push_back(convertExpr(arg, symTable, suffix));
+      newArgs.push_back(convertExpr(arg.get(), symTable, suffix));
     }
     return std::make_unique<FuncCall>(func->name, std::move(newArgs));
   }
   // Handle Num
   else if (expr->exprType == ExprType::NUM) {
-    Num *num = dynamic_cast<Num *>(expr.get());
+    Num *num = dynamic_cast<Num *>(expr);
     return std::make_unique<Num>(num->value);
   }
   // Handle String
   else if (expr->exprType == ExprType::STRING) {
-    String *str = dynamic_cast<String *>(expr.get());
+    String *str = dynamic_cast<String *>(expr);
     return std::make_unique<String>(str->value);
   }
 
   // Handle Bool
   else if (expr->exprType == ExprType::BOOL) {
-    Bool *b = dynamic_cast<Bool *>(expr.get());
+    Bool *b = dynamic_cast<Bool *>(expr);
     return std::make_unique<Bool>(b->value);
   }
 
   // Handle Set
   else if (expr->exprType == ExprType::SET) {
-    Set *set = dynamic_cast<Set *>(expr.get());
+    Set *set = dynamic_cast<Set *>(expr);
     vector<std::unique_ptr<Expr>> newElements;
     for (const auto &elem : set->elements) {
-      newElements.push_back(convertExpr(elem, symTable, suffix));
+      newElements.push_back(convertExpr(elem.get(), symTable, suffix));
     }
     return std::make_unique<Set>(std::move(newElements));
   }
 
   // Handle Map
   else if (expr->exprType == ExprType::MAP) {
-    Map *map = dynamic_cast<Map *>(expr.get());
+    Map *map = dynamic_cast<Map *>(expr);
     vector<pair<std::unique_ptr<Var>, std::unique_ptr<Expr>>> newValue;
     for (const auto &kv : map->value) {
-      auto newKey =
-          convertExpr(reinterpret_cast<const std::unique_ptr<Expr> &>(kv.first),
-                      symTable, suffix);
-      auto newVal = convertExpr(kv.second, symTable, suffix);
+      auto newKey = convertExpr(kv.first.get(), symTable, suffix);
+      auto newVal = convertExpr(kv.second.get(), symTable, suffix);
       newValue.push_back(
           make_pair(std::unique_ptr<Var>(dynamic_cast<Var *>(newKey.release())),
                     std::move(newVal)));
@@ -108,10 +106,10 @@ ATCGenerator::convertExpr(const std::unique_ptr<Expr> &expr,
 
   // Handle Tuple
   else if (expr->exprType == ExprType::TUPLE) {
-    Tuple *tuple = dynamic_cast<Tuple *>(expr.get());
+    Tuple *tuple = dynamic_cast<Tuple *>(expr);
     vector<std::unique_ptr<Expr>> newExprs;
     for (const auto &e : tuple->exprs) {
-      newExprs.push_back(convertExpr(e, symTable, suffix));
+      newExprs.push_back(convertExpr(e.get(), symTable, suffix));
     }
     return std::make_unique<Tuple>(std::move(newExprs));
   }
@@ -123,15 +121,14 @@ ATCGenerator::convertExpr(const std::unique_ptr<Expr> &expr,
  * Extract variables with prime notation (') from postcondition
  * Example: U' in "U' = U union {uid -> p}" → adds "U" to primedVars
  */
-void ATCGenerator::extractPrimedVars(const std::unique_ptr<Expr> &expr,
-                                     set<string> &primedVars) {
+void ATCGenerator::extractPrimedVars(Expr *expr, set<string> &primedVars) {
   if (!expr)
     return;
 
   // Check for prime function call: '(varname)
   if (expr->exprType == ExprType::FUNC_CALL_EXPR) {
-    FuncCall *func = dynamic_cast<FuncCall *>(expr.get());
-    if (func->name == "'" && func->args.size() > 0) {
+    FuncCall *func = dynamic_cast<FuncCall *>(expr);
+    if (func->op == Opcode::PRIME && func->args.size() > 0) {
       // Extract the variable name inside the prime
       if (func->args[0]->exprType == ExprType::VAR) {
         Var *var = dynamic_cast<Var *>(func->args[0].get());
@@ -140,35 +137,33 @@ void ATCGenerator::extractPrimedVars(const std::unique_ptr<Expr> &expr,
     } else {
       // Recursively check arguments
       for (const auto &arg : func->args) {
-        extractPrimedVars(arg, primedVars);
+        extractPrimedVars(arg.get(), primedVars);
       }
     }
   }
 
   // Handle Set
   else if (expr->exprType == ExprType::SET) {
-    Set *set = dynamic_cast<Set *>(expr.get());
+    Set *set = dynamic_cast<Set *>(expr);
     for (const auto &elem : set->elements) {
-      extractPrimedVars(elem, primedVars);
+      extractPrimedVars(elem.get(), primedVars);
     }
   }
 
   // Handle Map
   else if (expr->exprType == ExprType::MAP) {
-    Map *map = dynamic_cast<Map *>(expr.get());
+    Map *map = dynamic_cast<Map *>(expr);
     for (const auto &kv : map->value) {
-      extractPrimedVars(
-          reinterpret_cast<const std::unique_ptr<Expr> &>(kv.first),
-          primedVars);
-      extractPrimedVars(kv.second, primedVars);
+      extractPrimedVars(kv.first.get(), primedVars);
+      extractPrimedVars(kv.second.get(), primedVars);
     }
   }
 
   // Handle Tuple
   else if (expr->exprType == ExprType::TUPLE) {
-    Tuple *tuple = dynamic_cast<Tuple *>(expr.get());
+    Tuple *tuple = dynamic_cast<Tuple *>(expr);
     for (const auto &e : tuple->exprs) {
-      extractPrimedVars(e, primedVars);
+      extractPrimedVars(e.get(), primedVars);
     }
   }
 }
@@ -179,15 +174,14 @@ void ATCGenerator::extractPrimedVars(const std::unique_ptr<Expr> &expr,
  * - U (when U is in primedVars) → U_old
  */
 std::unique_ptr<Expr>
-ATCGenerator::removePrimeNotation(const std::unique_ptr<Expr> &expr,
-                                  const set<string> &primedVars,
+ATCGenerator::removePrimeNotation(Expr *expr, const set<string> &primedVars,
                                   bool insidePrime) {
   if (!expr)
     return nullptr;
 
   // Handle Var
   if (expr->exprType == ExprType::VAR) {
-    Var *var = dynamic_cast<Var *>(expr.get());
+    Var *var = dynamic_cast<Var *>(expr);
     if (insidePrime) {
       // Inside prime: '(U) → U
       return std::make_unique<Var>(var->name);
@@ -200,50 +194,51 @@ ATCGenerator::removePrimeNotation(const std::unique_ptr<Expr> &expr,
 
   // Handle FuncCall
   if (expr->exprType == ExprType::FUNC_CALL_EXPR) {
-    FuncCall *func = dynamic_cast<FuncCall *>(expr.get());
-    if (func->name == "'" && func->args.size() > 0) {
+    FuncCall *func = dynamic_cast<FuncCall *>(expr);
+    if (func->op == Opcode::PRIME && func->args.size() > 0) {
       // Remove the prime operator
-      return removePrimeNotation(func->args[0], primedVars, true);
+      return removePrimeNotation(func->args[0].get(), primedVars, true);
     }
 
     vector<std::unique_ptr<Expr>> newArgs;
     for (const auto &arg : func->args) {
-      newArgs.push_back(removePrimeNotation(arg, primedVars, insidePrime));
+      newArgs.push_back(
+          removePrimeNotation(arg.get(), primedVars, insidePrime));
     }
     return std::make_unique<FuncCall>(func->name, std::move(newArgs));
   }
 
   // Handle Num
   if (expr->exprType == ExprType::NUM) {
-    Num *num = dynamic_cast<Num *>(expr.get());
+    Num *num = dynamic_cast<Num *>(expr);
     return std::make_unique<Num>(num->value);
   }
 
   // Handle String
   if (expr->exprType == ExprType::STRING) {
-    String *str = dynamic_cast<String *>(expr.get());
+    String *str = dynamic_cast<String *>(expr);
     return std::make_unique<String>(str->value);
   }
 
   // Handle Set
   if (expr->exprType == ExprType::SET) {
-    Set *set = dynamic_cast<Set *>(expr.get());
+    Set *set = dynamic_cast<Set *>(expr);
     vector<std::unique_ptr<Expr>> newElements;
     for (const auto &elem : set->elements) {
-      newElements.push_back(removePrimeNotation(elem, primedVars, insidePrime));
+      newElements.push_back(
+          removePrimeNotation(elem.get(), primedVars, insidePrime));
     }
     return std::make_unique<Set>(std::move(newElements));
   }
 
   // Handle Map
   if (expr->exprType == ExprType::MAP) {
-    Map *map = dynamic_cast<Map *>(expr.get());
+    Map *map = dynamic_cast<Map *>(expr);
     vector<pair<std::unique_ptr<Var>, std::unique_ptr<Expr>>> newValue;
     for (const auto &kv : map->value) {
-      auto newKey = removePrimeNotation(
-          reinterpret_cast<const std::unique_ptr<Expr> &>(kv.first), primedVars,
-          insidePrime);
-      auto newVal = removePrimeNotation(kv.second, primedVars, insidePrime);
+      auto newKey = removePrimeNotation(kv.first.get(), primedVars, insidePrime);
+      auto newVal =
+          removePrimeNotation(kv.second.get(), primedVars, insidePrime);
       newValue.push_back(
           make_pair(std::unique_ptr<Var>(dynamic_cast<Var *>(newKey.release())),
                     std::move(newVal)));
@@ -253,10 +248,11 @@ ATCGenerator::removePrimeNotation(const std::unique_ptr<Expr> &expr,
 
   // Handle Tuple
   if (expr->exprType == ExprType::TUPLE) {
-    Tuple *tuple = dynamic_cast<Tuple *>(expr.get());
+    Tuple *tuple = dynamic_cast<Tuple *>(expr);
     vector<std::unique_ptr<Expr>> newExprs;
     for (const auto &e : tuple->exprs) {
-      newExprs.push_back(removePrimeNotation(e, primedVars, insidePrime));
+      newExprs.push_back(
+          removePrimeNotation(e.get(), primedVars, insidePrime));
     }
     return std::make_unique<Tuple>(std::move(newExprs));
   }
@@ -268,7 +264,7 @@ ATCGenerator::removePrimeNotation(const std::unique_ptr<Expr> &expr,
  * Collect input variables from expression
  * Only variables in local symbol table are considered input variables
  */
-void ATCGenerator::collectInputVars(const std::unique_ptr<Expr> &expr,
+void ATCGenerator::collectInputVars(Expr *expr,
                                     vector<std::unique_ptr<Expr>> &inputVars,
                                     const string &suffix, SymbolTable *symTable,
                                     TypeMap &localTypeMap) {
@@ -277,7 +273,7 @@ void ATCGenerator::collectInputVars(const std::unique_ptr<Expr> &expr,
 
   // Handle Var
   if (expr->exprType == ExprType::VAR) {
-    Var *var = dynamic_cast<Var *>(expr.get());
+    Var *var = dynamic_cast<Var *>(expr);
     if (symTable && symTable->hasKey(const_cast<string *>(&var->name))) {
       // This is an input variable
       inputVars.push_back(std::make_unique<Var>(var->name + suffix));
@@ -293,39 +289,39 @@ void ATCGenerator::collectInputVars(const std::unique_ptr<Expr> &expr,
 
   // Handle FuncCall - recurse into arguments
   if (expr->exprType == ExprType::FUNC_CALL_EXPR) {
-    FuncCall *func = dynamic_cast<FuncCall *>(expr.get());
+    FuncCall *func = dynamic_cast<FuncCall *>(expr);
     for (const auto &arg : func->args) {
-      collectInputVars(arg, inputVars, suffix, symTable, localTypeMap);
+      collectInputVars(arg.get(), inputVars, suffix, symTable, localTypeMap);
     }
     return;
   }
 
   // Handle Set
   if (expr->exprType == ExprType::SET) {
-    Set *set = dynamic_cast<Set *>(expr.get());
+    Set *set = dynamic_cast<Set *>(expr);
     for (const auto &elem : set->elements) {
-      collectInputVars(elem, inputVars, suffix, symTable, localTypeMap);
+      collectInputVars(elem.get(), inputVars, suffix, symTable, localTypeMap);
     }
     return;
   }
 
   // Handle Map
   if (expr->exprType == ExprType::MAP) {
-    Map *map = dynamic_cast<Map *>(expr.get());
+    Map *map = dynamic_cast<Map *>(expr);
     for (const auto &kv : map->value) {
-      collectInputVars(
-          reinterpret_cast<const std::unique_ptr<Expr> &>(kv.first), inputVars,
-          suffix, symTable, localTypeMap);
-      collectInputVars(kv.second, inputVars, suffix, symTable, localTypeMap);
+      collectInputVars(kv.first.get(), inputVars, suffix, symTable,
+                       localTypeMap);
+      collectInputVars(kv.second.get(), inputVars, suffix, symTable,
+                       localTypeMap);
     }
     return;
   }
 
   // Handle Tuple
   if (expr->exprType == ExprType::TUPLE) {
-    Tuple *tuple = dynamic_cast<Tuple *>(expr.get());
+    Tuple *tuple = dynamic_cast<Tuple *>(expr);
     for (const auto &e : tuple->exprs) {
-      collectInputVars(e, inputVars, suffix, symTable, localTypeMap);
+      collectInputVars(e.get(), inputVars, suffix, symTable, localTypeMap);
     }
     return;
   }
@@ -380,11 +376,12 @@ vector<std::unique_ptr<Stmt>> ATCGenerator::genBlock(const Spec *spec,
   vector<std::unique_ptr<Expr>> rawInputVars;
   // Collect from args
   for (const auto &arg : block->call->call->args) {
-    collectInputVars(arg, rawInputVars, suffix, blockSymTable, localTypeMap);
+    collectInputVars(arg.get(), rawInputVars, suffix, blockSymTable,
+                     localTypeMap);
   }
   // Collect from precondition (to support Any(x))
   if (block->pre) {
-    collectInputVars(block->pre, rawInputVars, suffix, blockSymTable,
+    collectInputVars(block->pre.get(), rawInputVars, suffix, blockSymTable,
                      localTypeMap);
   }
 
@@ -413,7 +410,7 @@ vector<std::unique_ptr<Stmt>> ATCGenerator::genBlock(const Spec *spec,
   // Step 3: Generate precondition assumption
   // assume(genPred(σ_b))
   if (block->pre) {
-    auto convertedPre = convertExpr(block->pre, blockSymTable, suffix);
+    auto convertedPre = convertExpr(block->pre.get(), blockSymTable, suffix);
     blockStmts.push_back(std::make_unique<Assume>(std::move(convertedPre)));
   }
 
@@ -421,7 +418,10 @@ vector<std::unique_ptr<Stmt>> ATCGenerator::genBlock(const Spec *spec,
   // Extract variables with prime notation (e.g., U')
   set<string> primedVars;
   if (block->call->response.expr) {
-    extractPrimedVars(block->call->response.expr, primedVars);
+    extractPrimedVars(block->call->response.expr.get(), primedVars);
+  }
+  if (block->post) {
+    extractPrimedVars(block->post.get(), primedVars);
   }
 
   // Step 5: Create old variable assignments for primed variables
@@ -440,7 +440,7 @@ vector<std::unique_ptr<Stmt>> ATCGenerator::genBlock(const Spec *spec,
   // Convert the API call with renamed variables
   vector<std::unique_ptr<Expr>> convertedArgs;
   for (const auto &arg : block->call->call->args) {
-    convertedArgs.push_back(convertExpr(arg, blockSymTable, suffix));
+    convertedArgs.push_back(convertExpr(arg.get(), blockSymTable, suffix));
   }
   auto convertedCall = std::make_unique<FuncCall>(block->call->call->name,
                                                   std::move(convertedArgs));
@@ -451,7 +451,8 @@ vector<std::unique_ptr<Stmt>> ATCGenerator::genBlock(const Spec *spec,
 
   if (block->call->response.expr) {
     // Convert the response expression to get variable names with suffix
-    returnVar = convertExpr(block->call->response.expr, blockSymTable, suffix);
+    returnVar =
+        convertExpr(block->call->response.expr.get(), blockSymTable, suffix);
   } else {
     // Fallback to default result variable
     returnVar = std::make_unique<Var>("_result" + suffix);
@@ -473,8 +474,9 @@ vector<std::unique_ptr<Stmt>> ATCGenerator::genBlock(const Spec *spec,
   //       std::make_unique<Assert>(std::move(postWithoutPrimes)));
   // }
   if (block->post) {
-    auto convertedPost = convertExpr(block->post, blockSymTable, suffix);
-    auto postWithoutPrimes = removePrimeNotation(convertedPost, primedVars);
+    auto convertedPost = convertExpr(block->post.get(), blockSymTable, suffix);
+    auto postWithoutPrimes =
+        removePrimeNotation(convertedPost.get(), primedVars);
     blockStmts.push_back(
         std::make_unique<Assert>(std::move(postWithoutPrimes)));
   }
@@ -482,6 +484,32 @@ vector<std::unique_ptr<Stmt>> ATCGenerator::genBlock(const Spec *spec,
   return blockStmts;
 }
 
+// Statements of every spec block named name, in declaration order
+vector<std::unique_ptr<Stmt>>
+ATCGenerator::generateBlock(const Spec *spec, SymbolTable *globalSymTable,
+                            const string &name) {
+  vector<std::unique_ptr<Stmt>> stmts;
+  for (size_t i = 0; i < spec->blocks.size(); i++) {
+    TRACE(INFO, "Processing block: " << spec->blocks[i]->name
+                << " against test string: " << name);
+    if (name != spec->blocks[i]->name) {
+      continue;
+    }
+    const API *block = spec->blocks[i].get();
+    SymbolTable *blockSymTable =
+        globalSymTable ? globalSymTable->getChild(i) : nullptr;
+
+    if (block && blockSymTable) {
+      // Generate statements for this block
+      auto blockStmts = genBlock(spec, block, blockSymTable, i);
+      for (auto &stmt : blockStmts) {
+        stmts.push_back(std::move(stmt));
+      }
+    }
+  }
+  return stmts;
+}
+
 /**
  * Main generation function
  * Implements the genATC algorithm from design notes
@@ -498,27 +526,11 @@ Program ATCGenerator::generate(const Spec *spec, SymbolTable *globalSymTable,
 
   // Step 2: Generate blocks for each API call in spec
   // Each block uses a child symbol table from the global symbol table
-
+  blockStarts.clear();
   for (size_t j = 0; j < testString.size(); j++) {
-
-    for (size_t i = 0; i < spec->blocks.size(); i++) {
-      std::cout << "Processing block: " << spec->blocks[i]->name
-                << " against test string: " << testString[j] << std::endl;
-      if (testString[j] != spec->blocks[i]->name) {
-        continue;
-      } else {
-        const API *block = spec->blocks[i].get();
-        SymbolTable *blockSymTable =
-            globalSymTable ? globalSymTable->getChild(i) : nullptr;
-
-        if (block && blockSymTable) {
-          // Generate statements for this block
-          auto blockStmts = genBlock(spec, block, blockSymTable, i);
-          for (auto &stmt : blockStmts) {
-            programStmts.push_back(std::move(stmt));
-          }
-        }
-      }
+    blockStarts.push_back(programStmts.size());
+    for (auto &stmt : generateBlock(spec, globalSymTable, testString[j])) {
+      programStmts.push_back(std::move(stmt));
     }
   }
 
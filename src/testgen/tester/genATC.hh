@@ -30,6 +30,8 @@ class ATCGenerator {
 private:
     const Spec* spec;
     TypeMap typeMap;
+    // First statement of each test string entry's block in the last ATC
+    vector<size_t> blockStarts;
     
     /**
      * Generate initialization block from spec.global
@@ -66,7 +68,7 @@ private:
      * Variables in local scope get suffix (e.g., uid → uid0)
      * Global variables remain unchanged
      */
-    unique_ptr<Expr> convertExpr(const unique_ptr<Expr>& expr, 
+    unique_ptr<Expr> convertExpr(Expr* expr,
                                   SymbolTable* symTable, 
                                   const string& suffix);
     
@@ -74,13 +76,13 @@ private:
      * Extract variables with prime notation (') from postcondition
      * These represent "next state" variables (e.g., U' means U_next)
      */
-    void extractPrimedVars(const unique_ptr<Expr>& expr, set<string>& primedVars);
+    void extractPrimedVars(Expr* expr, set<string>& primedVars);
     
     /**
      * Remove prime notation from expression
      * Converts: U' → U, and unprimed globals → U_old
      */
-    unique_ptr<Expr> removePrimeNotation(const unique_ptr<Expr>& expr, 
+    unique_ptr<Expr> removePrimeNotation(Expr* expr,
                                          const set<string>& primedVars, 
                                          bool insidePrime = false);
     
@@ -88,7 +90,7 @@ private:
      * Collect input variables from expression
      * Input variables are those in the local symbol table
      */
-    void collectInputVars(const unique_ptr<Expr>& expr, 
+    void collectInputVars(Expr* expr,
                          vector<unique_ptr<Expr>>& inputVars,
                          const string& suffix,
                          SymbolTable* symTable,
@@ -111,6 +113,26 @@ public:
      */
     Program generate(const Spec* spec, 
                     SymbolTable* globalSymTable, vector<string> testString);
+
+    /**
+     * Statements of the initialization block
+     */
+    vector<unique_ptr<Stmt>> generateInit(const Spec* spec) { return genInit(spec); }
+
+    /**
+     * Statements of the block(s) of one test string entry, as generate
+     * appends them for it
+     */
+    vector<unique_ptr<Stmt>> generateBlock(const Spec* spec,
+                                           SymbolTable* globalSymTable,
+                                           const string& name);
+
+    /**
+     * Index of the first statement of each block of the last generated ATC,
+     * one per test string entry; statements before the first block are the
+     * initialization
+     */
+    const vector<size_t>& getBlockStarts() const { return blockStarts; }
 };
 
 #endif // GENATC_HH
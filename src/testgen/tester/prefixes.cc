@@ -0,0 +1,49 @@
+#include "prefixes.hh"
+#include <algorithm>
+
+void InfeasiblePrefixes::add(const vector<string> &prefix) {
+  lock_guard<mutex> guard(lock);
+  prefixes.insert(prefix);
+}
+
+bool InfeasiblePrefixes::blocks(const vector<string> &testString,
+                                vector<string> *prefix) {
+  lock_guard<mutex> guard(lock);
+  vector<string> candidate;
+  for (size_t length = 0; length <= testString.size(); length++) {
+    if (length > 0) {
+      candidate.push_back(testString[length - 1]);
+    }
+    if (prefixes.count(candidate) > 0) {
+      if (prefix != nullptr) {
+        *prefix = candidate;
+      }
+      skips++;
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t InfeasiblePrefixes::size() const {
+  lock_guard<mutex> guard(lock);
+  return prefixes.size();
+}
+
+unsigned int InfeasiblePrefixes::getSkips() const {
+  lock_guard<mutex> guard(lock);
+  return skips;
+}
+
+size_t InfeasiblePrefixes::prefixLength(const vector<size_t> &blockStarts,
+                                        const vector<size_t> &statements) {
+  size_t length = 0;
+  for (size_t statement : statements) {
+    // Blocks starting at or before the statement; the last one holds it
+    size_t blocks = upper_bound(blockStarts.begin(), blockStarts.end(),
+                                statement) -
+                    blockStarts.begin();
+    length = max(length, blocks);
+  }
+  return length;
+}
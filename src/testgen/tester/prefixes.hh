@@ -0,0 +1,41 @@
+#ifndef PREFIXES_HH
+#define PREFIXES_HH
+
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Test string prefixes known to be infeasible: the assumptions of their
+// blocks contradict each other whatever the inputs, so every test string
+// that extends one is infeasible too and need not be solved. They come
+// from unsat cores (see Tester::getUnsatCoreStatements), which leave out
+// the assumptions that only fail with the values chosen for inputs, in the
+// same generation or in a prefix concretized before. Thread-safe.
+class InfeasiblePrefixes {
+    private:
+        mutable mutex lock;
+        set<vector<string>> prefixes;
+        unsigned int skips;
+
+    public:
+        InfeasiblePrefixes() : skips(0) {}
+        void add(const vector<string>& prefix);
+        // True if a recorded prefix starts testString; the shortest such
+        // prefix goes to prefix, if given. Counts a skip.
+        bool blocks(const vector<string>& testString,
+                    vector<string>* prefix = nullptr);
+        size_t size() const;
+        unsigned int getSkips() const;
+
+        // Number of blocks of an ATC, from the first, that contain the
+        // statements, given the first statement of each block (see
+        // ATCGenerator::getBlockStarts). 0 if they are all initialization.
+        static size_t prefixLength(const vector<size_t>& blockStarts,
+                                   const vector<size_t>& statements);
+};
+
+#endif
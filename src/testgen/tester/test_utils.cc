@@ -1,67 +1,69 @@
 #include "test_utils.hh"
 
-// string TestUtils::exprToString(Expr *expr) {
-//   if (!expr)
-//     return "null";
+string TestUtils::exprToString(Expr *expr) {
+  if (!expr)
+    return "null";
 
-//   if (expr->exprType == ExprType::SYMVAR) {
-//     SymVar *sv = dynamic_cast<SymVar *>(expr);
-//     return "X" + to_string(sv->getNum());
-//   } else if (expr->exprType == ExprType::NUM) {
-//     Num *num = dynamic_cast<Num *>(expr);
-//     return to_string(num->value);
-//   } else if (expr->exprType == ExprType::VAR) {
-//     Var *var = dynamic_cast<Var *>(expr);
-//     return var->name;
-//   } else if (expr->exprType == ExprType::FUNC_CALL_EXPR) {
-//     FuncCall *fc = dynamic_cast<FuncCall *>(expr);
-//     string result = fc->name + "(";
-//     for (size_t i = 0; i < fc->args.size(); i++) {
-//       if (i > 0)
-//         result += ", ";
-//       result += exprToString(fc->args[i].get());
-//     }
-//     result += ")";
-//     return result;
-//   } else if (expr->exprType == ExprType::STRING) {
-//     String *str = dynamic_cast<String *>(expr);
-//     return "\"" + str->value + "\"";
-//   } else if (expr->exprType == ExprType::SET) {
-//     Set *set = dynamic_cast<Set *>(expr);
-//     string result = "{";
-//     for (size_t i = 0; i < set->elements.size(); i++) {
-//       if (i > 0)
-//         result += ", ";
-//       result += exprToString(set->elements[i].get());
-//     }
-//     result += "}";
-//     return result;
-//   } else if (expr->exprType == ExprType::MAP) {
-//     Map *map = dynamic_cast<Map *>(expr);
-//     string result = "{";
-//     for (size_t i = 0; i < map->value.size(); i++) {
-//       if (i > 0)
-//         result += ", ";
-//       result += exprToString(map->value[i].first.get());
-//       result += " -> ";
-//       result += exprToString(map->value[i].second.get());
-//     }
-//     result += "}";
-//     return result;
-//   } else if (expr->exprType == ExprType::TUPLE) {
-//     Tuple *tuple = dynamic_cast<Tuple *>(expr);
-//     string result = "(";
-//     for (size_t i = 0; i < tuple->exprs.size(); i++) {
-//       if (i > 0)
-//         result += ", ";
-//       result += exprToString(tuple->exprs[i].get());
-//     }
-//     result += ")";
-//     return result;
-//   }
+  if (expr->exprType == ExprType::SYMVAR) {
+    SymVar *sv = dynamic_cast<SymVar *>(expr);
+    return "X" + to_string(sv->getNum());
+  } else if (expr->exprType == ExprType::NUM) {
+    Num *num = dynamic_cast<Num *>(expr);
+    return to_string(num->value);
+  } else if (expr->exprType == ExprType::VAR) {
+    Var *var = dynamic_cast<Var *>(expr);
+    return var->name;
+  } else if (expr->exprType == ExprType::FUNC_CALL_EXPR) {
+    FuncCall *fc = dynamic_cast<FuncCall *>(expr);
+    string result = fc->name + "(";
+    for (size_t i = 0; i < fc->args.size(); i++) {
+      if (i > 0)
+        result += ", ";
+      result += exprToString(fc->args[i].get());
+    }
+    result += ")";
+    return result;
+  } else if (expr->exprType == ExprType::STRING) {
+    String *str = dynamic_cast<String *>(expr);
+    return "\"" + str->value + "\"";
+  } else if (expr->exprType == ExprType::BOOL) {
+    return dynamic_cast<Bool *>(expr)->value ? "true" : "false";
+  } else if (expr->exprType == ExprType::SET) {
+    Set *set = dynamic_cast<Set *>(expr);
+    string result = "{";
+    for (size_t i = 0; i < set->elements.size(); i++) {
+      if (i > 0)
+        result += ", ";
+      result += exprToString(set->elements[i].get());
+    }
+    result += "}";
+    return result;
+  } else if (expr->exprType == ExprType::MAP) {
+    Map *map = dynamic_cast<Map *>(expr);
+    string result = "{";
+    for (size_t i = 0; i < map->value.size(); i++) {
+      if (i > 0)
+        result += ", ";
+      result += exprToString(map->value[i].first.get());
+      result += " -> ";
+      result += exprToString(map->value[i].second.get());
+    }
+    result += "}";
+    return result;
+  } else if (expr->exprType == ExprType::TUPLE) {
+    Tuple *tuple = dynamic_cast<Tuple *>(expr);
+    string result = "(";
+    for (size_t i = 0; i < tuple->exprs.size(); i++) {
+      if (i > 0)
+        result += ", ";
+      result += exprToString(tuple->exprs[i].get());
+    }
+    result += ")";
+    return result;
+  }
 
-//   return "Unknown";
-// }
+  return "Unknown";
+}
 
 unique_ptr<FuncCall> TestUtils::makeBinOp(string op, unique_ptr<Expr> left,
                                           unique_ptr<Expr> right) {
@@ -85,12 +87,12 @@ unique_ptr<Assume> TestUtils::makeAssumeEq(unique_ptr<Expr> left,
 
 void TestUtils::printSigma(ValueEnvironment &sigma) {
   cout << "\nSigma (value environment):" << endl;
-  for (auto &entry : sigma.getTable()) {
+  for (const auto &entry : sigma.getBindings()) {
     cout << "  " << entry.first << " -> " << entry.second->toString() << endl;
   }
 }
 
-void TestUtils::printPathConstraints(vector<Expr *> &pathConstraint) {
+void TestUtils::printPathConstraints(const vector<Expr *> &pathConstraint) {
   cout << "\nPath constraints:" << endl;
   for (size_t i = 0; i < pathConstraint.size(); i++) {
     cout << "  C[" << i << "] = " << pathConstraint[i]->toString() << endl;
@@ -101,7 +103,7 @@ void TestUtils::executeAndDisplay(SEE &see) {
   ValueEnvironment &sigma = see.getSigma();
   printSigma(sigma);
 
-  vector<Expr *> &pathConstraint = see.getPathConstraint();
+  const vector<Expr *> &pathConstraint = see.getPathConstraint();
   printPathConstraints(pathConstraint);
 }
 
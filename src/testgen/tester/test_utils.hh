@@ -19,7 +19,7 @@ using namespace std;
 class TestUtils {
 public:
   // Helper function to print expressions recursively
-  // static string exprToString(Expr *expr);
+  static string exprToString(Expr *expr);
 
   // Helper function to create a binary operation function call (e.g., Add, Mul,
   // Eq)
@@ -37,7 +37,7 @@ public:
   static void printSigma(ValueEnvironment &sigma);
 
   // Helper to print path constraints
-  static void printPathConstraints(vector<Expr *> &pathConstraint);
+  static void printPathConstraints(const vector<Expr *> &pathConstraint);
 
   // Helper to display execution results (call after see.execute)
   static void executeAndDisplay(SEE &see);
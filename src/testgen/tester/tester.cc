@@ -1,5 +1,7 @@
 #include "tester.hh"
-#include <iostream>
+#include "../util/trace.hh"
+#include <algorithm>
+#include <chrono>
 
 void Tester::generateTest() {}
 
@@ -10,7 +12,7 @@ bool isInputStmt(const Stmt &stmt) {
     if (assign && assign->right->exprType == ExprType::FUNC_CALL_EXPR) {
       const FuncCall *fc = dynamic_cast<const FuncCall *>(assign->right.get());
       if (fc) {
-        return (fc->name == "input" && fc->args.size() == 0);
+        return (fc->op == Opcode::INPUT && fc->args.size() == 0);
       }
     }
   }
@@ -37,24 +39,189 @@ bool isAbstract(const Program &prog) {
 unique_ptr<Program> Tester::generateCTC(unique_ptr<Program> atc,
                                         vector<Expr *> ConcreteVals,
                                         ValueEnvironment *ve) {
-  cout << "\n========================================" << endl;
-  cout << ">>> generateCTC: Starting iteration" << endl;
-  cout << "========================================" << endl;
+  // Every iteration re-solves an extension of the previous path constraint,
+  // so keep one solver session alive for the whole generation. SEE starts
+  // from statement 0 and later iterations resume from its checkpoint. All
+  // expressions of the generation are allocated in a fresh factory; the one
+  // of the previous generation is released here in one go.
+  exprFactory = make_shared<ExprFactory>();
+  see.beginSession(exprFactory);
+  solver.setExprFactory(exprFactory);
+  solver.beginSession();
+  coreStatements.clear();
+  try {
+    unique_ptr<Program> ctc =
+        generateCTCStep(std::move(atc), ConcreteVals, ve);
+    TRACE(INFO, ">>> generateCTC: Fast path decided "
+                << solver.getSession()->getFastPathHits() << " group(s)");
+    solver.endSession();
+    const CexCache &cache = solver.getCexCache();
+    TRACE(INFO, ">>> generateCTC: Counterexample cache: "
+                << cache.getHits() << " hit(s) (" << cache.getExactHits()
+                << " exact, " << cache.getSubsetHits() << " UNSAT subset, "
+                << cache.getSupersetHits() << " SAT superset), "
+                << cache.getMisses() << " miss(es)");
+    return ctc;
+  } catch (...) {
+    solver.endSession();
+    throw;
+  }
+}
+
+vector<vector<unique_ptr<Expr>>>
+Tester::enumerateInputValues(unique_ptr<Program> &atc, size_t numModels) {
+  exprFactory = make_shared<ExprFactory>();
+  see.beginSession(exprFactory);
+  solver.setExprFactory(exprFactory);
+  solver.beginSession();
+  vector<vector<unique_ptr<Expr>>> assignments;
+  try {
+    // Run up to the first point that needs inputs, as the first iteration
+    // of generateCTC does
+    unique_ptr<Program> program = rewriteATC(atc, {});
+    SymbolTable st(nullptr);
+    see.execute(*program, st);
+    pathConstraints = see.getPathConstraint();
+    vector<unsigned int> inputs = see.getPendingInputs();
+    if (see.isInfeasible()) {
+      // No models; generateCTC finds the path UNSAT as well
+      numModels = 0;
+    }
+    for (const unique_ptr<Result> &model :
+         solver.enumerateModels(pathConstraints, inputs, numModels)) {
+      // The factory's nodes go with the session; keep copies
+      vector<unique_ptr<Expr>> values;
+      for (Expr *value : extractConcreteValues(
+               toTypedModel(*model, inputs, *exprFactory), inputs)) {
+        values.push_back(value->clone());
+      }
+      assignments.push_back(std::move(values));
+    }
+    solver.endSession();
+  } catch (...) {
+    solver.endSession();
+    throw;
+  }
+  return assignments;
+}
+
+Exploration
+Tester::explorePaths(unique_ptr<Program> atc, Searcher &searcher,
+                     function<unique_ptr<FunctionFactory>()> makeApplication,
+                     size_t budgetMs, ValueEnvironment *ve) {
+  using Clock = chrono::steady_clock;
+  auto seconds = [](Clock::duration d) {
+    return chrono::duration<double>(d).count();
+  };
+  Exploration result;
+  result.stats.searcher = searcher.getName();
+  Clock::time_point start = Clock::now();
+  Clock::time_point deadline = start + chrono::milliseconds(budgetMs);
+
+  bool wasForking = see.isForking();
+  see.setForking(true);
+  exploring = true;
+  // The path without decisions: the first disjunct at every split
+  searcher.add(make_unique<SymbolicState>());
+  try {
+    while (!searcher.empty() && (budgetMs == 0 || Clock::now() < deadline)) {
+      result.stats.maxFrontier =
+          max(result.stats.maxFrontier, searcher.size());
+      unique_ptr<SymbolicState> path = searcher.next();
+      vector<unsigned int> decisions;
+      for (const auto &decision : path->decisions) {
+        decisions.push_back(decision.second);
+      }
+      see.setDecisions(decisions);
+      unique_ptr<FunctionFactory> application = makeApplication();
+      see.setFunctionFactory(application.get());
+      unique_ptr<Program> ctc = generateCTC(rewriteATC(atc, {}), {}, ve);
+      see.setFunctionFactory(nullptr);
+      result.stats.paths++;
+
+      // Paths split off this one, past the decisions it replayed
+      while (!see.getForks().empty()) {
+        searcher.add(see.takeFork(0));
+      }
+      if (isAbstract(*ctc)) {
+        TRACE(INFO, ">>> explorePaths: Path " << result.stats.paths
+                    << " is infeasible");
+        continue;
+      }
+      searcher.covered(see.getState());
+      if (result.ctcs.empty()) {
+        result.stats.firstTestSeconds = seconds(Clock::now() - start);
+      }
+      result.ctcs.push_back(std::move(ctc));
+    }
+  } catch (...) {
+    see.setDecisions({});
+    see.setForking(wasForking);
+    exploring = false;
+    throw;
+  }
+  see.setDecisions({});
+  see.setForking(wasForking);
+  exploring = false;
+
+  result.stats.tests = result.ctcs.size();
+  result.stats.seconds = seconds(Clock::now() - start);
+  if (result.stats.seconds > 0) {
+    result.stats.statesPerSecond = result.stats.paths / result.stats.seconds;
+  }
+  TRACE(INFO, ">>> explorePaths: " << result.stats.searcher << ": "
+              << result.stats.paths << " path(s), " << result.stats.tests
+              << " test(s), frontier up to " << result.stats.maxFrontier);
+  return result;
+}
+
+vector<unique_ptr<Program>> Tester::generateCTCs(unique_ptr<Program> atc,
+                                                 size_t numModels,
+                                                 ValueEnvironment *ve) {
+  vector<unique_ptr<Program>> ctcs;
+  vector<vector<unique_ptr<Expr>>> assignments;
+  if (numModels > 1 && isAbstract(*atc)) {
+    assignments = enumerateInputValues(atc, numModels);
+  }
+  if (assignments.empty()) {
+    // Concrete, a single CTC asked for, or a path constraint that is not
+    // SAT: generateCTC handles it as usual
+    ctcs.push_back(generateCTC(std::move(atc), {}, ve));
+    return ctcs;
+  }
+
+  for (const vector<unique_ptr<Expr>> &values : assignments) {
+    TRACE(INFO, ">>> generateCTCs: CTC " << ctcs.size() + 1 << " of "
+                << assignments.size());
+    vector<Expr *> concreteVals;
+    for (const unique_ptr<Expr> &value : values) {
+      concreteVals.push_back(value.get());
+    }
+    ctcs.push_back(generateCTC(rewriteATC(atc, {}), concreteVals, ve));
+  }
+  return ctcs;
+}
+
+unique_ptr<Program> Tester::generateCTCStep(unique_ptr<Program> atc,
+                                            vector<Expr *> ConcreteVals,
+                                            ValueEnvironment *ve) {
+  TRACE(INFO, "\n========================================");
+  TRACE(INFO, ">>> generateCTC: Starting iteration");
+  TRACE(INFO, "========================================");
 
   // If not abstract (no input statements), return as-is
   if (!isAbstract(*atc)) {
-    cout << ">>> generateCTC: Program is concrete, returning" << endl;
+    TRACE(INFO, ">>> generateCTC: Program is concrete, returning");
     return atc;
   }
 
-  cout << ">>> generateCTC: Program is abstract, needs concretization" << endl;
-  cout << ">>> generateCTC: Concrete values provided: " << ConcreteVals.size()
-       << endl;
+  TRACE(INFO, ">>> generateCTC: Program is abstract, needs concretization");
+  TRACE(INFO, ">>> generateCTC: Concrete values provided: "
+              << ConcreteVals.size());
 
   // Rewrite the abstract test case by replacing Input statements with concrete
   // values
-  cout << "\n>>> generateCTC: STEP 1 - Rewriting ATC with concrete values"
-       << endl;
+  TRACE(INFO, "\n>>> generateCTC: STEP 1 - Rewriting ATC with concrete values");
   unique_ptr<Program> rewritten = rewriteATC(atc, ConcreteVals);
 
   // // Check if rewriting made progress (i.e., the rewritten program is now
@@ -63,52 +230,174 @@ unique_ptr<Program> Tester::generateCTC(unique_ptr<Program> atc,
   //     return rewritten;
   // }
 
-  // Run symbolic execution on the rewritten test case using class member
-  cout << "\n>>> generateCTC: STEP 2 - Running symbolic execution" << endl;
+  // Run symbolic execution on the rewritten test case using class member.
+  // After the first iteration SEE resumes at the statement that interrupted
+  // it instead of re-running the program (and its API calls) from the start.
+  TRACE(INFO, "\n>>> generateCTC: STEP 2 - Running symbolic execution");
   SymbolTable st(nullptr);
-  see.execute(*rewritten, st);
-
-  // Get the path constraints from symbolic execution and store in class member
-  pathConstraints = see.getPathConstraint();
-  unique_ptr<Expr> pathConstraint = see.computePathConstraint();
-
-  // Solve the path constraints to get new concrete values using class member
-  cout << "\n>>> generateCTC: STEP 3 - Solving path constraints with Z3"
-       << endl;
-  Result result = solver.solve(std::move(pathConstraint));
-
-  // Extract concrete values from the solver result
-  vector<Expr *> newConcreteVals;
-  if (result.isSat) {
-    cout << ">>> generateCTC: SAT - Extracting " << result.model.size()
-         << " concrete values" << endl;
-    // Extract values from the model in order (X0, X1, X2, ...)
-    for (const auto &entry : result.model) {
-      if (entry.second->type == ResultType::INT) {
-        const IntResultValue *intVal =
-            dynamic_cast<const IntResultValue *>(entry.second.get());
-        cout << "    " << entry.first << " = " << intVal->value << endl;
-        newConcreteVals.push_back(new Num(intVal->value));
-      }
-    }
+  if (see.hasCheckpoint()) {
+    see.resume(*rewritten, st);
   } else {
-    cout << ">>> generateCTC: UNSAT - No solution found, cannot continue"
-         << endl;
+    see.execute(*rewritten, st);
   }
 
+  // Solve the path constraints to get new concrete values using class member.
+  // The conjuncts are handed over one by one so that the solver session only
+  // asserts the ones it has not seen yet. Only the independent groups that
+  // constrain the pending inputs, or that are new since the previous query,
+  // are sent to Z3.
+  TRACE(INFO, "\n>>> generateCTC: STEP 3 - Solving path constraints with Z3");
+  vector<unsigned int> inputs = see.getPendingInputs();
+  TypedModel model = solvePathConstraint(inputs);
+  // An infeasible path gives way to a sibling split off at a disjunction
+  while (model.status == SolverStatus::UNSAT && !exploring &&
+         exploreFork(*rewritten, st)) {
+    inputs = see.getPendingInputs();
+    model = solvePathConstraint(inputs);
+  }
+  if (model.status == SolverStatus::UNSAT) {
+    findCoreStatements(*rewritten);
+  }
+  vector<Expr *> newConcreteVals = model.isDecided()
+                                       ? extractConcreteValues(model, inputs)
+                                       : handleUnknown(model.status, inputs);
+
   // If we didn't get any new concrete values, we can't make progress
   if (newConcreteVals.empty()) {
-    cout << ">>> generateCTC: No new concrete values, returning partially "
-            "rewritten program"
-         << endl;
+    TRACE(INFO, ">>> generateCTC: No new concrete values, returning partially "
+                "rewritten program");
     // Return the partially rewritten program
     return rewritten;
   }
 
   // Recursively generate CTC with the new concrete values
-  cout << "\n>>> generateCTC: STEP 4 - Recursing with "
-       << newConcreteVals.size() << " new concrete values" << endl;
-  return generateCTC(std::move(rewritten), newConcreteVals, ve);
+  TRACE(INFO, "\n>>> generateCTC: STEP 4 - Recursing with "
+              << newConcreteVals.size() << " new concrete values");
+  return generateCTCStep(std::move(rewritten), newConcreteVals, ve);
+}
+
+vector<Expr *>
+Tester::extractConcreteValues(const TypedModel &model,
+                              const vector<unsigned int> &inputs) {
+  vector<Expr *> values;
+  if (!model.isSat()) {
+    TRACE(INFO, ">>> generateCTC: UNSAT - No solution found, cannot continue");
+    return values;
+  }
+  TRACE(INFO, ">>> generateCTC: SAT - Extracting " << inputs.size()
+              << " concrete values");
+  // Extract the values of the pending input SymVars in program order.
+  // SymVars bound in earlier iterations are pinned in the path constraint,
+  // but their statements are already concrete.
+  for (unsigned int num : inputs) {
+    Expr *value = model.get(num);
+    if (value == nullptr) {
+      break;
+    }
+    TRACE(INFO, "    X" << num << " = " << value->toString());
+    values.push_back(value);
+  }
+  return values;
+}
+
+TypedModel Tester::solvePathConstraint(const vector<unsigned int> &inputs) {
+  // Get the path constraints from symbolic execution and store in class member
+  pathConstraints = see.getPathConstraint();
+  if (see.isInfeasible()) {
+    TRACE(INFO, ">>> generateCTC: Conjunct " << see.getFalsified()
+                << " is false, UNSAT without the solver");
+    return TypedModel(SolverStatus::UNSAT);
+  }
+  return solver.solveInputs(pathConstraints, inputs);
+}
+
+bool Tester::exploreFork(Program &program, SymbolTable &st) {
+  while (!see.getForks().empty()) {
+    unique_ptr<SymbolicState> fork = see.takeFork(0);
+    if (see.isLive(*fork)) {
+      TRACE(INFO, ">>> generateCTC: Path infeasible, exploring a fork at "
+                  "statement " << fork->pc - 1);
+      see.explore(std::move(fork), program, st);
+      return true;
+    }
+  }
+  return false;
+}
+
+void Tester::findCoreStatements(const Program &program) {
+  // Only the conjuncts of assume statements that do not depend on the
+  // values chosen for earlier inputs: those are choices of this generation,
+  // not a property of the ATC
+  const vector<size_t> &origins = see.getConstraintOrigins();
+  const vector<bool> &chosen = see.getConstraintChosen();
+  if (origins.size() != pathConstraints.size() ||
+      chosen.size() != pathConstraints.size()) {
+    return;
+  }
+  auto isAssumed = [&](size_t i) {
+    return !chosen[i] && origins[i] < program.statements.size() &&
+           program.statements[origins[i]]->statementType == StmtType::ASSUME;
+  };
+  if (see.isInfeasible()) {
+    // The assume that folded to false is a core on its own
+    if (isAssumed(see.getFalsified())) {
+      coreStatements.push_back(origins[see.getFalsified()]);
+    }
+    TRACE(INFO, ">>> generateCTC: Infeasible by " << coreStatements.size()
+                << " assume statement(s) alone");
+    return;
+  }
+  vector<Expr *> assumed;
+  vector<size_t> assumedOrigins;
+  for (size_t i = 0; i < pathConstraints.size(); i++) {
+    if (isAssumed(i)) {
+      assumed.push_back(pathConstraints[i]);
+      assumedOrigins.push_back(origins[i]);
+    }
+  }
+  for (size_t index : solver.unsatCore(assumed)) {
+    coreStatements.push_back(assumedOrigins[index]);
+  }
+  sort(coreStatements.begin(), coreStatements.end());
+  coreStatements.erase(unique(coreStatements.begin(), coreStatements.end()),
+                       coreStatements.end());
+  TRACE(INFO, ">>> generateCTC: Infeasible by " << coreStatements.size()
+              << " assume statement(s) alone");
+}
+
+vector<Expr *> Tester::handleUnknown(SolverStatus status,
+                                     const vector<unsigned int> &inputs) {
+  TRACE(INFO, ">>> generateCTC: " << statusName(status)
+              << " - The solver gave up on the path constraint");
+  switch (unknownPolicy) {
+  case UnknownPolicy::RETRY: {
+    Result retried =
+        retrySolver != nullptr
+            ? retrySolver->solve(see.computePathConstraint())
+            : solver.retry(pathConstraints, retryTactic);
+    if (retried.isDecided()) {
+      return extractConcreteValues(
+          toTypedModel(retried, inputs, *exprFactory), inputs);
+    }
+    TRACE(INFO, ">>> generateCTC: Retry is " << statusName(retried.status)
+                << " too, cannot continue");
+    return vector<Expr *>();
+  }
+  case UnknownPolicy::FALLBACK: {
+    // The next iteration pins the values, so an infeasible guess ends the
+    // generation there
+    TRACE(INFO, ">>> generateCTC: Falling back to " << fallbackValue
+                << " for " << inputs.size() << " input(s)");
+    vector<Expr *> values;
+    for (size_t i = 0; i < inputs.size(); i++) {
+      values.push_back(exprFactory->num(fallbackValue));
+    }
+    return values;
+  }
+  case UnknownPolicy::SKIP:
+  default:
+    return vector<Expr *>();
+  }
 }
 
 // Generate Abstract Test Case from specification
@@ -150,7 +439,7 @@ unique_ptr<Program> Tester::rewriteATC(unique_ptr<Program> &atc,
         FuncCall *fc = dynamic_cast<FuncCall *>(assign->right.get());
 
         // If it's input() and we have concrete values, replace it
-        if (fc && fc->name == "input" && fc->args.size() == 0) {
+        if (fc && fc->op == Opcode::INPUT && fc->args.size() == 0) {
           if (concreteValIndex < ConcreteVals.size()) {
             // Create new assignment: x := concreteValue
             Var *leftVarPtr = dynamic_cast<Var *>(assign->left.get());
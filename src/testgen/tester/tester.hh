@@ -1,29 +1,139 @@
 #ifndef TESTER_HH
 #define TESTER_HH
 
+#include <functional>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "../language/ast.hh"
 #include "../language/env.hh"
+#include "../see/functionfactory.hh"
+#include "../see/searcher.hh"
 #include "../see/see.hh"
 #include "../see/z3solver.hh"
 using namespace std;
+
+// An input statement, x := input()
+bool isInputStmt(const Stmt& stmt);
+
+// What generateCTC does when the solver gives up (UNKNOWN or TIMEOUT) on a
+// path constraint
+enum class UnknownPolicy {
+    SKIP,     // stop and return the test case rewritten so far, as on UNSAT
+    RETRY,    // solve once more, without slicing, with the retry tactic or
+              // the retry solver
+    FALLBACK  // give the pending inputs the fallback value and go on
+};
+
+// What one Tester::explorePaths did, to compare search strategies
+struct ExplorationStats {
+    string searcher;
+    size_t paths = 0;       // paths run
+    size_t tests = 0;       // paths that gave a CTC
+    size_t maxFrontier = 0; // most states pending at once
+    double seconds = 0;
+    double statesPerSecond = 0;
+    double firstTestSeconds = -1; // time to the first CTC, -1 if none
+};
+
+struct Exploration {
+    vector<unique_ptr<Program>> ctcs; // in the order they were found
+    ExplorationStats stats;
+};
+
 class Tester {
     private:
+        // Shared by SEE and the solver, so that the conjuncts SEE builds are
+        // the solver session's keys as they are
+        shared_ptr<ExprFactory> exprFactory;
         SEE see;
         Z3Solver solver;
         vector<Expr*> pathConstraints;
+        UnknownPolicy unknownPolicy;
+        string retryTactic;
+        const Solver* retrySolver;
+        int fallbackValue;
+        vector<size_t> coreStatements;
+        bool exploring; // explorePaths runs the forks itself
         
         unique_ptr<Program> generateATC(unique_ptr<Spec>, vector<string>);
+        // One genCTC iteration; recurses until the program is concrete.
+        unique_ptr<Program> generateCTCStep(unique_ptr<Program>, vector<Expr*> ConcreteVals, ValueEnvironment* ve);
+        // Values of the inputs in a SAT model, in program order, up to the
+        // first one without a value; empty if not SAT
+        vector<Expr*> extractConcreteValues(const TypedModel&, const vector<unsigned int>& inputs);
+        // Takes SEE's path constraint and solves it for the inputs; UNSAT
+        // without a query if a conjunct folded to false
+        TypedModel solvePathConstraint(const vector<unsigned int>& inputs);
+        // Fills coreStatements after an UNSAT path constraint of the program
+        void findCoreStatements(const Program&);
+        // Continues SEE on the oldest pending fork it can still go on from,
+        // dropping the ones the application has moved past. False if none.
+        bool exploreFork(Program&, SymbolTable&);
+        // Values of the inputs after the solver gave up, per unknownPolicy
+        vector<Expr*> handleUnknown(SolverStatus, const vector<unsigned int>& inputs);
+        // Up to numModels distinct values of the inputs the first path
+        // constraint of the ATC needs, in program order
+        vector<vector<unique_ptr<Expr>>> enumerateInputValues(unique_ptr<Program>& atc, size_t numModels);
     public:
-        Tester(FunctionFactory* functionFactory) : see(functionFactory), solver(), pathConstraints() {}
+        Tester(FunctionFactory* functionFactory)
+            : exprFactory(make_shared<ExprFactory>()),
+              see(functionFactory, exprFactory), solver(), pathConstraints(),
+              unknownPolicy(UnknownPolicy::SKIP), retryTactic("default"),
+              retrySolver(nullptr), fallbackValue(0), exploring(false) {
+            solver.setExprFactory(exprFactory);
+            // Most path constraints are a few bounds on the inputs
+            solver.setFastPath(true);
+        }
         void generateTest();
+        // Run the API calls of later generations against another
+        // implementation, e.g. a fresh one per job of a batch
+        void setFunctionFactory(FunctionFactory* functionFactory) {
+            see.setFunctionFactory(functionFactory);
+        }
+        void setUnknownPolicy(UnknownPolicy policy) { unknownPolicy = policy; }
+        // Z3 tactic of UnknownPolicy::RETRY
+        void setRetryTactic(const string& tactic) { retryTactic = tactic; }
+        // Solver of UnknownPolicy::RETRY in place of the retry tactic, e.g.
+        // a PortfolioSolver shared by several testers; nullptr for none
+        void setRetrySolver(const Solver* s) { retrySolver = s; }
+        // Input value of UnknownPolicy::FALLBACK
+        void setFallbackValue(int value) { fallbackValue = value; }
+        // Split paths at disjunctive assumptions, and go on with another
+        // disjunct when the path of the first one is infeasible
+        void setForking(bool on) { see.setForking(on); }
+        // Assignments of the next ATCs that hold values chosen for inputs
+        // before, which no unsat core may rest on (see
+        // SEE::setChosenStatements)
+        void setChosenStatements(set<size_t> statements) { see.setChosenStatements(std::move(statements)); }
         
         // Public methods for testing
+        // All iterations of one CTC generation share a single incremental
+        // solver session.
         unique_ptr<Program> generateCTC(unique_ptr<Program>, vector<Expr*> ConcreteVals, ValueEnvironment* ve);
+        // Up to numModels CTCs of one ATC that differ in the inputs of its
+        // first path constraint. Its models are enumerated in one solver
+        // session; then each CTC is generated from one of them, as
+        // generateCTC does, against the same FunctionFactory. One CTC if
+        // the first path constraint is not SAT.
+        vector<unique_ptr<Program>> generateCTCs(unique_ptr<Program>, size_t numModels, ValueEnvironment* ve);
         unique_ptr<Program> rewriteATC(unique_ptr<Program>&, vector<Expr*> ConcreteVals);
+        // Assume statements of the last generateCTC's ATC whose conditions
+        // contradict each other whatever the inputs (an unsat core), in
+        // program order. Empty if no path constraint was UNSAT, or if it
+        // only was with the values chosen for earlier inputs.
+        const vector<size_t>& getUnsatCoreStatements() const { return coreStatements; }
+        // Generates a CTC for each path of the ATC through its disjunctive
+        // assumptions, taking the pending paths in the searcher's order,
+        // until none is left or the time budget (ms, 0 for none) is spent.
+        // The application cannot be forked with the symbolic state, so
+        // each path is replayed from the start, with its decisions, on a
+        // fresh application.
+        Exploration explorePaths(unique_ptr<Program> atc, Searcher& searcher,
+                                 function<unique_ptr<FunctionFactory>()> makeApplication,
+                                 size_t budgetMs, ValueEnvironment* ve);
         
         // Getters for testing
         SEE& getSEE() { return see; }
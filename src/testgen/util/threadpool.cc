@@ -0,0 +1,81 @@
+#include "threadpool.hh"
+#include <exception>
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(size_t n) : numWorkers(n) {
+  if (numWorkers == 0) {
+    numWorkers = thread::hardware_concurrency();
+  }
+  if (numWorkers == 0) {
+    numWorkers = 1;
+  }
+  for (size_t i = 0; i < numWorkers; i++) {
+    queues.push_back(make_unique<WorkQueue>());
+  }
+}
+
+bool WorkStealingPool::takeOwn(size_t worker, size_t &job) {
+  WorkQueue &queue = *queues[worker];
+  lock_guard<mutex> guard(queue.lock);
+  if (queue.jobs.empty()) {
+    return false;
+  }
+  job = queue.jobs.back();
+  queue.jobs.pop_back();
+  return true;
+}
+
+bool WorkStealingPool::steal(size_t worker, size_t &job) {
+  for (size_t i = 1; i < numWorkers; i++) {
+    WorkQueue &victim = *queues[(worker + i) % numWorkers];
+    lock_guard<mutex> guard(victim.lock);
+    if (!victim.jobs.empty()) {
+      job = victim.jobs.front();
+      victim.jobs.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingPool::work(size_t worker,
+                            const function<void(size_t, size_t)> &task,
+                            vector<exception_ptr> &errors) {
+  // No jobs are added while the batch runs, so once every deque is empty
+  // the worker is done
+  size_t job;
+  while (takeOwn(worker, job) || steal(worker, job)) {
+    try {
+      task(job, worker);
+    } catch (...) {
+      errors[job] = current_exception();
+    }
+  }
+}
+
+void WorkStealingPool::run(size_t numJobs,
+                           const function<void(size_t, size_t)> &task) {
+  // Each worker pops its own deque from the back, so push in reverse to
+  // have it start with its lowest job
+  for (size_t job = numJobs; job-- > 0;) {
+    queues[job % numWorkers]->jobs.push_back(job);
+  }
+
+  vector<exception_ptr> errors(numJobs);
+  vector<thread> threads;
+  for (size_t worker = 1; worker < numWorkers; worker++) {
+    threads.emplace_back(&WorkStealingPool::work, this, worker, cref(task),
+                         ref(errors));
+  }
+  // The calling thread is worker 0
+  work(0, task, errors);
+  for (thread &t : threads) {
+    t.join();
+  }
+
+  for (const exception_ptr &error : errors) {
+    if (error) {
+      rethrow_exception(error);
+    }
+  }
+}
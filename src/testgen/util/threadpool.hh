@@ -0,0 +1,45 @@
+#ifndef THREADPOOL_HH
+#define THREADPOOL_HH
+
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+// Work-stealing pool for a batch of independent jobs. Each worker owns a
+// deque of job indices: it takes jobs from the back of its own deque and,
+// when that runs dry, steals from the front of the others. Jobs are dealt
+// out round-robin up front, so a worker that draws cheap jobs ends up
+// helping the ones that drew expensive jobs.
+class WorkStealingPool {
+    private:
+        struct WorkQueue {
+            mutex lock;
+            deque<size_t> jobs;
+        };
+
+        size_t numWorkers;
+        vector<unique_ptr<WorkQueue>> queues;
+
+        bool takeOwn(size_t worker, size_t& job);
+        bool steal(size_t worker, size_t& job);
+        void work(size_t worker,
+                  const function<void(size_t, size_t)>& task,
+                  vector<exception_ptr>& errors);
+    public:
+        // 0 workers: one per hardware thread
+        WorkStealingPool(size_t numWorkers = 0);
+        size_t getNumWorkers() const { return numWorkers; }
+
+        // Calls task(job, worker) once for every job in [0, numJobs) and
+        // returns when all have finished. A worker runs one job at a time,
+        // so state indexed by the worker needs no locking. If jobs throw,
+        // the exception of the lowest job index is rethrown.
+        void run(size_t numJobs, const function<void(size_t, size_t)>& task);
+};
+#endif
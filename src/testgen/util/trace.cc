@@ -0,0 +1,93 @@
+#include "trace.hh"
+#include <iostream>
+#include <stdexcept>
+
+// ============================================================================
+// Sinks
+// ============================================================================
+
+void StdoutSink::write(const string &line) { cout << line << '\n'; }
+
+void StdoutSink::flush() { cout.flush(); }
+
+FileSink::FileSink(const string &path) : buffer(BUFFER_SIZE) {
+  // The buffer must be installed before the file is opened
+  file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+  file.open(path, ios::out | ios::app);
+  if (!file) {
+    throw runtime_error("Cannot open trace file: " + path);
+  }
+}
+
+void FileSink::write(const string &line) { file << line << '\n'; }
+
+void FileSink::flush() { file.flush(); }
+
+RingBufferSink::RingBufferSink(size_t capacity)
+    : lines(capacity), capacity(capacity), next(0), written(0) {}
+
+void RingBufferSink::write(const string &line) {
+  if (capacity == 0) {
+    return;
+  }
+  lines[next] = line;
+  next = (next + 1) % capacity;
+  written++;
+}
+
+vector<string> RingBufferSink::getLines() const {
+  vector<string> result;
+  size_t count = written < capacity ? written : capacity;
+  size_t first = written < capacity ? 0 : next;
+  for (size_t i = 0; i < count; i++) {
+    result.push_back(lines[(first + i) % capacity]);
+  }
+  return result;
+}
+
+// ============================================================================
+// Trace
+// ============================================================================
+
+TraceLevel Trace::level = TraceLevel::INFO;
+unique_ptr<TraceSink> Trace::sink = make_unique<StdoutSink>();
+mutex Trace::sinkLock;
+
+unique_ptr<TraceSink> Trace::setSink(unique_ptr<TraceSink> s) {
+  lock_guard<mutex> guard(sinkLock);
+  if (sink) {
+    sink->flush();
+  }
+  unique_ptr<TraceSink> previous = std::move(sink);
+  sink = std::move(s);
+  return previous;
+}
+
+void Trace::write(TraceLevel l, const string &message) {
+  if (isEnabled(l)) {
+    lock_guard<mutex> guard(sinkLock);
+    sink->write(message);
+  }
+}
+
+void Trace::flush() {
+  lock_guard<mutex> guard(sinkLock);
+  if (sink) {
+    sink->flush();
+  }
+}
+
+bool Trace::parseLevel(const string &name, TraceLevel &result) {
+  if (name == "off") {
+    result = TraceLevel::OFF;
+  } else if (name == "error") {
+    result = TraceLevel::ERROR;
+  } else if (name == "info") {
+    result = TraceLevel::INFO;
+  } else if (name == "debug") {
+    result = TraceLevel::DEBUG;
+  } else {
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,124 @@
+#ifndef TRACE_HH
+#define TRACE_HH
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Trace levels, from least to most verbose
+enum class TraceLevel {
+    OFF = 0,
+    ERROR = 1, // failures that are reported and rethrown
+    INFO = 2,  // one line per engine step: interruptions, solver calls
+    DEBUG = 3, // every statement and every evaluated subexpression
+};
+
+// Compile-time ceiling. TRACE statements above it are removed by the
+// compiler, e.g. build with CCFLAGS="-g -DTRACE_MAX_LEVEL=1" to keep errors
+// only.
+#ifndef TRACE_MAX_LEVEL
+#define TRACE_MAX_LEVEL 3
+#endif
+
+// Whether the level is enabled both at compile time and at run time. Guards
+// what is gathered only to be traced, e.g. over several TRACE statements.
+#define TRACE_ENABLED(level)                                                 \
+    (static_cast<int>(TraceLevel::level) <= TRACE_MAX_LEVEL &&               \
+     Trace::isEnabled(TraceLevel::level))
+
+// TRACE(level, message): message is a << chain, e.g.
+//     TRACE(DEBUG, "[EVAL] Num: " << exprToString(result));
+// It is only evaluated and formatted when the level is enabled. Anything
+// computed for the message alone belongs in the chain, not in a local
+// before it.
+#define TRACE(level, message)                                                \
+    do {                                                                     \
+        if (TRACE_ENABLED(level)) {                                          \
+            ostringstream traceMessage;                                      \
+            traceMessage << message;                                         \
+            Trace::write(TraceLevel::level, traceMessage.str());             \
+        }                                                                    \
+    } while (0)
+
+// ============================================================================
+// Sinks
+// ============================================================================
+
+class TraceSink {
+    public:
+        virtual ~TraceSink() = default;
+        virtual void write(const string& line) = 0;
+        virtual void flush() {}
+};
+
+// Standard output, without flushing after every line
+class StdoutSink : public TraceSink {
+    public:
+        void write(const string& line) override;
+        void flush() override;
+};
+
+// Appends to a file through a large buffer
+class FileSink : public TraceSink {
+    private:
+        ofstream file;
+        vector<char> buffer;
+    public:
+        static const size_t BUFFER_SIZE = 1 << 16;
+
+        FileSink(const string& path);
+        void write(const string& line) override;
+        void flush() override;
+};
+
+// Keeps the last lines in memory, e.g. to dump them after a failure
+class RingBufferSink : public TraceSink {
+    private:
+        vector<string> lines;
+        size_t capacity;
+        size_t next;    // slot the next line goes to
+        size_t written; // lines written so far
+    public:
+        RingBufferSink(size_t capacity);
+        void write(const string& line) override;
+        // Retained lines, oldest first
+        vector<string> getLines() const;
+        size_t getNumWritten() const { return written; }
+};
+
+// ============================================================================
+// Trace
+// ============================================================================
+
+// Process-wide trace configuration. Without a sink nothing is traced.
+// Lines written from several threads are serialized, but their order then
+// depends on scheduling. Configure the level and sink before starting
+// threads.
+class Trace {
+    private:
+        static TraceLevel level;
+        static unique_ptr<TraceSink> sink;
+        static mutex sinkLock;
+    public:
+        static bool isEnabled(TraceLevel l) {
+            return sink != nullptr && l != TraceLevel::OFF && l <= level;
+        }
+        static TraceLevel getLevel() { return level; }
+        static void setLevel(TraceLevel l) { level = l; }
+        // Installs a new sink and returns the previous one, flushed
+        static unique_ptr<TraceSink> setSink(unique_ptr<TraceSink> s);
+        static TraceSink* getSink() { return sink.get(); }
+
+        static void write(TraceLevel l, const string& message);
+        static void flush();
+
+        // "off", "error", "info" or "debug"
+        static bool parseLevel(const string& name, TraceLevel& result);
+};
+#endif